@@ -0,0 +1,138 @@
+/**
+ * @file config_cache_benchmark.cpp
+ * @brief Config startup time with and without the binary cache
+ *
+ * Generates a large configuration (a main file with many bindings plus a
+ * set of imported modules) in a private HOME and times ConfigParser::load()
+ * three ways: full parse with the cache disabled, a cache miss (full parse
+ * plus writing the cache) and a cache hit. The parser's diagnostic output
+ * is sent to /dev/null while timing.
+ *
+ * Usage: config_cache_benchmark [iterations] [binds] [imports]
+ */
+
+#include "pointblank/config/ConfigParser.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+using namespace pblank;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+const char* MODIFIERS[] = {"SUPER", "SUPER_SHIFT", "SUPER_CTRL", "ALT", "ALT_SHIFT"};
+
+void writeBinds(std::ofstream& out, size_t first, size_t count) {
+    out << "    binds: {\n";
+    for (size_t i = first; i < first + count; ++i) {
+        out << "        \"" << MODIFIERS[i % 5] << ", F" << i << "\": ";
+        if (i % 3 == 0) {
+            out << "exec: \"kitty --title term-" << i << "\"\n";
+        } else {
+            out << "\"workspace " << (i % 12) + 1 << "\"\n";
+        }
+    }
+    out << "    }\n";
+}
+
+std::filesystem::path generate(const std::filesystem::path& home, size_t binds, size_t imports) {
+    auto modules = home / ".config" / "pblank" / "extensions" / "user";
+    std::filesystem::create_directories(modules);
+
+    for (size_t m = 0; m < imports; ++m) {
+        std::ofstream out(modules / ("module" + std::to_string(m) + ".wmi"));
+        out << "module" << m << ": {\n}\n\n";
+        writeBinds(out, binds + m * 64, 64);
+        out << "    status_bar: {\n        height: " << 20 + m << "\n        font_family: \"Sans\"\n    }\n";
+    }
+
+    auto main = home / ".config" / "pblank" / "pointblank.wmi";
+    std::ofstream out(main);
+    out << "// generated by config_cache_benchmark\n";
+    for (size_t m = 0; m < imports; ++m) {
+        out << "#import module" << m << "\n";
+    }
+    out << "\npointblank: {\n";
+    out << "    performance: {\n        target_fps: 144\n        vsync: false\n        max_batch_size: 32\n    }\n";
+    out << "    borders: {\n        focused_color: \"#89B4FA\"\n        unfocused_color: \"#45475A\"\n        width: 2\n    }\n";
+    out << "    workspaces: {\n        infinite: false\n        max_workspaces: 12\n    }\n";
+    out << "    gaps: {\n        inner_gap: 8\n        outer_gap: 12\n    }\n";
+    writeBinds(out, 0, binds);
+    out << "    status_bar: {\n        enabled: true\n        shared_state: true\n    }\n";
+    out << "}\n";
+    return main;
+}
+
+double timeLoads(const std::filesystem::path& config, size_t iterations, bool cache,
+                 bool drop_cache, size_t& keybinds) {
+    double total = 0.0;
+    for (size_t i = 0; i < iterations; ++i) {
+        if (drop_cache) {
+            std::filesystem::remove(ConfigCache::getDefaultCachePath());
+        }
+        auto t0 = Clock::now();
+        ConfigParser parser(nullptr);
+        parser.setCacheEnabled(cache);
+        if (!parser.load(config)) {
+            std::fprintf(stdout, "load failed\n");
+            std::exit(1);
+        }
+        total += std::chrono::duration<double>(Clock::now() - t0).count();
+        keybinds = parser.getConfig().keybinds.size();
+    }
+    return total / iterations * 1e3;
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50;
+    size_t binds = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+    size_t imports = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 16;
+
+
+    char home_template[] = "/tmp/pb-config-bench-XXXXXX";
+    const char* home = mkdtemp(home_template);
+    if (!home) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    setenv("HOME", home, 1);
+    unsetenv("XDG_CACHE_HOME");
+
+    auto config = generate(home, binds, imports);
+    auto source_size = std::filesystem::file_size(config);
+
+
+    std::fflush(stderr);
+    if (!std::freopen("/dev/null", "w", stderr)) {
+        std::perror("freopen");
+        return 1;
+    }
+
+    size_t parsed_binds = 0, cached_binds = 0, ignored = 0;
+    double full = timeLoads(config, iterations, false, false, parsed_binds);
+    double miss = timeLoads(config, iterations, true, true, ignored);
+    double hit = timeLoads(config, iterations, true, false, cached_binds);
+    auto cache_size = std::filesystem::file_size(ConfigCache::getDefaultCachePath());
+
+    std::filesystem::remove_all(home);
+
+    if (parsed_binds != cached_binds) {
+        std::printf("cached config differs: %zu vs %zu keybinds\n", parsed_binds, cached_binds);
+        return 1;
+    }
+
+    std::printf("\nConfig cache benchmark (%zu iterations, %zu keybinds, %zu imports, %ju B main file)\n",
+                iterations, parsed_binds, imports, static_cast<uintmax_t>(source_size));
+    std::printf("  full parse, no cache   %9.3f ms\n", full);
+    std::printf("  cache miss (+ store)   %9.3f ms\n", miss);
+    std::printf("  cache hit              %9.3f ms   (%.1fx, %ju B cache)\n", hit, full / hit,
+                static_cast<uintmax_t>(cache_size));
+    return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file config_parse_benchmark.cpp
+ * @brief Config and layout DSL lexer/parser throughput
+ *
+ * Generates a large .wmi config (nested blocks, bindings, let expressions,
+ * escaped strings, arrays) and a large layout file, then reports MB/s for
+ * tokenizing alone and for tokenizing plus building the AST. Interpretation
+ * is not included. The parser's diagnostic output is sent to /dev/null.
+ *
+ * Usage: config_parse_benchmark [iterations] [scale]
+ */
+
+#include "pointblank/config/ConfigParser.hpp"
+#include "pointblank/config/LayoutConfigParser.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace pblank;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+volatile size_t sink;
+
+std::string makeConfig(size_t scale) {
+    std::string out = "#import theme\n#include colors\n\n";
+    out += "let gap = 4 * 2 + 1\nlet term = \"kitty --single-instance\"\n\n";
+    out += "pointblank: {\n";
+    for (size_t i = 0; i < scale; ++i) {
+        std::string n = std::to_string(i);
+        out += "    performance: {\n        target_fps: 144\n        vsync: false\n"
+               "        cpu_cores: \"0,1,2,3\"\n    }\n";
+        out += "    gaps: {\n        inner_gap: (gap + " + n + ") * 2\n        outer_gap: 12\n    }\n";
+        out += "    status_bar: {\n        workspace_icons: [\"1\", \"2\", \"web\", \"chat\", \"\\\"" + n + "\\\"\"]\n"
+               "        font_size: 11.5\n        enabled: !false\n    }\n";
+        out += "    binds: {\n";
+        for (size_t k = 0; k < 16; ++k) {
+            std::string key = std::to_string(i * 16 + k);
+            out += "        \"SUPER_SHIFT, F" + key + "\": ";
+            out += (k % 2) ? "exec: \"notify-send \\\"bind " + key + "\\\"\"\n"
+                           : "\"workspace " + std::to_string(k % 9 + 1) + "\"\n";
+        }
+        out += "    }\n";
+        out += "    if (gap > 3 && true) {\n        window_rules: { border_width: 2 }\n    }\n";
+    }
+    out += "}\n";
+    return out;
+}
+
+std::string makeLayout(size_t scale) {
+    std::string out = "#include layout \"common\"\n\nmain {\n";
+    out += "    let default_mode = \"bsp\";\n    let gap_size = 6 + 2;\n";
+    for (size_t i = 0; i < scale * 4; ++i) {
+        std::string n = std::to_string(i);
+        out += "    layout \"" + n + "-" + std::to_string(i + 2) + "\" -> master_stack { master_ratio = 0.6; gap_size = " + n + "; }\n";
+        out += "    section" + n + " {\n        let master_ratio = 0.55 + 0.01 * 2;\n"
+               "        let cycle_direction = \"forward\";\n        let wrap_cycle = !false;\n    }\n";
+    }
+    out += "}\n";
+    return out;
+}
+
+template<typename Fn>
+void bench(const char* label, const std::string& source, size_t iterations, Fn&& run) {
+    size_t work = 0;
+    auto t0 = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        work += run(source);
+    }
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    sink = work;
+    std::printf("  %-22s %8zu B   %8.1f MB/s   %8.3f ms/parse\n", label, source.size(),
+                source.size() * iterations / secs / 1e6, secs / iterations * 1e3);
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+    size_t scale = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 128;
+
+    const std::string config = makeConfig(scale);
+    const std::string layout = makeLayout(scale);
+
+
+    std::fflush(stderr);
+    if (!std::freopen("/dev/null", "w", stderr)) {
+        std::perror("freopen");
+        return 1;
+    }
+
+    std::printf("\nConfig parse benchmark (%zu iterations)\n", iterations);
+    bench("config: lex", config, iterations, [](const std::string& src) {
+        Lexer lexer(src);
+        return lexer.tokenize().size();
+    });
+    bench("config: lex + parse", config, iterations, [](const std::string& src) {
+        Lexer lexer(src);
+        Parser parser(lexer.tokenize());
+        auto ast = parser.parse();
+        return ast->blocks.size() + parser.getErrors().size();
+    });
+    bench("layout: lex", layout, iterations, [](const std::string& src) {
+        LayoutLexer lexer(src);
+        return lexer.tokenize().size();
+    });
+    bench("layout: lex + parse", layout, iterations, [](const std::string& src) {
+        LayoutLexer lexer(src);
+        LayoutParser parser(lexer.tokenize());
+        auto ast = parser.parse();
+        return ast->includes.size() + parser.getErrors().size();
+    });
+    return 0;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file ipc_load_benchmark.cpp
+ * @brief Load benchmark for the IPC reactor
+ *
+ * Opens a large number of concurrent connections against a private
+ * IPCServer instance, drives pipelined request rounds across them from a
+ * handful of worker threads, and samples round-trip latency from a probe
+ * client both idle and under load.
+ *
+ * Usage: ipc_load_benchmark [clients] [rounds] [threads]
+ */
+
+#include "pointblank/ipc/IPCServer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr const char* REQUEST = "layout\n";
+constexpr size_t REQUEST_LEN = 7;
+
+int connectTo(const std::string& path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool sendAll(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool readLines(int fd, size_t lines) {
+    char buffer[4096];
+    while (lines > 0) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            return false;
+        }
+        lines -= std::count(buffer, buffer + n, '\n');
+    }
+    return true;
+}
+
+struct LatencyStats {
+    double p50_us = 0;
+    double p99_us = 0;
+    double max_us = 0;
+};
+
+LatencyStats probe(const std::string& path, size_t samples) {
+    LatencyStats stats;
+    int fd = connectTo(path);
+    if (fd < 0) {
+        return stats;
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(samples);
+
+    for (size_t i = 0; i < samples; ++i) {
+        auto t0 = Clock::now();
+        if (!sendAll(fd, REQUEST, REQUEST_LEN) || !readLines(fd, 1)) {
+            break;
+        }
+        latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+    }
+    close(fd);
+
+    if (latencies.empty()) {
+        return stats;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    stats.p50_us = latencies[latencies.size() / 2];
+    stats.p99_us = latencies[latencies.size() * 99 / 100];
+    stats.max_us = latencies.back();
+    return stats;
+}
+
+void printLatency(const char* label, const LatencyStats& s) {
+    std::printf("  %-22s p50 %8.1f us   p99 %8.1f us   max %8.1f us\n",
+                label, s.p50_us, s.p99_us, s.max_us);
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t num_clients = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    size_t rounds = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 50;
+    size_t num_threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10)
+                                  : std::max(2u, std::thread::hardware_concurrency() / 2);
+
+
+    rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0) {
+        lim.rlim_cur = lim.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &lim);
+        if (lim.rlim_cur < 2 * num_clients + 64) {
+            num_clients = (lim.rlim_cur - 64) / 2;
+        }
+    }
+
+
+    char home_template[] = "/tmp/pb-ipc-bench-XXXXXX";
+    const char* home = mkdtemp(home_template);
+    if (!home) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    setenv("HOME", home, 1);
+    mkdir((std::string(home) + "/.config").c_str(), 0755);
+
+    pblank::IPCServer server(nullptr, 0);
+    if (!server.start()) {
+        return 1;
+    }
+    const std::string path = server.getSocketPath();
+
+    LatencyStats idle = probe(path, 20000);
+
+
+    std::vector<int> fds;
+    fds.reserve(num_clients);
+    for (size_t i = 0; i < num_clients; ++i) {
+        int fd = connectTo(path);
+        if (fd < 0) {
+            std::cerr << "connect failed after " << i << " clients: " << strerror(errno) << std::endl;
+            break;
+        }
+        fds.push_back(fd);
+    }
+    num_clients = fds.size();
+    num_threads = std::min(num_threads, std::max<size_t>(num_clients, 1));
+
+
+    std::atomic<size_t> completed{0};
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> workers;
+
+    auto start = Clock::now();
+    for (size_t t = 0; t < num_threads; ++t) {
+        workers.emplace_back([&, t]() {
+            for (size_t r = 0; r < rounds && !failed.load(); ++r) {
+                for (size_t i = t; i < fds.size(); i += num_threads) {
+                    if (!sendAll(fds[i], REQUEST, REQUEST_LEN)) {
+                        failed.store(true);
+                        return;
+                    }
+                }
+                for (size_t i = t; i < fds.size(); i += num_threads) {
+                    if (!readLines(fds[i], 1)) {
+                        failed.store(true);
+                        return;
+                    }
+                    completed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    LatencyStats loaded = probe(path, 5000);
+
+    for (auto& w : workers) {
+        w.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (int fd : fds) {
+        close(fd);
+    }
+    server.stop();
+    rmdir((std::string(home) + "/.config/pblank").c_str());
+    rmdir((std::string(home) + "/.config").c_str());
+    rmdir(home);
+
+    std::printf("\nIPC load benchmark\n");
+    std::printf("  clients               %zu\n", num_clients);
+    std::printf("  driver threads        %zu\n", num_threads);
+    std::printf("  requests completed    %zu%s\n", completed.load(), failed.load() ? " (aborted)" : "");
+    std::printf("  throughput            %.0f req/s\n", completed.load() / elapsed);
+    printLatency("round trip, idle", idle);
+    printLatency("round trip, loaded", loaded);
+
+    return failed.load() ? 1 : 0;
+}
@@ -0,0 +1,229 @@
+/**
+ * @file ipc_protocol_benchmark.cpp
+ * @brief Text vs binary IPC protocol throughput
+ *
+ * Publishes a synthetic state snapshot into a private IPCServer and issues
+ * the same window-info queries through the line protocol and through the
+ * negotiated binary framing, pipelined at a fixed depth. Client-side
+ * decoding is included: the text client splits the reply and extracts the
+ * geometry fields, the binary client copies out an IPCWindowRecord.
+ *
+ * Usage: ipc_protocol_benchmark [queries] [pipeline_depth] [windows]
+ */
+
+#include "pointblank/ipc/IPCServer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace pblank;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+int connectTo(const std::string& path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        std::perror("connect");
+        std::exit(1);
+    }
+    return fd;
+}
+
+void sendAll(int fd, const void* data, size_t len) {
+    const char* p = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            std::perror("send");
+            std::exit(1);
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+class Reader {
+public:
+    explicit Reader(int fd) : fd_(fd) {}
+
+    bool fill() {
+        if (pos_ > 0 && pos_ == buf_.size()) {
+            buf_.clear();
+            pos_ = 0;
+        }
+        char chunk[65536];
+        ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buf_.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    std::string_view line() {
+        size_t nl;
+        while ((nl = buf_.find('\n', pos_)) == std::string::npos) {
+            if (!fill()) std::exit(1);
+        }
+        std::string_view out(buf_.data() + pos_, nl - pos_);
+        pos_ = nl + 1;
+        return out;
+    }
+
+    std::string_view bytes(size_t n) {
+        while (buf_.size() - pos_ < n) {
+            if (!fill()) std::exit(1);
+        }
+        std::string_view out(buf_.data() + pos_, n);
+        pos_ += n;
+        return out;
+    }
+
+private:
+    int fd_;
+    std::string buf_;
+    size_t pos_ = 0;
+};
+
+long jsonInt(std::string_view json, std::string_view key) {
+    size_t at = json.find(key);
+    if (at == std::string_view::npos) return -1;
+    return std::strtol(json.data() + at + key.size(), nullptr, 10);
+}
+
+double runText(const std::string& path, const std::vector<Window>& ids, size_t queries, size_t depth) {
+    int fd = connectTo(path);
+    Reader reader(fd);
+    long checksum = 0;
+
+    auto t0 = Clock::now();
+    size_t sent = 0, received = 0;
+    std::string batch;
+    while (received < queries) {
+        batch.clear();
+        while (sent < queries && sent - received < depth) {
+            batch += "window " + std::to_string(ids[sent % ids.size()]) + "\n";
+            ++sent;
+        }
+        if (!batch.empty()) sendAll(fd, batch.data(), batch.size());
+
+        std::string_view reply = reader.line();
+        size_t bar = reply.find('|', 3);
+        std::string_view json = reply.substr(bar + 1);
+        checksum += jsonInt(json, "\"width\":") + jsonInt(json, "\"height\":");
+        ++received;
+    }
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    close(fd);
+    if (checksum == 0) std::cerr << "text: no geometry decoded" << std::endl;
+    return queries / secs;
+}
+
+double runBinary(const std::string& path, const std::vector<Window>& ids, size_t queries, size_t depth) {
+    int fd = connectTo(path);
+    Reader reader(fd);
+    const char hello[] = "protocol binary\n";
+    sendAll(fd, hello, sizeof(hello) - 1);
+    reader.line();
+
+    long checksum = 0;
+    auto t0 = Clock::now();
+    size_t sent = 0, received = 0;
+    std::vector<char> batch;
+    while (received < queries) {
+        batch.clear();
+        while (sent < queries && sent - received < depth) {
+            IPCFrameHeader header{};
+            header.length = sizeof(uint64_t);
+            header.request_id = static_cast<uint32_t>(sent);
+            header.opcode = static_cast<uint16_t>(IPCOpcode::GetWindow);
+            uint64_t id = ids[sent % ids.size()];
+            const char* h = reinterpret_cast<const char*>(&header);
+            batch.insert(batch.end(), h, h + sizeof(header));
+            const char* p = reinterpret_cast<const char*>(&id);
+            batch.insert(batch.end(), p, p + sizeof(id));
+            ++sent;
+        }
+        if (!batch.empty()) sendAll(fd, batch.data(), batch.size());
+
+        IPCFrameHeader header;
+        std::memcpy(&header, reader.bytes(sizeof(header)).data(), sizeof(header));
+        std::string_view payload = reader.bytes(header.length);
+        if (header.status == static_cast<uint16_t>(IPCStatus::Ok) && payload.size() == sizeof(IPCWindowRecord)) {
+            IPCWindowRecord record;
+            std::memcpy(&record, payload.data(), sizeof(record));
+            checksum += record.width + record.height;
+        }
+        ++received;
+    }
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    close(fd);
+    if (checksum == 0) std::cerr << "binary: no geometry decoded" << std::endl;
+    return queries / secs;
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t queries = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500000;
+    size_t depth = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+    size_t num_windows = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 64;
+
+
+    char home_template[] = "/tmp/pb-ipc-bench-XXXXXX";
+    const char* home = mkdtemp(home_template);
+    if (!home) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    setenv("HOME", home, 1);
+    mkdir((std::string(home) + "/.config").c_str(), 0755);
+
+    IPCServer server(nullptr, 0);
+    if (!server.start()) {
+        return 1;
+    }
+
+
+    auto state = std::make_shared<IPCStateSnapshot>();
+    std::vector<Window> ids;
+    for (size_t i = 0; i < num_windows; ++i) {
+        IPCWindowRecord record{};
+        record.window = 0x1000000 + i * 7;
+        record.x = static_cast<int32_t>(i * 10);
+        record.y = 24;
+        record.width = 800;
+        record.height = 600;
+        record.workspace = static_cast<int32_t>(i % 9) + 1;
+        std::snprintf(record.wm_class, sizeof(record.wm_class), "kitty");
+        std::snprintf(record.title, sizeof(record.title), "terminal %zu - ~/src/pointblank", i);
+        state->windows.push_back(record);
+        ids.push_back(record.window);
+    }
+    server.publishState(state);
+
+    double text = runText(server.getSocketPath(), ids, queries, depth);
+    double binary = runBinary(server.getSocketPath(), ids, queries, depth);
+
+    server.stop();
+    rmdir((std::string(home) + "/.config/pblank").c_str());
+    rmdir((std::string(home) + "/.config").c_str());
+    rmdir(home);
+
+    std::printf("\nIPC protocol benchmark (%zu window queries, pipeline depth %zu)\n", queries, depth);
+    std::printf("  text    %10.0f queries/s\n", text);
+    std::printf("  binary  %10.0f queries/s   (%.2fx)\n", binary, binary / text);
+    return 0;
+}
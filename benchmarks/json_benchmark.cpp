@@ -0,0 +1,120 @@
+/**
+ * @file json_benchmark.cpp
+ * @brief JSONReader / JSONWriter throughput
+ *
+ * Tokenizes representative IPC traffic (a single JSON-RPC request, a
+ * 64-request batch and a large workspaces reply) with JSONReader, and
+ * serializes a window-list reply with a reused JSONWriter. Reports MB/s
+ * and documents per second.
+ *
+ * Usage: json_benchmark [iterations]
+ */
+
+#include "pointblank/ipc/JSON.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace pblank;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+volatile size_t sink;
+
+std::string makeBatch(size_t requests) {
+    std::string out = "[";
+    for (size_t i = 0; i < requests; ++i) {
+        if (i) out += ",";
+        out += "{\"jsonrpc\":\"2.0\",\"method\":\"window\",\"params\":[\"" +
+               std::to_string(0x1000000 + i) + "\"],\"id\":" + std::to_string(i) + "}";
+    }
+    out += "]";
+    return out;
+}
+
+void writeWindows(JSONWriter& out, size_t windows) {
+    out.beginObject().key("windows").beginArray();
+    for (size_t i = 0; i < windows; ++i) {
+        out.beginObject()
+           .key("window_id").value(0x1000000 + i)
+           .key("title").value("terminal - ~/src/pointblank \"main\"")
+           .key("class").value("kitty")
+           .key("workspace").value(static_cast<int>(i % 9) + 1)
+           .key("x").value(static_cast<int>(i * 10))
+           .key("y").value(24)
+           .key("width").value(800)
+           .key("height").value(600)
+           .key("floating").value(false)
+           .key("fullscreen").value(false)
+           .endObject();
+    }
+    out.endArray().endObject();
+}
+
+void benchParse(const char* label, const std::string& doc, size_t iterations) {
+    size_t tokens = 0;
+    std::string scratch;
+
+    auto t0 = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        JSONReader reader(doc);
+        JSONReader::Token t;
+        while ((t = reader.next()) != JSONReader::Token::End) {
+            if (t == JSONReader::Token::Error) {
+                std::fprintf(stderr, "%s: parse error at %zu\n", label, reader.offset());
+                std::exit(1);
+            }
+            if (t == JSONReader::Token::String) {
+                tokens += reader.stringValue(scratch).size();
+            }
+            ++tokens;
+        }
+    }
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    sink = tokens;
+
+    std::printf("  parse %-18s %8zu B   %9.1f MB/s   %10.0f docs/s\n", label, doc.size(),
+                doc.size() * iterations / secs / 1e6, iterations / secs);
+}
+
+void benchWrite(const char* label, size_t windows, size_t iterations) {
+    JSONWriter writer;
+    size_t bytes = 0;
+
+    auto t0 = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        writer.clear();
+        writeWindows(writer, windows);
+        bytes += writer.view().size();
+    }
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    sink = bytes;
+
+    std::printf("  write %-18s %8zu B   %9.1f MB/s   %10.0f docs/s\n", label, bytes / iterations,
+                bytes / secs / 1e6, iterations / secs);
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+
+    const std::string single =
+        "{\"jsonrpc\": \"2.0\", \"method\": \"subscribe\", \"params\": [\"workspace\", \"focus\"], \"id\": 1}";
+    const std::string batch = makeBatch(64);
+
+    JSONWriter reply;
+    writeWindows(reply, 128);
+    const std::string windows = reply.str();
+
+    std::printf("\nJSON benchmark (%zu iterations)\n", iterations);
+    benchParse("single request", single, iterations);
+    benchParse("batch of 64", batch, iterations / 32);
+    benchParse("128 windows", windows, iterations / 64);
+    benchWrite("8 windows", 8, iterations);
+    benchWrite("128 windows", 128, iterations / 16);
+    return 0;
+}
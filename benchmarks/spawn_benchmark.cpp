@@ -0,0 +1,108 @@
+/**
+ * @file spawn_benchmark.cpp
+ * @brief Process launch latency: fork/exec vs posix_spawn vs launch helper
+ *
+ * Launches `/bin/sh -c /bin/true` repeatedly with the fork()-based path KeybindManager
+ * used to take (setsid, close fds 3-1023, /dev/null stdio, exec), with
+ * inline spawnProcess(), and through the pre-forked Launcher helper. The
+ * helper's children are not ours to reap, so its round trip is measured
+ * up to the pid coming back. Reports the time for the launch call to return and the
+ * full launch-to-reap round trip. The parent's heap is grown first so the
+ * page-table copy fork() pays is visible, as it is in a long-running WM.
+ *
+ * Usage: spawn_benchmark [iterations] [heap_mb]
+ */
+
+#include "pointblank/core/Launcher.hpp"
+#include "pointblank/utils/Spawn.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace pblank;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+pid_t forkLaunch(const std::string& command) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        setsid();
+        for (int fd = 3; fd < 1024; ++fd) {
+            close(fd);
+        }
+        int devnull = open("/dev/null", O_RDWR);
+        if (devnull != -1) {
+            dup2(devnull, STDIN_FILENO);
+            dup2(devnull, STDOUT_FILENO);
+            dup2(devnull, STDERR_FILENO);
+        }
+        execl("/bin/sh", "sh", "-c", command.c_str(), nullptr);
+        _exit(127);
+    }
+    return pid;
+}
+
+pid_t spawnLaunch(const std::string& command) {
+    return spawnShell(command);
+}
+
+pid_t helperLaunch(const std::string& command) {
+    return Launcher::spawn(command);
+}
+
+void bench(const char* label, pid_t (*launch)(const std::string&), size_t iterations, bool reap = true) {
+    const std::string command = "/bin/true";
+    double call_secs = 0.0;
+
+    auto t0 = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        auto c0 = Clock::now();
+        pid_t pid = launch(command);
+        call_secs += std::chrono::duration<double>(Clock::now() - c0).count();
+        if (pid == -1) {
+            std::perror(label);
+            std::exit(1);
+        }
+        if (reap) {
+            int status;
+            waitpid(pid, &status, 0);
+        }
+    }
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    std::printf("  %-12s call %8.1f us   round trip %8.1f us   %8.0f launches/s\n", label,
+                call_secs / iterations * 1e6, secs / iterations * 1e6, iterations / secs);
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    size_t heap_mb = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256;
+
+    // Forked before the heap grows, as main() does before the WM loads
+    if (!Launcher::start()) {
+        return 1;
+    }
+
+    // Touch every page so fork() has real page tables to copy
+    std::vector<char> heap(heap_mb << 20);
+    for (size_t i = 0; i < heap.size(); i += 4096) {
+        heap[i] = static_cast<char>(i);
+    }
+
+    std::printf("Launching '/bin/sh -c /bin/true' %zu times with a %zu MB resident heap\n", iterations, heap_mb);
+    bench("fork+exec", forkLaunch, iterations);
+    bench("posix_spawn", spawnLaunch, iterations);
+    bench("helper", helperLaunch, iterations, false);
+    Launcher::stop();
+    return 0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pblank {
+
+class Config;
+
+/**
+ * @brief Binary snapshot of an interpreted Config
+ *
+ * The cache file holds a fixed header, the list of source files that
+ * produced the snapshot (main config first, then every import, each with
+ * a content hash) and the serialized Config. It is mmap'd and decoded in
+ * one pass; any mismatch in magic, format version, Config layout, source
+ * hashes or payload checksum is a miss and the caller parses normally.
+ *
+ * Bump FORMAT_VERSION whenever a Config field is added, removed or
+ * reordered.
+ */
+class ConfigCache {
+public:
+    static constexpr uint32_t MAGIC = 0x43434250;      // "PBCC"
+    static constexpr uint32_t FORMAT_VERSION = 4;
+
+    /** @brief A file the cached Config was built from */
+    struct Source {
+        std::filesystem::path path;
+        uint64_t hash{0};
+        bool exists{false};
+    };
+
+    explicit ConfigCache(std::filesystem::path path = getDefaultCachePath());
+
+    /**
+     * @brief Decode the cache into @p out if it was built from @p main
+     *
+     * @p main must carry the hash of the config text just read; imports are
+     * re-read and re-hashed here. @p out is only written on a hit.
+     */
+    bool load(const Source& main, Config& out) const;
+
+    /** @brief Atomically replace the cache file (write + rename) */
+    bool store(const std::vector<Source>& sources, const Config& config) const;
+
+    const std::filesystem::path& getPath() const { return path_; }
+
+    /**
+     * @brief $XDG_CACHE_HOME/pblank/config.cache (or ~/.cache/...)
+     *
+     * Empty when no home directory can be found; load() and store() then
+     * always miss.
+     */
+    static std::filesystem::path getDefaultCachePath();
+
+    /** @brief Serialize @p config alone, without header or sources */
+    static std::string encode(const Config& config);
+
+    /** @brief Inverse of encode(); @p out is only written on success */
+    static bool decode(std::string_view payload, Config& out);
+
+    /** @brief 64-bit FNV-1a over @p data */
+    static uint64_t hash(std::string_view data);
+
+    /** @brief Describe @p path as it is on disk now */
+    static Source describe(const std::filesystem::path& path);
+
+private:
+    std::filesystem::path path_;
+};
+
+}
@@ -1,18 +1,26 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <string_view>
 #include <variant>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <functional>
 #include <optional>
 #include <filesystem>
+#include <span>
+#include <deque>
 
 #include <X11/Xlib.h>
 
 #include "ConfigParserV2.hpp"
+#include "ConfigCache.hpp"
+#include "ConfigVM.hpp"
+#include "pointblank/utils/Arena.hpp"
 
 namespace pblank {
 
@@ -20,35 +28,39 @@ class Toaster;
 
 /**
  * @brief AST Node types for .wmi files
+ *
+ * Nodes, names and string values live in the owning ConfigFile's arena:
+ * links are plain pointers, lists are spans, and the whole tree is freed
+ * with the ConfigFile.
  */
 namespace ast {
 
 struct IntLiteral { int value; };
 struct FloatLiteral { double value; };
-struct StringLiteral { std::string value; };
+struct StringLiteral { std::string_view value; };
 struct BoolLiteral { bool value; };
-struct Identifier { std::string name; };
+struct Identifier { std::string_view name; };
 
 struct BinaryOp {
     enum class Op { Add, Sub, Mul, Div, And, Or, Eq, Ne, Lt, Gt, Le, Ge };
     Op op;
-    std::unique_ptr<struct Expression> left;
-    std::unique_ptr<struct Expression> right;
+    struct Expression* left;
+    struct Expression* right;
 };
 
 struct UnaryOp {
     enum class Op { Not, Neg };
     Op op;
-    std::unique_ptr<struct Expression> operand;
+    struct Expression* operand;
 };
 
 struct MemberAccess {
-    std::unique_ptr<struct Expression> object;
-    std::string member;
+    struct Expression* object;
+    std::string_view member;
 };
 
 struct ArrayLiteral {
-    std::vector<std::unique_ptr<struct Expression>> elements;
+    std::span<struct Expression*> elements;
 };
 
 using ExpressionValue = std::variant<
@@ -68,28 +80,28 @@ struct Expression {
 };
 
 struct Assignment {
-    std::string name;
-    std::unique_ptr<Expression> value;
+    std::string_view name;
+    Expression* value;
 };
 
 struct VariableDeclaration {
-    std::string name;
-    std::unique_ptr<Expression> value;
+    std::string_view name;
+    Expression* value;
 };
 
 struct IfStatement {
-    std::unique_ptr<Expression> condition;
-    std::vector<std::unique_ptr<struct Statement>> then_branch;
-    std::vector<std::unique_ptr<struct Statement>> else_branch;
+    Expression* condition;
+    std::span<struct Statement*> then_branch;
+    std::span<struct Statement*> else_branch;
 };
 
 struct Block {
-    std::string name;
-    std::vector<std::unique_ptr<struct Statement>> statements;
+    std::string_view name;
+    std::span<struct Statement*> statements;
 };
 
 struct ExecDirective {
-    std::string command;
+    std::string_view command;
 };
 
 using StatementValue = std::variant<
@@ -110,11 +122,20 @@ struct ImportDirective {
 };
 
 struct ConfigFile {
-    std::vector<ImportDirective> imports;
-    std::vector<std::unique_ptr<Block>> blocks;  
-    std::unique_ptr<Block> root;  
+    Arena arena;    ///< Owns every node below; declared first so it is freed last
     
-    std::unordered_map<std::string, std::variant<int, double, std::string, bool>> variables;
+    std::vector<ImportDirective> imports;
+    std::vector<Block*> blocks;  
+    Block* root{nullptr};  
+};
+
+/** @brief A parsed import file; owns the source its AST's string_views point into */
+struct Module {
+    std::filesystem::path path;
+    uint64_t hash{0};
+    std::string source;
+    std::unique_ptr<ConfigFile> file;
+    std::vector<std::string> errors;
 };
 
 } 
@@ -138,30 +159,37 @@ enum class TokenType {
     EndOfFile, Invalid
 };
 
+/**
+ * @brief Lexed token; lexeme and string literal are views
+ *
+ * Lexemes point into the source buffer. String literals without escapes
+ * point there too; decoded ones point into the Lexer. Both must outlive
+ * the tokens.
+ */
 struct Token {
     TokenType type;
-    std::string lexeme;  
+    std::string_view lexeme;  
     int line;
     int column;
     
-    std::variant<std::monostate, int, double, std::string, bool> literal_value;
+    std::variant<std::monostate, int, double, std::string_view, bool> literal_value;
     
-    Token() : type(TokenType::Invalid), lexeme(""), line(0), column(0), literal_value(std::monostate{}) {}
+    Token() : type(TokenType::Invalid), line(0), column(0), literal_value(std::monostate{}) {}
     
-    Token(TokenType t, std::string lex, int l, int c) 
-        : type(t), lexeme(std::move(lex)), line(l), column(c), literal_value(std::monostate{}) {}
+    Token(TokenType t, std::string_view lex, int l, int c) 
+        : type(t), lexeme(lex), line(l), column(c), literal_value(std::monostate{}) {}
     
-    Token(TokenType t, std::string lex, int l, int c, const std::string& lit)
-        : type(t), lexeme(std::move(lex)), line(l), column(c), literal_value(lit) {}
+    Token(TokenType t, std::string_view lex, int l, int c, std::string_view lit)
+        : type(t), lexeme(lex), line(l), column(c), literal_value(lit) {}
     
-    Token(TokenType t, std::string lex, int l, int c, int lit)
-        : type(t), lexeme(std::move(lex)), line(l), column(c), literal_value(lit) {}
+    Token(TokenType t, std::string_view lex, int l, int c, int lit)
+        : type(t), lexeme(lex), line(l), column(c), literal_value(lit) {}
     
-    Token(TokenType t, std::string lex, int l, int c, double lit)
-        : type(t), lexeme(std::move(lex)), line(l), column(c), literal_value(lit) {}
+    Token(TokenType t, std::string_view lex, int l, int c, double lit)
+        : type(t), lexeme(lex), line(l), column(c), literal_value(lit) {}
     
-    Token(TokenType t, std::string lex, int l, int c, bool lit)
-        : type(t), lexeme(std::move(lex)), line(l), column(c), literal_value(lit) {}
+    Token(TokenType t, std::string_view lex, int l, int c, bool lit)
+        : type(t), lexeme(lex), line(l), column(c), literal_value(lit) {}
     
     std::string_view getLexemeView() const noexcept { return lexeme; }
     
@@ -170,17 +198,19 @@ struct Token {
 
 class Lexer {
 public:
-    explicit Lexer(std::string source);
+    /** @brief Tokenize @p source in place; the buffer must outlive the tokens */
+    explicit Lexer(std::string_view source);
     
     std::vector<Token> tokenize();
     const std::vector<std::string>& getErrors() const { return errors_; }
     
 private:
-    std::string source_;
+    std::string_view source_;
     size_t current_{0};
     int line_{1};
     int column_{1};
     std::vector<std::string> errors_;
+    std::deque<std::string> decoded_;   ///< String literals that contained escapes
     
     inline char peek() const;
     inline char peekNext() const;
@@ -211,7 +241,9 @@ private:
     size_t current_{0};
     std::vector<std::string> errors_;
     
-    std::unordered_map<std::string, std::variant<int, double, std::string, bool>> variables_;
+    Arena* arena_{nullptr};
+    std::vector<ast::Statement*> statement_stack_;      ///< Pending children of open blocks
+    std::vector<ast::Expression*> element_stack_;       ///< Pending array literal elements
     
     inline const Token& peek() const;
     inline const Token& previous() const;
@@ -221,22 +253,25 @@ private:
     inline bool match(std::initializer_list<TokenType> types);
     const Token& consume(TokenType type, const std::string& message);
     
+    template<typename T>
+    std::span<T*> takeFrom(std::vector<T*>& stack, size_t mark);
+    
     std::unique_ptr<ast::ConfigFile> configFile();
     std::vector<ast::ImportDirective> imports();
-    std::unique_ptr<ast::Block> block();
-    std::unique_ptr<ast::Statement> statement();
-    std::unique_ptr<ast::Statement> ifStatement();
-    std::unique_ptr<ast::Statement> assignment();
-    std::unique_ptr<ast::Statement> letStatement();
-    std::unique_ptr<ast::Expression> expression();
-    std::unique_ptr<ast::Expression> logicalOr();
-    std::unique_ptr<ast::Expression> logicalAnd();
-    std::unique_ptr<ast::Expression> equality();
-    std::unique_ptr<ast::Expression> comparison();
-    std::unique_ptr<ast::Expression> term();
-    std::unique_ptr<ast::Expression> factor();
-    std::unique_ptr<ast::Expression> unary();
-    std::unique_ptr<ast::Expression> primary();
+    ast::Block* block();
+    ast::Statement* statement();
+    ast::Statement* ifStatement();
+    ast::Statement* assignment();
+    ast::Statement* letStatement();
+    ast::Expression* expression();
+    ast::Expression* logicalOr();
+    ast::Expression* logicalAnd();
+    ast::Expression* equality();
+    ast::Expression* comparison();
+    ast::Expression* term();
+    ast::Expression* factor();
+    ast::Expression* unary();
+    ast::Expression* primary();
     
     void addError(const std::string& message);
     void synchronize();
@@ -249,6 +284,28 @@ public:
         std::optional<bool> blur;
         int border_width{2};              
         int gap_size{10};                 
+        
+        bool operator==(const WindowRules&) const = default;
+    };
+    
+    /**
+     * @brief One per-window rule compiled from `if (window.… == …)` inside window_rules
+     *
+     * Empty criteria match anything; unset outcomes leave the default alone.
+     * Conditions the indexed matcher cannot express are compiled to
+     * @c program instead, whose assignments are the outcomes.
+     */
+    struct WindowRule {
+        std::string window_class;             ///< Exact WM_CLASS class
+        std::string instance;                 ///< Exact WM_CLASS instance
+        std::string title;                    ///< Title glob (`*` and `?`)
+        std::optional<bool> floating;
+        std::optional<int> workspace;         ///< 1-based
+        std::optional<double> opacity;
+        std::optional<int> border_width;
+        bytecode::Program program;
+        
+        bool operator==(const WindowRule&) const = default;
     };
     
     struct Keybind {
@@ -256,6 +313,8 @@ public:
         std::string key;
         std::string action;
         std::optional<std::string> exec_command;
+        
+        bool operator==(const Keybind&) const = default;
     };
     
     struct DragConfig {
@@ -263,6 +322,8 @@ public:
         int threshold{5};
         int swap_threshold{20};
         bool visual_feedback{true};
+        
+        bool operator==(const DragConfig&) const = default;
     };
     
     struct BordersConfig {
@@ -270,18 +331,24 @@ public:
         std::string unfocused_color{"#45475A"};   
         std::string urgent_color{"#F38BA8"};      
         int width{2};                     
+        
+        bool operator==(const BordersConfig&) const = default;
     };
 
     struct MouseConfig {
         bool focus_follows_mouse{true};    
         bool mouse_warping{false};        
         double cursor_speed{1.0};         
+        
+        bool operator==(const MouseConfig&) const = default;
     };
 
     struct AnimationsConfig {
         bool enabled{true};               
         std::string curve{"ease-in-out"}; 
         int duration{200};                
+        
+        bool operator==(const AnimationsConfig&) const = default;
     };
 
     struct PerformanceConfig {
@@ -318,6 +385,8 @@ public:
         bool metrics_enabled{true};
         int metrics_interval_ms{1000};
         bool latency_tracking{true};
+        
+        bool operator==(const PerformanceConfig&) const = default;
     };
 
     struct ExtensionsConfig {
@@ -329,6 +398,8 @@ public:
         int init_timeout_ms{5000};
         int max_extensions{32};
         bool allow_event_blocking{true};
+        
+        bool operator==(const ExtensionsConfig&) const = default;
     };
     
     struct WorkspaceConfig {
@@ -342,6 +413,8 @@ public:
         bool per_monitor{false};        
         bool virtual_mapping{false};    
         std::unordered_map<int, int> workspace_to_monitor;  
+        
+        bool operator==(const WorkspaceConfig&) const = default;
     };
     
     struct StatusBarConfig {
@@ -364,8 +437,11 @@ public:
         bool show_window_title{true};
         bool workspace_clickable{true};  
         bool enabled{true};              
+        bool shared_state{false};        ///< Publish bar state in shared memory (pb_state.h)
         
         std::vector<std::string> workspace_icons;
+        
+        bool operator==(const StatusBarConfig&) const = default;
     };
     
     struct WindowsConfig {
@@ -379,6 +455,8 @@ public:
         int default_floating_width{800};     
         int default_floating_height{600};   
         bool center_floating_windows{true}; 
+        
+        bool operator==(const WindowsConfig&) const = default;
     };
     
     struct LayoutGapConfig {
@@ -389,20 +467,28 @@ public:
         int bottom_gap{-1};
         int left_gap{-1};
         int right_gap{-1};
+        
+        bool operator==(const LayoutGapConfig&) const = default;
     };
     
     struct AutostartConfig {
         std::vector<std::string> commands;  
+        bool xdg{false};                    ///< Also run ~/.config/autostart entries
+        
+        bool operator==(const AutostartConfig&) const = default;
     };
     
     struct LayoutConfig {
         std::string cycle_direction{"forward"};
         bool wrap_cycle{true};
+        
+        bool operator==(const LayoutConfig&) const = default;
     };
     
     bool focus_follows_mouse{false};
     bool monitor_focus_follows_mouse{false};  
     WindowRules window_rules;
+    std::vector<WindowRule> per_window_rules;
     std::vector<Keybind> keybinds;
     DragConfig drag;
     BordersConfig borders;
@@ -424,6 +510,8 @@ public:
     
     std::string config_version{"1.0"};
     bool is_v2_format{false};
+    
+    bool operator==(const Config&) const = default;
 };
 
 class ConfigParser {
@@ -434,9 +522,44 @@ public:
     
     bool loadFromString(const std::string& source);
     
+    /** @brief Source text of the built-in default config */
     static std::string getEmbeddedConfig();
     
-    const Config& getConfig() const { return config_; }
+    /**
+     * @brief Publish the built-in default config without parsing it
+     *
+     * getEmbeddedConfig() is interpreted at build time and compiled in as a
+     * serialized Config (see EmbeddedConfig.cpp); this only decodes it.
+     */
+    bool loadEmbeddedConfig();
+    
+    /** @brief Active config; owner thread only, valid until the next publish */
+    const Config& getConfig() const { return *current_; }
+    
+    /**
+     * @brief Active config for readers on any thread
+     *
+     * Lock-free. The snapshot stays intact for as long as the caller holds
+     * it; a reload publishes a new Config instead of writing into this one.
+     */
+    std::shared_ptr<const Config> snapshot() const { return active_.load(std::memory_order_acquire); }
+    
+    /**
+     * @brief Number of configs published so far
+     *
+     * Bumped after the new snapshot is visible, so a snapshot taken after
+     * reading generation N is at least that new.
+     */
+    uint64_t getGeneration() const { return generation_.load(std::memory_order_acquire); }
+    
+    /** @brief Publish a Config built elsewhere (e.g. validated off-thread) */
+    void setConfig(std::shared_ptr<const Config> config);
+    
+    /** @brief Every error reported so far, main-file ones as "Line N[, Col M]: ..." */
+    const std::vector<std::string>& getErrors() const { return errors_; }
+    
+    /** @brief Use the binary config cache in load() (on by default) */
+    void setCacheEnabled(bool enabled) { cache_enabled_ = enabled; }
     
     static std::filesystem::path getDefaultConfigPath();
     
@@ -445,17 +568,39 @@ public:
     
     VersionManager::Version detectConfigVersion(const std::string& source);
     
-    std::unordered_map<std::string, std::unique_ptr<ast::ConfigFile>> imported_modules_;
+    /** @brief Import closure of the current load(), by importKey(); null if not found */
+    std::unordered_map<std::string, std::shared_ptr<const ast::Module>> imported_modules_;
     
     bool interpret(const ast::ConfigFile& ast);
     void evaluateBlock(const ast::Block& block);
     void evaluateStatement(const ast::Statement& stmt);
     std::variant<int, double, std::string, bool, std::vector<std::string>> evaluateExpression(const ast::Expression& expr);
     
+    /**
+     * @brief Compile an `if` on window properties into per_window_rules
+     *
+     * Plain ==/&&/|| tests on class, instance and title become indexed
+     * criteria; anything else is compiled to bytecode.
+     * @return false if the condition does not test window properties
+     */
+    bool compileWindowRule(const ast::IfStatement& stmt);
+    bool collectRuleCriteria(const ast::Expression& expr, std::vector<Config::WindowRule>& alternatives);
+    
+    /** @brief Compile @p expr to bytecode (folding constants and variables) and run it */
     std::variant<int, double, std::string, bool, std::vector<std::string>> 
-    evaluateExpression(const ast::Expression& expr, Window window, Display* display);
-    
-    bool resolveImport(const ast::ImportDirective& import);
+    evaluateExpression(const ast::Expression& expr, const bytecode::WindowProperties& window);
+    
+    /**
+     * @brief Find and parse the transitive imports of @p imports
+     *
+     * Each level of the import graph is parsed in parallel. Modules are
+     * memoized process-wide by path, mtime, size and content hash, so a
+     * reload only re-parses the files that changed.
+     */
+    void parseImports(const std::vector<ast::ImportDirective>& imports);
+    
+    /** @brief Evaluate a parsed import after its own imports; each module once per load */
+    bool resolveImport(const ast::ImportDirective& import, std::unordered_set<std::string>& evaluated);
     std::optional<std::filesystem::path> findImportFile(const std::string& name, bool is_user);
     
     void reportError(const std::string& message);
@@ -464,11 +609,22 @@ public:
 private:
     
     Toaster* toaster_{nullptr};
-    Config config_;
+    Config config_;     ///< Built up by load()/interpret(); published on success
+    
+    std::shared_ptr<const Config> current_;
+    std::atomic<std::shared_ptr<const Config>> active_;
+    std::atomic<uint64_t> generation_{0};
+    
+    bool cache_enabled_{true};
+    std::vector<std::string> errors_;
+    std::vector<ConfigCache::Source> import_sources_;    ///< Imports read by the current load()
+    bytecode::VM vm_;
     
     std::unique_ptr<ConfigParserV2> v2_parser_;
     std::unique_ptr<astv2::ConfigFileV2> v2_config_;
     
+    void publish();
+    
     bool loadV1(const std::string& source);
     bool loadV2(const std::string& source);
     bool interpretV2(const astv2::ConfigFileV2& v2_config);
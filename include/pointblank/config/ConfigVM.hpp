@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace pblank {
+
+namespace ast {
+struct Expression;
+struct IfStatement;
+struct Statement;
+}
+
+/**
+ * @brief Register bytecode for .wmi expressions and window-rule `if` bodies
+ *
+ * The compiler folds every subexpression that does not read window
+ * properties, including `let` variables (which are fixed once interpreted),
+ * so load-time expressions reduce to a single load. What remains for
+ * per-window rules is a short straight-line program run by VM against the
+ * properties cached for the window.
+ */
+namespace bytecode {
+
+using ConfigValue = std::variant<int, double, std::string, bool, std::vector<std::string>>;
+using Variables = std::unordered_map<std::string, ConfigValue>;
+
+enum class Op : uint8_t {
+    LoadInt,        ///< r[dst] = imm
+    LoadDouble,     ///< r[dst] = numbers[imm]
+    LoadBool,       ///< r[dst] = imm != 0
+    LoadString,     ///< r[dst] = strings[imm]
+    LoadArray,      ///< r[dst] = arrays[imm]
+    LoadWindow,     ///< r[dst] = window property imm (WindowProperty)
+    Add, Sub, Mul, Div,
+    Eq, Ne, Lt, Gt, Le, Ge,
+    Glob,           ///< r[dst] = r[a] matches glob r[b] (window.title == "*pattern*")
+    Not,            ///< r[dst] = !truthy(r[a])
+    Neg,            ///< r[dst] = -r[a]
+    ToBool,         ///< r[dst] = truthy(r[a])
+    MakeArray,      ///< r[dst] = [r[a] .. r[a + b])
+    Jump,           ///< pc = imm
+    JumpIfFalse,    ///< if !truthy(r[a]) pc = imm
+    JumpIfTrue,     ///< if truthy(r[a]) pc = imm
+    Set,            ///< assign setting strings[imm] = r[a]
+    Return          ///< result = r[a]
+};
+
+enum class WindowProperty : int32_t { Class, Instance, Title, Workspace };
+
+struct Instruction {
+    Op op;
+    uint8_t dst{0};
+    uint8_t a{0};
+    uint8_t b{0};
+    int32_t imm{0};
+
+    bool operator==(const Instruction&) const = default;
+};
+
+/** @brief Compiled code plus its constant pools; plain data, cached with Config */
+struct Program {
+    std::vector<Instruction> code;
+    std::vector<double> numbers;
+    std::vector<std::string> strings;       ///< Interned: each distinct string once
+    std::vector<std::vector<std::string>> arrays;
+    uint8_t registers{0};
+
+    bool empty() const { return code.empty(); }
+    bool operator==(const Program&) const = default;
+};
+
+/** @brief Shell-style match of @p text against @p pattern (`*` and `?` only) */
+bool globMatch(std::string_view pattern, std::string_view text);
+
+/** @brief Window state visible to `window.<member>` */
+struct WindowProperties {
+    std::string_view window_class;
+    std::string_view instance;
+    std::string_view title;
+    int workspace{0};                       ///< 1-based, 0 if unknown
+};
+
+/**
+ * @brief Register value; strings and arrays point into the program or the VM
+ */
+struct Value {
+    enum class Type : uint8_t { Int, Double, Boolean, String, Array };
+
+    Type type{Type::Int};
+    union {
+        int i = 0;
+        double d;
+        bool b;
+        const std::vector<std::string>* array;
+    };
+    std::string_view s;
+
+    static Value ofInt(int v) { Value out; out.i = v; return out; }
+    static Value ofDouble(double v) { Value out; out.type = Type::Double; out.d = v; return out; }
+    static Value ofBool(bool v) { Value out; out.type = Type::Boolean; out.b = v; return out; }
+    static Value ofString(std::string_view v) { Value out; out.type = Type::String; out.s = v; return out; }
+    static Value ofArray(const std::vector<std::string>* v) {
+        Value out;
+        out.type = Type::Array;
+        out.array = v;
+        return out;
+    }
+
+    /** @brief Conditions accept bools and ints; anything else is false */
+    bool truthy() const {
+        return type == Type::Boolean ? b : type == Type::Int ? i != 0 : false;
+    }
+};
+
+/**
+ * @brief Executes Programs; reuses its registers and scratch between runs
+ */
+class VM {
+public:
+    Value run(const Program& program, const WindowProperties& window = {});
+
+    /** @brief Settings assigned by the last run, in execution order */
+    const std::vector<std::pair<std::string_view, Value>>& assignments() const { return assignments_; }
+
+    static ConfigValue toConfigValue(const Value& value);
+
+    /**
+     * @brief Binary operator semantics shared by the VM and constant folding
+     *
+     * Results that build a new string are stored in @p scratch.
+     */
+    static Value apply(Op op, const Value& left, const Value& right, std::deque<std::string>& scratch);
+
+private:
+    std::vector<Value> registers_;
+    std::deque<std::string> strings_;
+    std::deque<std::vector<std::string>> arrays_;
+    std::vector<std::pair<std::string_view, Value>> assignments_;
+};
+
+/**
+ * @brief Compiles AST expressions and window-rule `if` statements
+ *
+ * Identifiers are resolved against @p variables at compile time.
+ */
+class Compiler {
+public:
+    explicit Compiler(const Variables& variables) : variables_(variables) {}
+
+    std::optional<Program> compileExpression(const ast::Expression& expr);
+
+    /** @brief Compile an `if` whose bodies contain only assignments and nested ifs */
+    std::optional<Program> compileRule(const ast::IfStatement& stmt);
+
+    const std::string& error() const { return error_; }
+
+private:
+    struct Operand {
+        bool constant{true};
+        Value value;
+        uint8_t reg{0};
+    };
+
+    const Variables& variables_;
+    Program program_;
+    std::string error_;
+    uint8_t top_{0};
+
+    std::unordered_map<std::string, uint32_t> interned_;
+    std::deque<std::string> fold_scratch_;
+    std::deque<std::vector<std::string>> fold_arrays_;
+
+    void reset();
+    bool finish();
+
+    Operand expression(const ast::Expression& expr);
+    Operand constant(const ConfigValue& value);
+    Operand logical(const ast::Expression& left, const ast::Expression& right, bool is_and);
+    bool statement(const ast::Statement& stmt);
+    bool branch(const ast::IfStatement& stmt);
+
+    uint8_t allocate();
+    uint8_t materialize(const Operand& operand);
+    size_t emit(Op op, uint8_t dst, uint8_t a = 0, uint8_t b = 0, int32_t imm = 0);
+    uint32_t intern(std::string_view s);
+    void fail(const std::string& message);
+};
+
+}
+
+}
@@ -6,6 +6,8 @@
 #include <atomic>
 #include <mutex>
 #include <filesystem>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include <chrono>
 
@@ -15,6 +17,8 @@ constexpr const char* ERROR_LOG_DIR = "/tmp/pointblank/errors";
 
 namespace pblank {
 
+class Config;
+
 /**
  * @brief Validation result for configuration changes
  */
@@ -31,6 +35,9 @@ struct ValidationResult {
     };
     std::vector<ErrorLocation> error_locations;
     
+    /** @brief Fully interpreted config produced by a successful validation */
+    std::shared_ptr<const Config> config;
+    
     operator bool() const { return success; }
 };
 
@@ -43,7 +50,11 @@ struct ConfigChangeEvent {
 class ConfigWatcher {
 public:
     using ValidationCallback = std::function<ValidationResult(const std::filesystem::path&)>;
-    using ApplyCallback = std::function<bool(const std::filesystem::path&)>;
+    /**
+     * Runs on the watcher thread with the config the validation callback
+     * built; it should hand @p config to the main thread, not apply it.
+     */
+    using ApplyCallback = std::function<bool(const std::filesystem::path&, std::shared_ptr<const Config> config)>;
     using ErrorCallback = std::function<void(const ValidationResult&)>;
     using NotifyCallback = std::function<void(const std::string& message, const std::string& level)>;
     
@@ -79,6 +90,9 @@ public:
     
     ValidationResult reload(const std::filesystem::path& path);
     
+    /** @brief Queue @p path for reload on the watcher thread */
+    void requestReload(const std::filesystem::path& path) { debounceAndProcess(path); }
+    
     const std::filesystem::path& getLastGoodConfig() const { return last_good_config_; }
     
     void setSchemaFile(const std::filesystem::path& path) { schema_file_ = path; }
@@ -114,7 +128,7 @@ private:
     void processDebouncedChanges();
     
     ValidationResult validateConfig(const std::filesystem::path& path);
-    bool applyConfig(const std::filesystem::path& path);
+    bool applyConfig(const std::filesystem::path& path, std::shared_ptr<const Config> config);
     void reportErrors(const ValidationResult& result);
     void writeErrorLog(const ValidationResult& result, const std::filesystem::path& config_path);
     
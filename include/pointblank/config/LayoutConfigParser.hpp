@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <variant>
@@ -8,8 +9,13 @@
 #include <functional>
 #include <optional>
 #include <filesystem>
+#include <deque>
+#include <span>
+#include <string_view>
 #include <X11/Xlib.h>
 
+#include "pointblank/utils/Arena.hpp"
+
 namespace pblank {
 
 class BSPNode;
@@ -92,34 +98,37 @@ inline std::string cycleDirectionToString(LayoutCycleDirection dir) {
     return (dir == LayoutCycleDirection::Forward) ? "forward" : "backward";
 }
 
+/**
+ * @brief AST for layout files, allocated in the owning LayoutConfigFile's arena
+ */
 namespace layout_ast {
 
 struct IntLiteral { int value; };
 struct FloatLiteral { double value; };
-struct StringLiteral { std::string value; };
+struct StringLiteral { std::string_view value; };
 struct BoolLiteral { bool value; };
-struct Identifier { std::string name; };
+struct Identifier { std::string_view name; };
 
 struct BinaryOp {
     enum class Op { Add, Sub, Mul, Div, And, Or, Eq, Ne, Lt, Gt, Le, Ge };
     Op op;
-    std::unique_ptr<struct LayoutExpression> left;
-    std::unique_ptr<struct LayoutExpression> right;
+    struct LayoutExpression* left;
+    struct LayoutExpression* right;
 };
 
 struct UnaryOp {
     enum class Op { Not, Neg };
     Op op;
-    std::unique_ptr<struct LayoutExpression> operand;
+    struct LayoutExpression* operand;
 };
 
 struct MemberAccess {
-    std::unique_ptr<struct LayoutExpression> object;
-    std::string member;
+    struct LayoutExpression* object;
+    std::string_view member;
 };
 
 struct ArrayLiteral {
-    std::vector<std::unique_ptr<struct LayoutExpression>> elements;
+    std::span<struct LayoutExpression*> elements;
 };
 
 using LayoutExpressionValue = std::variant<
@@ -139,15 +148,16 @@ struct LayoutExpression {
 };
 
 struct LayoutAssignment {
-    std::string name;
-    std::unique_ptr<LayoutExpression> value;
+    std::string_view name;
+    LayoutExpression* value;
 };
 
 struct LayoutBlock {
-    std::string name;
-    std::vector<std::unique_ptr<struct LayoutStatement>> statements;
+    std::string_view name;
+    std::span<struct LayoutStatement*> statements;
 };
 
+/** @brief Copied into LayoutConfig::layout_rules, so it owns its strings */
 struct LayoutRule {
     std::string workspace_pattern;  
     LayoutMode mode;
@@ -156,8 +166,8 @@ struct LayoutRule {
 
 using LayoutStatementValue = std::variant<
     LayoutAssignment,
-    std::unique_ptr<LayoutBlock>,
-    LayoutRule
+    LayoutBlock*,
+    LayoutRule*
 >;
 
 struct LayoutStatement {
@@ -170,8 +180,10 @@ struct LayoutIncludeDirective {
 };
 
 struct LayoutConfigFile {
+    Arena arena;    ///< Owns every node below; declared first so it is freed last
+    
     std::vector<LayoutIncludeDirective> includes;
-    std::unique_ptr<LayoutBlock> root;
+    LayoutBlock* root{nullptr};
 };
 
 } 
@@ -195,13 +207,19 @@ enum class LayoutTokenType {
     EndOfFile, Invalid
 };
 
+/**
+ * @brief Lexed token; lexeme and string literal are views
+ *
+ * Lexemes point into the source buffer, decoded string literals into the
+ * LayoutLexer. Both must outlive the tokens.
+ */
 struct LayoutToken {
     LayoutTokenType type;
     std::string_view lexeme;  
     int line;
     int column;
     
-    std::variant<std::monostate, int, double, std::string, bool> literal_value;
+    std::variant<std::monostate, int, double, std::string_view, bool> literal_value;
     
     LayoutToken() : type(LayoutTokenType::Invalid), lexeme(""), line(0), column(0), 
                    literal_value(std::monostate{}) {}
@@ -210,7 +228,7 @@ struct LayoutToken {
         : type(t), lexeme(lex), line(l), column(c), 
           literal_value(std::monostate{}) {}
     
-    LayoutToken(LayoutTokenType t, std::string_view lex, int l, int c, const std::string& lit)
+    LayoutToken(LayoutTokenType t, std::string_view lex, int l, int c, std::string_view lit)
         : type(t), lexeme(lex), line(l), column(c), 
           literal_value(lit) {}
     
@@ -229,17 +247,19 @@ struct LayoutToken {
 
 class LayoutLexer {
 public:
-    explicit LayoutLexer(std::string source);
+    /** @brief Tokenize @p source in place; the buffer must outlive the tokens */
+    explicit LayoutLexer(std::string_view source);
     
     std::vector<LayoutToken> tokenize();
     const std::vector<std::string>& getErrors() const { return errors_; }
     
 private:
-    std::string source_;
+    std::string_view source_;
     size_t current_{0};
     int line_{1};
     int column_{1};
     std::vector<std::string> errors_;
+    std::deque<std::string> decoded_;   ///< String literals that contained escapes
     
     char peek() const;
     char peekNext() const;
@@ -271,6 +291,10 @@ private:
     size_t current_{0};
     std::vector<std::string> errors_;
     
+    Arena* arena_{nullptr};
+    std::vector<layout_ast::LayoutStatement*> statement_stack_;     ///< Pending children of open blocks
+    std::vector<layout_ast::LayoutExpression*> element_stack_;      ///< Pending array literal elements
+    
     const LayoutToken& peek() const;
     const LayoutToken& previous() const;
     bool isAtEnd() const;
@@ -279,21 +303,24 @@ private:
     bool match(std::initializer_list<LayoutTokenType> types);
     const LayoutToken& consume(LayoutTokenType type, const std::string& message);
     
+    template<typename T>
+    std::span<T*> takeFrom(std::vector<T*>& stack, size_t mark);
+    
     std::unique_ptr<layout_ast::LayoutConfigFile> configFile();
     std::vector<layout_ast::LayoutIncludeDirective> includes();
-    std::unique_ptr<layout_ast::LayoutBlock> block();
-    std::unique_ptr<layout_ast::LayoutStatement> statement();
-    std::unique_ptr<layout_ast::LayoutStatement> layoutRule();
-    std::unique_ptr<layout_ast::LayoutStatement> assignment();
-    std::unique_ptr<layout_ast::LayoutExpression> expression();
-    std::unique_ptr<layout_ast::LayoutExpression> logicalOr();
-    std::unique_ptr<layout_ast::LayoutExpression> logicalAnd();
-    std::unique_ptr<layout_ast::LayoutExpression> equality();
-    std::unique_ptr<layout_ast::LayoutExpression> comparison();
-    std::unique_ptr<layout_ast::LayoutExpression> term();
-    std::unique_ptr<layout_ast::LayoutExpression> factor();
-    std::unique_ptr<layout_ast::LayoutExpression> unary();
-    std::unique_ptr<layout_ast::LayoutExpression> primary();
+    layout_ast::LayoutBlock* block();
+    layout_ast::LayoutStatement* statement();
+    layout_ast::LayoutStatement* layoutRule();
+    layout_ast::LayoutStatement* assignment();
+    layout_ast::LayoutExpression* expression();
+    layout_ast::LayoutExpression* logicalOr();
+    layout_ast::LayoutExpression* logicalAnd();
+    layout_ast::LayoutExpression* equality();
+    layout_ast::LayoutExpression* comparison();
+    layout_ast::LayoutExpression* term();
+    layout_ast::LayoutExpression* factor();
+    layout_ast::LayoutExpression* unary();
+    layout_ast::LayoutExpression* primary();
     
     void addError(const std::string& message);
     void synchronize();
@@ -303,8 +330,6 @@ struct LayoutConfig {
     
     LayoutMode default_mode{LayoutMode::BSP};
     
-    std::unordered_map<int, LayoutMode> workspace_modes;
-    
     struct BSPParams {
         int gap_size{10};
         int border_width{2};
@@ -354,6 +379,50 @@ struct LayoutConfig {
     bool wrap_cycle{true};  
     
     std::vector<layout_ast::LayoutRule> layout_rules;
+    
+    /** @brief A layout rule's mode with its parameters applied over the global ones */
+    struct WorkspaceLayout {
+        LayoutMode mode{LayoutMode::BSP};
+        BSPParams bsp;
+        MasterStackParams master_stack;
+        CenteredMasterParams centered_master;
+        DynamicGridParams dynamic_grid;
+        DwindleSpiralParams dwindle_spiral;
+        TabbedStackedParams tabbed_stacked;
+    };
+    
+    /**
+     * @brief Workspace -> layout lookup compiled from layout_rules
+     *
+     * Explicit IDs ("3", "1,4,7") index a direct table; ranges ("5-9") and
+     * wildcards ("*", "all") are flattened into sorted, disjoint intervals,
+     * so a lookup is O(1) or O(log n) with no string handling. When rules
+     * overlap the later one wins.
+     */
+    class WorkspaceLayouts {
+    public:
+        void compile(const LayoutConfig& config);
+        
+        /** @brief Layout for 1-based @p workspace, or nullptr if no rule covers it */
+        const WorkspaceLayout* find(int workspace) const;
+        
+        bool empty() const { return layouts_.empty(); }
+        
+    private:
+        struct Interval {
+            int first;
+            int last;
+            int32_t layout;
+        };
+        
+        std::vector<WorkspaceLayout> layouts_;      ///< One per rule, in rule order
+        std::vector<int32_t> direct_;               ///< By workspace; -1 if none
+        std::vector<Interval> intervals_;           ///< Sorted by first
+        
+        void cover(int first, int last, int32_t layout);
+    };
+    
+    WorkspaceLayouts workspace_layouts;   ///< Rebuilt after every top-level loadLayout()
 };
 
 class LayoutConfigParser {
@@ -394,8 +463,6 @@ private:
     bool resolveInclude(const layout_ast::LayoutIncludeDirective& include);
     std::optional<std::filesystem::path> findLayoutFile(const std::string& name, bool is_user);
     
-    std::vector<int> parseWorkspacePattern(const std::string& pattern);
-    
     void reportError(const std::string& message);
     void reportErrors(const std::vector<std::string>& errors);
     
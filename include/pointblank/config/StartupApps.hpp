@@ -1,10 +1,16 @@
 #pragma once
 
+#include "pointblank/utils/Spawn.hpp"
 #include <X11/Xlib.h>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <future>
 #include <memory>
+#include <optional>
+#include <queue>
 #include <string>
 #include <vector>
-#include <functional>
 
 namespace pblank {
 
@@ -17,48 +23,102 @@ namespace pblank {
  * - Waiting for the window manager to fully initialize
  * - Launching on specific workspaces
  * - Autostart desktop file support (XDG autostart)
+ *
+ * Nothing here blocks the event loop: the autostart directory is scanned
+ * on a worker (unchanged .desktop files are answered from a cache keyed by
+ * mtime), and launches sit in a timer queue that poll() drains once per
+ * frame, starting from the first poll() after scheduleAll().
  */
 class StartupApps {
 public:
+    /**
+     * @brief Launch @p command for @p workspace; the pid or -1
+     *
+     * @p workspace is the 0-based internal index (config files number
+     * workspaces from 1), or -1 for whichever is current at launch.
+     */
+    using LaunchFn = std::function<pid_t(const std::string& command, int workspace)>;
+    
     StartupApps();
-    ~StartupApps() = default;
+    ~StartupApps();
     
     StartupApps(const StartupApps&) = delete;
     StartupApps& operator=(const StartupApps&) = delete;
     
     void loadFromConfig(const std::string& config_content);
     
+    /** @brief Start scanning the autostart dir; entries are added by poll() */
     void loadXDGAutostart();
     
-    void launchAll();
+    /** @brief Start the clock: every app becomes due delay_ms from now */
+    void scheduleAll();
+    
+    /** @brief Pick up a finished autostart scan and launch everything due */
+    void poll();
+    
+    /** @brief Whether poll() still has work (a scan or a launch outstanding) */
+    bool hasPending() const { return xdg_scan_.valid() || !timers_.empty(); }
     
     void addApp(const std::string& command, int delay_ms = 0, int workspace = -1);
     
-    void setLauncher(std::function<void(const std::string&)> launcher);
+    void setLauncher(LaunchFn launcher);
 
 private:
+    using Clock = std::chrono::steady_clock;
+    
     struct StartupApp {
         std::string command;
         int delay_ms;
-        int workspace;
+        int workspace;      ///< 0-based index, as execCommand takes it; -1 = current
         bool launched;
         
         StartupApp(const std::string& cmd, int delay, int ws)
             : command(cmd), delay_ms(delay), workspace(ws), launched(false) {}
     };
     
+    struct Timer {
+        Clock::time_point due;
+        size_t app;
+        
+        bool operator>(const Timer& other) const { return due > other.due; }
+    };
+    
     std::vector<StartupApp> apps_;
-    std::function<void(const std::string&)> launcher_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    std::optional<Clock::time_point> epoch_;        ///< Set by scheduleAll()
+    std::future<std::vector<std::string>> xdg_scan_;
+    LaunchFn launcher_;
     
-    std::string parseDesktopFile(const std::string& path) const;
+    void schedule(size_t app);
+    
+    /** @brief Launchable part of a .desktop file; empty command when not shown */
+    struct DesktopEntry {
+        std::string try_exec;
+        std::string command;
+    };
+    
+    /** @brief Worker body: Exec lines of every visible entry in @p dir */
+    static std::vector<std::string> scanAutostartDir(std::filesystem::path dir,
+                                                     std::filesystem::path cache_path,
+                                                     std::vector<std::string> desktops);
+    
+    static DesktopEntry parseDesktopFile(const std::string& path,
+                                         const std::vector<std::string>& desktops);
+    
+    /** @brief XDG_CURRENT_DESKTOP split on ':' */
+    static std::vector<std::string> getCurrentDesktops();
     
     std::string getAutostartDir() const;
+    
+    /** @brief Per-user cache file, or an empty path when there is no home to put it in */
+    static std::filesystem::path getCachePath();
 };
 
-inline StartupApps::StartupApps() = default;
+inline StartupApps::StartupApps()
+    : launcher_([](const std::string& command, int) { return spawnShell(command); }) {}
 
-inline void StartupApps::setLauncher(std::function<void(const std::string&)> launcher) {
+inline void StartupApps::setLauncher(LaunchFn launcher) {
     launcher_ = std::move(launcher);
 }
 
-} 
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "pointblank/utils/Spawn.hpp"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+
+namespace pblank {
+
+/**
+ * @brief Pre-forked helper that launches commands on the WM's behalf
+ *
+ * start() forks a small helper before the window manager loads Cairo,
+ * GLib or extensions. Launch requests go to it over a SOCK_SEQPACKET
+ * socketpair, one packet per request, and it answers with the child's
+ * pid, so spawning never touches the WM's address space and the pid can
+ * still be matched against windows as they map. Launched processes are
+ * children of the helper, which reaps them.
+ *
+ * If the helper was never started or has gone away, spawn() falls back
+ * to spawning inline.
+ */
+class Launcher {
+public:
+    /** @brief Fork the helper; false (and inline spawning) on failure */
+    static bool start();
+    
+    /** @brief Close the socket; the helper exits on EOF */
+    static void stop();
+    
+    static bool isRunning();
+    
+    /** @brief Launch `/bin/sh -c command`; the pid, or -1 with errno set */
+    static pid_t spawn(const std::string& command, const SpawnOptions& options = {});
+    
+private:
+    /** @brief Request header; the command follows in the same packet */
+    struct Request {
+        uint8_t new_session;
+        uint8_t null_stdio;
+    };
+    
+    struct Reply {
+        int32_t pid;
+        int32_t error;      ///< errno when pid is -1
+    };
+    
+    [[noreturn]] static void serve(int fd);
+    
+    static std::mutex mutex_;
+    static int fd_;
+    static pid_t helper_pid_;
+};
+
+} 
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 #include <functional>
@@ -15,10 +18,12 @@
 #include "pointblank/display/EWMHManager.hpp"
 #include "pointblank/display/MonitorManager.hpp"
 #include "pointblank/ipc/IPCServer.hpp"
+#include "pointblank/ipc/SharedState.hpp"
 #include "pointblank/window/ScratchpadManager.hpp"
 #include "pointblank/performance/RenderPipeline.hpp"
 #include "pointblank/performance/PerformanceTuner.hpp"
 #include "pointblank/window/WindowSwallower.hpp"
+#include "pointblank/utils/Spawn.hpp"
 
 namespace pblank {
 
@@ -52,12 +57,15 @@ using DisplayPtr = std::unique_ptr<Display, DisplayDeleter>;
 using WindowPtr = std::unique_ptr<Window, WindowDeleter>;
 using GCPtr = std::unique_ptr<GC, GCDeleter>;
 
+class Config;
 class ConfigParser;
 class LayoutEngine;
 class Toaster;
 class KeybindManager;
+class WindowRuleMatcher;
 class LayoutConfigParser;
 class ConfigWatcher;
+class StartupApps;
 
 namespace ewmh {
     class EWMHManager;
@@ -77,9 +85,20 @@ public:
     std::string getClass() const;
     std::string getTitle() const;
     
+    /** @brief Re-read WM_CLASS and WM_NAME into the cached copies below */
+    void refreshProperties();
+    const std::string& getCachedClass() const { return cached_class_; }
+    const std::string& getCachedInstance() const { return cached_instance_; }
+    const std::string& getCachedTitle() const { return cached_title_; }
+    
     void setGeometry(int x, int y, unsigned int width, unsigned int height);
     void getGeometry(int& x, int& y, unsigned int& width, unsigned int& height) const;
     
+    /** @brief Record geometry reported by the server (ConfigureNotify) without moving the window */
+    void cacheGeometry(int x, int y, unsigned int width, unsigned int height) {
+        x_ = x; y_ = y; width_ = width; height_ = height;
+    }
+    
     bool isFloating() const { return floating_; }
     void setFloating(bool floating) { floating_ = floating; }
     
@@ -107,6 +126,10 @@ private:
     
     int tiled_x_{0}, tiled_y_{0};
     unsigned int tiled_width_{0}, tiled_height_{0};
+    
+    std::string cached_class_;
+    std::string cached_instance_;
+    std::string cached_title_;
 };
 
 class WindowManager {
@@ -159,9 +182,11 @@ public:
     
     void focusWindow(Window window);
 
-    void swapFocusedWindow(const std::string& direction);
+    /** @brief Swap @p count steps in @p direction, then lay out once */
+    void swapFocusedWindow(const std::string& direction, int count = 1);
 
-    void resizeFocusedWindow(const std::string& direction);
+    /** @brief Resize by @p count steps in @p direction, then lay out once */
+    void resizeFocusedWindow(const std::string& direction, int count = 1);
     
     void resizeFocusedWindow(double delta);
 
@@ -187,7 +212,16 @@ public:
     
     void toggleSplitDirection();
 
-    void execCommand(const std::string& command);
+    /**
+     * @brief Launch `/bin/sh -c command` through the launch helper
+     *
+     * The pid is remembered with @p workspace, a 0-based index (the
+     * current one if -1), so the first window it maps opens there, even
+     * if the user has switched away meanwhile.
+     * @return The child's pid, or -1
+     */
+    pid_t execCommand(const std::string& command, const SpawnOptions& options = {},
+                      int workspace = -1);
     
     void exit() { running_ = false; }
 
@@ -197,11 +231,20 @@ private:
     Window root_;
     int screen_;
 
+    // Reload results handed from the config watcher thread to the main loop.
+    // Declared before config_watcher_ so they outlive its thread.
+    std::mutex reload_mutex_;
+    std::shared_ptr<const Config> pending_config_;
+    std::vector<std::string> pending_config_errors_;
+    std::vector<std::pair<std::string, std::string>> pending_config_notices_;
+    std::atomic<bool> reload_pending_{false};
+
     std::unique_ptr<ConfigParser> config_parser_;
     std::unique_ptr<LayoutConfigParser> layout_config_parser_;
     std::unique_ptr<LayoutEngine> layout_engine_;
     std::unique_ptr<Toaster> toaster_;
     std::unique_ptr<KeybindManager> keybind_manager_;
+    std::unique_ptr<WindowRuleMatcher> window_rule_matcher_;
     std::unique_ptr<ConfigWatcher> config_watcher_;
     std::unique_ptr<MonitorManager> monitor_manager_;
     
@@ -210,12 +253,15 @@ private:
     std::unique_ptr<ScratchpadManager> scratchpad_manager_;
     
     std::unique_ptr<IPCServer> ipc_server_;
+    std::unique_ptr<SharedStateRegion> shared_state_;
     
     std::unique_ptr<RenderPipeline> render_pipeline_;
     std::unique_ptr<PerformanceTuner> performance_tuner_;
     
     std::unique_ptr<WindowSwallower> window_swallower_;
     
+    std::unique_ptr<StartupApps> startup_apps_;
+    
     std::optional<std::filesystem::path> custom_config_path_;
 
     std::unordered_map<Window, std::unique_ptr<ManagedWindow>> clients_;
@@ -253,6 +299,18 @@ private:
     
     std::vector<Window> workspace_last_focus_;
     
+    /** @brief Where a recently launched process was started from */
+    struct LaunchOrigin {
+        int workspace;
+        std::chrono::steady_clock::time_point when;
+    };
+    
+    /** @brief Launches whose first window has not mapped yet, by pid */
+    std::unordered_map<pid_t, LaunchOrigin> launch_origins_;
+    
+    /** @brief Origins older than this are forgotten (daemonizing apps never match) */
+    static constexpr std::chrono::seconds LAUNCH_ORIGIN_TTL{30};
+    
     std::set<Window> pending_unmaps_;
 
     bool dragging_{false};
@@ -291,10 +349,25 @@ private:
     int floating_resize_edge_size_{8};
     
     bool is_warping_{false};
+    
+    int ipc_last_workspace_{-1};
+    Window ipc_last_focus_{None};
+    bool ipc_state_dirty_{true};
+    JSONWriter ipc_json_;
+    std::shared_ptr<const IPCStateSnapshot> ipc_last_state_;
+    uint64_t ipc_generation_{0};
+    
+    // IPC transaction: layout, EWMH and bar updates requested while it is
+    // open are recorded here and performed once by commitTransaction().
+    bool in_transaction_{false};
+    uint32_t deferred_updates_{0};
+    Window deferred_active_window_{None};
 
     void handleMapRequest(const XMapRequestEvent& event);
     void handleConfigureRequest(const XConfigureRequestEvent& event);
     void handleKeyPress(const XKeyEvent& event);
+    void handleKeyRelease(const XKeyEvent& event);
+    void handleMappingNotify(XMappingEvent& event);
     void handleButtonPress(const XButtonEvent& event);
     void handleButtonRelease(const XButtonEvent& event);
     void handleMotionNotify(const XMotionEvent& event);
@@ -303,6 +376,7 @@ private:
     void handleEnterNotify(const XCrossingEvent& event);
     void handleFocusIn(const XFocusChangeEvent& event);
     void handlePropertyNotify(const XPropertyEvent& event);
+    void handleConfigureNotify(const XConfigureEvent& event);
 
     void startDrag(Window window, int root_x, int root_y);
     void updateDrag(int root_x, int root_y);
@@ -324,12 +398,34 @@ private:
     void setupIPCServer();
     void scanExistingWindows();
     void applyLayout();
+    void updateScreenGeometry();
     
     bool loadConfigSafe();
     void fallbackToDefaultConfig();
     
     void applyConfigToLayout();
     
+    /**
+     * @brief Reapply only the config sections that differ from @p previous
+     *
+     * Used on reload: relayouts only for gap/workspace/window changes,
+     * repaints borders only for border changes and regrabs only the key
+     * combos that were added or removed.
+     */
+    void applyConfigChanges(const Config& previous);
+    
+    void applyFocusConfig(const Config& config);
+    void applyWorkspaceConfig(const Config& config);
+    void applyWindowConfig(const Config& config);
+    void applyStatusBarConfig(const Config& config);
+    void applyGapConfig(const Config& config);
+    void applyBorderConfig(const Config& config);
+    void applyKeybinds(const Config& config);
+    void applyWindowRules(const Config& config);
+    
+    /** @brief Swap in a config validated off-thread and show queued messages */
+    void processPendingReload();
+    
     void setupConfigWatcher();
     
     void hideWorkspaceWindows(int workspace);
@@ -343,7 +439,6 @@ private:
     void unmanageWindow(Window window);
     void manageWindow(Window window);
     
-    void updateEWMHClientList();
     void updateEWMHActiveWindow(Window window);
     void updateEWMHWorkspaceCount();
     void updateEWMHCurrentWorkspace();
@@ -355,6 +450,20 @@ private:
     void updateExternalBarActiveWindow();
     void updateExternalBarLayoutMode();
     
+    void publishWorkspaceEvent();
+    void publishFocusEvent(Window window);
+    void publishWindowEvent(const char* change, Window window, int workspace);
+    void publishMonitorEvent();
+    void publishIPCState();
+    void publishSharedState(const IPCStateSnapshot& state);
+    
+    void processIPCTransactions();
+    IPCResponse executeIPCCommand(const std::vector<std::string>& args);
+    void beginTransaction();
+    void commitTransaction();
+    bool deferUpdate(uint32_t update);
+    void flushDisplay(bool sync = false);
+    
     static int onXError(Display* display, XErrorEvent* error);
     static int onWMDetected(Display* display, XErrorEvent* error);
     static bool wm_detected_;
@@ -18,6 +18,9 @@
 #include <vector>
 #include <functional>
 #include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include "pointblank/layout/Geometry.hpp"
 
 namespace pblank {
 namespace ewmh {
@@ -170,15 +173,26 @@ public:
     
     void setDesktopNames(const std::vector<std::string>& names);
     
-    void updateWorkarea(int screen_width, int screen_height,
-                        unsigned long left = 0, unsigned long right = 0,
-                        unsigned long top = 0, unsigned long bottom = 0);
-    
     void setShowingDesktop(bool showing);
     
-    void setClientList(const std::vector<Window>& windows);
+    /**
+     * @brief Client registry behind _NET_CLIENT_LIST (mapping order) and
+     *        _NET_CLIENT_LIST_STACKING (bottom to top)
+     *
+     * Both properties are brought up to date by flush(): pure additions are
+     * appended, removals and restacks rewrite the property once.
+     */
+    void addClient(Window window);
+    
+    void removeClient(Window window);
+    
+    inline const std::vector<Window>& getClientList() const { return client_list_; }
     
-    void setClientListStacking(const std::vector<Window>& windows);
+    /** @brief Seed the stacking model with XQueryTree's children (bottom to top) */
+    void setStackingOrder(const Window* children, unsigned int count);
+    
+    /** @brief Follow restacks of root children (Create/Destroy/Reparent/Configure/CirculateNotify) */
+    void handleStackingEvent(const XEvent& event);
     
     void setActiveWindow(Window window);
     
@@ -208,6 +222,18 @@ public:
     
     std::string getWindowTitle(Window window);
     
+    /**
+     * @brief Send the property writes queued since the last flush
+     *
+     * Setters only record the new value in a shadow copy; writes identical
+     * to what the server already holds are dropped there, and repeated
+     * writes of one property before a flush collapse into one request.
+     */
+    void flush();
+    
+    /** @brief Drop the shadow copies of a window's properties once it is unmanaged */
+    void forgetWindow(Window window);
+    
     bool handleClientMessage(const XClientMessageEvent& event);
     
     bool handleRequestFrameExtents(const XClientMessageEvent& event);
@@ -224,6 +250,7 @@ public:
     
     inline int getNumberOfDesktops() const { return num_desktops_; }
     inline int getCurrentDesktop() const { return current_desktop_; }
+    inline const std::vector<std::string>& getDesktopNames() const { return desktop_names_; }
     inline Window getRootWindow() const { return root_; }
     
     static bool isFloatingType(WindowType type);
@@ -247,11 +274,26 @@ public:
     
     StrutPartial getStrutPartial(Window window);
     
-    StrutPartial getCombinedStruts(int screen_width, int screen_height);
+    /**
+     * @brief Screen and monitor geometry the dock struts are resolved against
+     *
+     * Each dock's strut is read once when it registers and again only on a
+     * strut PropertyNotify. Usable areas and _NET_WORKAREA are recomputed
+     * when a strut or this geometry changes, never per layout pass.
+     */
+    void setScreenGeometry(int screen_width, int screen_height, const std::vector<Rect>& monitors);
     
-    void registerDockWindow(Window window);
+    /** @brief Monitor bounds minus the dock struts overlapping it; the whole screen for -1 */
+    const Rect& getUsableArea(int monitor) const;
     
-    void unregisterDockWindow(Window window);
+    /** @return true if the window was not already a registered dock */
+    bool registerDockWindow(Window window);
+    
+    /** @return true if the window was a registered dock */
+    bool unregisterDockWindow(Window window);
+    
+    /** @brief Re-read a dock's strut; true if it changed the usable areas */
+    bool handleDockPropertyNotify(const XPropertyEvent& event);
     
     inline const std::vector<Window>& getDockWindows() const { return dock_windows_; }
 
@@ -284,9 +326,61 @@ private:
     WindowMoveCallback window_move_callback_;
     
     std::vector<Window> client_list_;
+    std::unordered_set<Window> client_set_;
+    std::vector<Window> root_stack_;            ///< All root children, bottom to top
+    std::vector<Window> client_stacking_;
+    bool stacking_dirty_{false};
+    
+    /** @brief A client list property as the server last saw it */
+    struct ClientListProperty {
+        Atom atom{None};
+        std::vector<Window> synced;
+        bool known{false};
+        bool dirty{false};
+    };
+    
+    ClientListProperty client_list_prop_;
+    ClientListProperty client_stacking_prop_;
+    
     std::vector<std::string> desktop_names_;
     
     std::vector<Window> dock_windows_;
+    std::unordered_map<Window, StrutPartial> dock_struts_;
+    
+    int screen_width_{0};
+    int screen_height_{0};
+    std::vector<Rect> monitors_;
+    std::vector<Rect> usable_areas_;        ///< Parallel to monitors_
+    Rect screen_area_{0, 0, 0, 0};
+    
+    void recomputeUsableAreas();
+    
+    void writeWorkarea();
+    
+    /** @brief Last value written (or queued) for a property; format 0 means deleted */
+    struct PropertyShadow {
+        Atom type{None};
+        int format{0};
+        int count{0};
+        std::string data;       ///< Xlib layout: longs for format 32
+        bool pending{false};
+    };
+    
+    std::unordered_map<uint64_t, PropertyShadow> shadow_;
+    std::vector<uint64_t> pending_;
+    
+    static uint64_t propertyKey(Window window, Atom property) {
+        return (static_cast<uint64_t>(window) << 32) | static_cast<uint32_t>(property);
+    }
+    
+    const PropertyShadow* findShadow(Window window, Atom property) const;
+    
+    void writeProperty(Window window, Atom property, Atom type, int format,
+                       const void* data, int count);
+    
+    void deleteProperty(Window window, Atom property);
+    
+    void syncClientList(ClientListProperty& prop, const std::vector<Window>& windows);
     
     void initAtoms();
     
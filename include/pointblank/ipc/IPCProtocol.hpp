@@ -0,0 +1,96 @@
+#pragma once
+
+/**
+ * @file IPCProtocol.hpp
+ * @brief Binary IPC framing and fixed-layout state records
+ *
+ * A connection starts in the line-based text protocol. Sending the line
+ * `protocol binary` switches it to length-prefixed frames: every request
+ * and reply is an IPCFrameHeader followed by `length` payload bytes.
+ * Replies echo the request's `request_id`, so clients may pipeline freely.
+ * Events for subscribed connections arrive as IPCOpcode::Event frames
+ * with request_id 0.
+ *
+ * All fields are in host byte order; the socket is local only.
+ * The structs are plain data with explicit sizes so that C and other
+ * language clients can mirror them directly.
+ *
+ * @author Point Blank Systems Engineering Team
+ * @version 2.0.0
+ */
+
+#include <cstdint>
+
+namespace pblank {
+
+constexpr uint32_t IPC_BINARY_PROTOCOL_VERSION = 1;
+
+enum class IPCOpcode : uint16_t {
+    Ping          = 1,   ///< payload echoed back
+    GetWorkspaces = 2,   ///< reply: IPCWorkspaceRecord[]
+    GetWindows    = 3,   ///< reply: IPCWindowRecord[]
+    GetWindow     = 4,   ///< request: uint64_t window; reply: IPCWindowRecord
+    GetFocused    = 5,   ///< reply: IPCWindowRecord, empty when nothing is focused
+    GetLayout     = 6,   ///< reply: layout name (not NUL-terminated)
+    Command       = 7,   ///< request: one text-protocol command; reply: its message text
+    Event         = 8,   ///< server push: one "EVENT|topic|json" line
+    GetMonitors   = 9    ///< reply: IPCMonitorRecord[]
+};
+
+enum class IPCStatus : uint16_t {
+    Ok    = 0,
+    Error = 1            ///< payload holds the error message
+};
+
+struct IPCFrameHeader {
+    uint32_t length;         ///< payload bytes following this header
+    uint32_t request_id;     ///< chosen by the client, echoed in the reply
+    uint16_t opcode;         ///< IPCOpcode
+    uint16_t status;         ///< IPCStatus (replies only)
+};
+static_assert(sizeof(IPCFrameHeader) == 12, "IPCFrameHeader layout is part of the protocol");
+
+constexpr uint32_t IPC_WINDOW_FLOATING   = 1u << 0;
+constexpr uint32_t IPC_WINDOW_FULLSCREEN = 1u << 1;
+constexpr uint32_t IPC_WINDOW_HIDDEN     = 1u << 2;
+constexpr uint32_t IPC_WINDOW_FOCUSED    = 1u << 3;
+
+struct IPCWindowRecord {
+    uint64_t window;
+    int32_t x;
+    int32_t y;
+    uint32_t width;
+    uint32_t height;
+    int32_t workspace;       ///< 1-based
+    uint32_t flags;          ///< IPC_WINDOW_*
+    char wm_class[64];       ///< NUL-terminated, truncated
+    char title[128];         ///< NUL-terminated, truncated (UTF-8)
+};
+static_assert(sizeof(IPCWindowRecord) == 224, "IPCWindowRecord layout is part of the protocol");
+
+constexpr uint32_t IPC_WORKSPACE_CURRENT  = 1u << 0;
+constexpr uint32_t IPC_WORKSPACE_OCCUPIED = 1u << 1;
+
+struct IPCWorkspaceRecord {
+    int32_t workspace;       ///< 1-based
+    uint32_t window_count;
+    int32_t monitor;
+    uint32_t flags;          ///< IPC_WORKSPACE_*
+    char layout[16];         ///< NUL-terminated layout name
+};
+static_assert(sizeof(IPCWorkspaceRecord) == 32, "IPCWorkspaceRecord layout is part of the protocol");
+
+constexpr uint32_t IPC_MONITOR_PRIMARY = 1u << 0;
+
+struct IPCMonitorRecord {
+    int32_t monitor;
+    int32_t x;
+    int32_t y;
+    uint32_t width;
+    uint32_t height;
+    uint32_t flags;          ///< IPC_MONITOR_*
+    char name[32];           ///< NUL-terminated output name
+};
+static_assert(sizeof(IPCMonitorRecord) == 56, "IPCMonitorRecord layout is part of the protocol");
+
+}
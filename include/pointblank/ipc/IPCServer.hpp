@@ -1,21 +1,39 @@
 #pragma once
 
+#include "pointblank/ipc/IPCProtocol.hpp"
+#include "pointblank/ipc/JSON.hpp"
+#include "pointblank/performance/LockFreeStructures.hpp"
+
 #include <X11/Xlib.h>
 #include <cstdlib>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <array>
 #include <atomic>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
-#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
 namespace pblank {
 
-static constexpr size_t MAX_IPC_CLIENTS = 32;
+/** @brief Largest unterminated request a client may buffer before it is dropped */
+static constexpr size_t IPC_MAX_REQUEST_SIZE = 1 << 20;
+
+/** @brief Queued output above which a client's reads are paused until it drains */
+static constexpr size_t IPC_OUTPUT_HIGH_WATER = 4 << 20;
+
+/** @brief Undelivered events held per subscriber before coalescing/dropping */
+static constexpr size_t IPC_EVENT_QUEUE_DEPTH = 256;
+
+/** @brief Queued output below which pending events are moved onto the socket */
+static constexpr size_t IPC_EVENT_LOW_WATER = 64 << 10;
 
 /**
  * @brief IPC command types that can be sent to Pointblank
@@ -31,17 +49,30 @@ enum class IPCCommandType {
     Unsubscribe
 };
 
+/**
+ * @brief JSON-RPC 2.0 error codes, also carried by text-protocol errors
+ */
+enum IPCErrorCode : int {
+    IPC_ERROR_PARSE            = -32700,
+    IPC_ERROR_INVALID_REQUEST  = -32600,
+    IPC_ERROR_METHOD_NOT_FOUND = -32601,
+    IPC_ERROR_INVALID_PARAMS   = -32602,
+    IPC_ERROR_INTERNAL         = -32603,
+    IPC_ERROR_SERVER           = -32000
+};
+
 struct IPCResponse {
     bool success;
     std::string message;
     std::string data;  
+    int code = 0;
     
     static IPCResponse ok(const std::string& msg = "", const std::string& json = "") {
         return {true, msg, json};
     }
     
-    static IPCResponse error(const std::string& msg) {
-        return {false, msg, ""};
+    static IPCResponse error(const std::string& msg, int code = IPC_ERROR_SERVER) {
+        return {false, msg, "", code};
     }
 };
 
@@ -53,6 +84,146 @@ struct IPCCommand {
 
 using IPCCallback = std::function<void(const std::string& command, const std::vector<std::string>& args)>;
 
+/**
+ * @brief Writes the active configuration as JSON for `config` queries
+ *
+ * Runs on the reactor thread, so it must only read an immutable snapshot
+ * (ConfigParser::snapshot()), never live window manager state.
+ */
+using IPCConfigWriter = std::function<void(JSONWriter& out)>;
+
+/**
+ * @brief Window manager commands from one request, applied as a unit
+ *
+ * The reactor collects every state-changing command of a request (a
+ * single command, a `batch` line or a JSON-RPC batch) into one
+ * transaction. The X thread runs them back to back with layout, EWMH and
+ * flush deferred to a single commit, fills `results` in order and hands
+ * the transaction back with IPCServer::completeTransaction().
+ */
+struct IPCTransaction {
+    std::vector<std::vector<std::string>> commands;    // args[0] is the action
+    std::vector<IPCResponse> results;
+    int client_fd = -1;
+    uint64_t client_serial = 0;
+};
+
+/**
+ * @brief Event topics a client can subscribe to (bitmask)
+ */
+enum class IPCEventTopic : uint32_t {
+    Workspace = 1u << 0,
+    Focus     = 1u << 1,
+    Title     = 1u << 2,
+    Layout    = 1u << 3,
+    Window    = 1u << 4,
+    Monitor   = 1u << 5,
+    All       = (1u << 6) - 1
+};
+
+const char* ipcEventTopicName(IPCEventTopic topic);
+std::optional<IPCEventTopic> ipcEventTopicFromString(std::string_view name);
+
+/**
+ * @brief A serialized event, shared by every subscriber it is fanned out to
+ *
+ * State topics (everything except window lifecycle) coalesce: a newer
+ * event with the same topic and window replaces an undelivered older one.
+ */
+struct IPCEvent {
+    IPCEventTopic topic = IPCEventTopic::All;
+    Window window = None;
+    bool coalesce = false;
+    std::string line;
+};
+
+/**
+ * @brief Fixed-capacity per-subscriber event ring
+ *
+ * Only touched by the reactor thread. When full, the oldest event is
+ * discarded and counted so the client can be told it missed something.
+ */
+class IPCEventQueue {
+public:
+    void push(std::shared_ptr<const IPCEvent> event);
+    std::shared_ptr<const IPCEvent> pop();
+    
+    bool empty() const { return count_ == 0; }
+    size_t size() const { return count_; }
+    
+    size_t takeDropped() { size_t d = dropped_; dropped_ = 0; return d; }
+
+private:
+    std::array<std::shared_ptr<const IPCEvent>, IPC_EVENT_QUEUE_DEPTH> slots_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+    size_t dropped_ = 0;
+};
+
+/**
+ * @brief Independently versioned parts of the IPC state
+ */
+enum class IPCFacet : uint8_t {
+    Workspaces,
+    Clients,
+    Focus,
+    Layout,
+    Monitors,
+    Count
+};
+
+static constexpr size_t IPC_FACET_COUNT = static_cast<size_t>(IPCFacet::Count);
+
+/**
+ * @brief Immutable view of window manager state served to IPC queries
+ *
+ * Built on the X thread whenever state changes and swapped in atomically,
+ * so the reactor answers queries without touching WindowManager. Each
+ * facet carries a generation that only moves when its content changes.
+ */
+struct IPCStateSnapshot {
+    std::vector<IPCWindowRecord> windows;       // sorted by window id
+
+    std::vector<IPCWorkspaceRecord> workspaces;
+    std::vector<IPCMonitorRecord> monitors;
+    Window focused = None;
+    int current_workspace = 0;
+    std::string layout;
+    std::array<uint64_t, IPC_FACET_COUNT> generations{};
+    
+    uint64_t generation(IPCFacet facet) const { return generations[static_cast<size_t>(facet)]; }
+    
+    const IPCWindowRecord* findWindow(Window window) const;
+};
+
+/**
+ * @brief Per-connection state owned by the IPC reactor thread
+ *
+ * Requests accumulate in `in` until a newline arrives; replies are queued
+ * in `out` and flushed with a single gather write when the socket allows.
+ */
+struct IPCClient {
+    int fd = -1;
+    uint64_t serial = 0;        // distinguishes a reused fd
+    std::string in;
+    std::deque<std::string> out;
+    size_t out_offset = 0;      // bytes of out.front() already written
+    size_t out_bytes = 0;       // unwritten bytes across all of out
+    uint32_t events = 0;        // epoll interest currently registered
+    uint32_t topics = 0;        // IPCEventTopic mask
+    bool binary = false;        // negotiated length-prefixed framing
+    std::unique_ptr<IPCEventQueue> pending_events;
+    bool closing = false;       // close once out has drained
+    bool eof = false;           // peer sent its last byte; buffered requests still run
+    
+    // A request waiting on an IPCTransaction; input behind it is held
+    // back so replies stay in request order.
+    bool awaiting_commit = false;
+    bool deferred_frame = false;
+    IPCFrameHeader deferred_header{};
+    std::string deferred_request;
+};
+
 class IPCServer {
 public:
     IPCServer(Display* display, Window root);
@@ -67,8 +238,42 @@ public:
     
     void broadcast(const std::string& message);
     
+    /**
+     * @brief Queue an event for subscribers of @p topic
+     *
+     * Safe to call from the X event thread: it only appends to a lock-free
+     * queue and pokes the reactor, so a slow client can never stall the WM.
+     */
+    void publish(IPCEventTopic topic, std::string_view payload, Window window = None);
+    
+    /** @brief Replace the state snapshot queries are answered from */
+    void publishState(std::shared_ptr<const IPCStateSnapshot> state) {
+        state_.store(std::move(state), std::memory_order_release);
+    }
+    
+    bool hasSubscribers(IPCEventTopic topic) const {
+        return (subscribed_topics_.load(std::memory_order_relaxed) & static_cast<uint32_t>(topic)) != 0;
+    }
+    
     void setCommandCallback(IPCCallback callback);
     
+    /** @brief Serve `config` queries through @p writer; set before start() */
+    void setConfigWriter(IPCConfigWriter writer) { config_writer_ = std::move(writer); }
+    
+    /**
+     * @brief Route state-changing commands through IPCTransaction
+     *
+     * Once enabled, the owner must poll takeTransaction() from its own
+     * thread and return each one through completeTransaction().
+     */
+    void acceptTransactions(bool enable) { accept_transactions_.store(enable, std::memory_order_release); }
+    
+    std::unique_ptr<IPCTransaction> takeTransaction();
+    
+    bool hasTransactions() const { return !transactions_.empty(); }
+    
+    void completeTransaction(std::unique_ptr<IPCTransaction> transaction);
+    
     bool isRunning() const { return running_.load(); }
     
     const std::string& getSocketPath() const { return socket_path_; }
@@ -78,32 +283,99 @@ private:
     Window root_;
     std::string socket_path_;
     int server_fd_;
+    int epoll_fd_;
+    int wake_fd_;
     std::atomic<bool> running_;
-    std::thread accept_thread_;
-    std::vector<int> client_fds_;
-    std::mutex client_mutex_;
+    std::thread reactor_thread_;
     IPCCallback command_callback_;
+    IPCConfigWriter config_writer_;
+    
+    std::unordered_map<int, std::unique_ptr<IPCClient>> clients_;
     
-    std::vector<int> subscribers_;
-    std::mutex subscriber_mutex_;
+    std::atomic<std::shared_ptr<const IPCStateSnapshot>> state_;
     
-    void acceptLoop();
-    void handleClient(int client_fd);
-    IPCResponse processCommand(const std::string& command);
-    IPCResponse processJSONRPC(const std::string& json);
-    IPCResponse processLegacyCommand(const std::string& cmd, const std::vector<std::string>& args);
-    std::string getWorkspacesJSON() const;
-    std::string getWindowInfoJSON(Window w) const;
-    std::string getLayoutModeJSON() const;
+    std::vector<IPCClient*> subscribers_;
+    std::atomic<uint32_t> subscribed_topics_{0};
+    
+    lockfree::MPSCQueue<std::shared_ptr<const IPCEvent>> event_queue_;
+    std::atomic<bool> wake_pending_{false};
+    
+    std::atomic<bool> accept_transactions_{false};
+    lockfree::MPSCQueue<std::unique_ptr<IPCTransaction>> transactions_;
+    lockfree::MPSCQueue<std::unique_ptr<IPCTransaction>> completions_;
+    std::unique_ptr<IPCTransaction> staged_;
+    const IPCTransaction* replaying_ = nullptr;
+    size_t replay_index_ = 0;
+    uint64_t next_serial_ = 1;
+    
+    // Reactor-thread scratch space, reused across requests
+    JSONWriter json_;
+    JSONWriter rpc_json_;
+    std::vector<std::string> rpc_args_;
+    std::string rpc_method_;
+    
+    // Serialized facet payloads, valid while the facet generation matches
+    struct FacetCache {
+        uint64_t generation = 0;
+        bool valid = false;
+        std::string json;
+    };
+    std::array<FacetCache, IPC_FACET_COUNT> facet_cache_;
+    
+    void reactorLoop();
+    void acceptClients();
+    bool readClient(IPCClient& client);
+    bool flushClient(IPCClient& client);
+    bool settleClient(IPCClient& client, bool flushed);
+    void updateInterest(IPCClient& client);
+    void closeClient(int fd);
+    void enqueueEvent(std::shared_ptr<const IPCEvent> event);
+    void wakeReactor();
+    void drainEvents();
+    void drainCompletions();
+    void pumpEvents(IPCClient& client);
+    bool deliver(IPCClient& client);
+    void setTopics(IPCClient& client, uint32_t topics);
+    
+    void processInput(IPCClient& client);
+    size_t processLines(IPCClient& client, size_t start);
+    void processLine(IPCClient& client, std::string_view line);
+    size_t processFrames(IPCClient& client, size_t start);
+    void processFrame(IPCClient& client, const IPCFrameHeader& header, std::string_view payload);
+    
+    IPCResponse processCommand(IPCClient& client, std::string_view command);
+    IPCResponse runCommand(IPCClient& client, const std::string& cmd, const std::vector<std::string>& args);
+    IPCResponse processBatch(IPCClient& client, const std::vector<std::string>& args);
+    bool isReactorCommand(const std::string& cmd, const std::vector<std::string>& args) const;
+    bool deferRequest(IPCClient& client, std::string_view request, const IPCFrameHeader* header);
+    bool processJSONRPC(IPCClient& client, std::string_view json, JSONWriter& out);
+    bool processRPCRequest(IPCClient& client, JSONReader& reader, JSONWriter& out);
+    bool collectRPCParams(JSONReader& reader, JSONReader::Token first);
+    void appendRPCParam(JSONReader& reader, JSONReader::Token token, bool flatten);
+    void writeRPCError(JSONWriter& out, std::string_view id, int code, std::string_view message);
+    IPCResponse processLegacyCommand(IPCClient& client, const std::string& cmd, const std::vector<std::string>& args);
+    IPCResponse queryFacet(IPCFacet facet, const char* message, const std::vector<std::string>& args);
+    const std::string& facetJSON(IPCFacet facet, const IPCStateSnapshot* state);
+    void writeFacetJSON(JSONWriter& out, IPCFacet facet, const IPCStateSnapshot* state) const;
+    void writeWindowInfoJSON(JSONWriter& out, const IPCStateSnapshot* state, Window w,
+                             uint64_t generation = 0) const;
+    std::shared_ptr<const IPCStateSnapshot> currentState() const {
+        return state_.load(std::memory_order_acquire);
+    }
     
-    bool sendResponse(int fd, const IPCResponse& response);
-    std::vector<std::string> parseCommand(const std::string& input) const;
+    void queueResponse(IPCClient& client, const IPCResponse& response);
+    void queueFrame(IPCClient& client, uint32_t request_id, IPCOpcode opcode,
+                    IPCStatus status, const void* payload, size_t length);
+    void queueOutput(IPCClient& client, std::string data);
+    std::vector<std::string> parseCommand(std::string_view input) const;
 };
 
 inline IPCServer::IPCServer(Display* display, Window root)
     : display_(display)
     , root_(root)
     , server_fd_(-1)
+    , epoll_fd_(-1)
+    , wake_fd_(-1)
     , running_(false)
 {
     
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace pblank {
+
+/**
+ * @brief Allocation-free pull parser over a borrowed buffer
+ *
+ * Each call to next() validates and returns one token. String and number
+ * tokens are exposed as views into the input; strings keep their escapes
+ * until unescape() is asked for them, so values that are only compared or
+ * skipped never get copied. Nesting is limited to MAX_DEPTH levels.
+ */
+class JSONReader {
+public:
+    enum class Token : uint8_t {
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        Key,
+        String,
+        Number,
+        Boolean,        ///< text() is "true" or "false"
+        Null,
+        End,
+        Error
+    };
+
+    static constexpr int MAX_DEPTH = 64;
+
+    explicit JSONReader(std::string_view input) : in_(input) {}
+
+    Token next();
+
+    /** @brief Key/String contents without quotes (escapes intact), or the scalar literal */
+    std::string_view text() const { return text_; }
+
+    /** @brief Whether the current Key/String contains backslash escapes */
+    bool hasEscapes() const { return has_escapes_; }
+
+    /** @brief Offset of the first byte of the current token */
+    size_t tokenStart() const { return token_start_; }
+
+    size_t offset() const { return pos_; }
+
+    int depth() const { return depth_; }
+
+    /**
+     * @brief Skip the rest of a value whose first token was @p first
+     * @return Source span of the whole value, or an empty view on error
+     */
+    std::string_view skipValue(Token first);
+
+    /** @brief Append the decoded form of a Key/String token to @p out */
+    static void unescape(std::string_view raw, std::string& out);
+
+    /** @brief Current string decoded (copy-free when it has no escapes) */
+    std::string_view stringValue(std::string& scratch) const;
+
+    bool textEquals(std::string_view literal) const {
+        return !has_escapes_ && text_ == literal;
+    }
+
+private:
+    enum class State : uint8_t {
+        Value,
+        ValueOrEnd,
+        Key,
+        KeyOrEnd,
+        AfterValue,
+        Done
+    };
+
+    std::string_view in_;
+    size_t pos_ = 0;
+    size_t token_start_ = 0;
+    std::string_view text_;
+    bool has_escapes_ = false;
+    State state_ = State::Value;
+    int depth_ = 0;
+    uint64_t object_bits_ = 0;      // bit n set: level n+1 is an object
+
+    bool inObject() const { return depth_ > 0 && ((object_bits_ >> (depth_ - 1)) & 1); }
+    void skipWhitespace();
+    bool scanString();
+    bool scanNumber();
+    bool scanLiteral(std::string_view literal);
+    Token fail() { state_ = State::Done; pos_ = in_.size() + 1; return Token::Error; }
+};
+
+/**
+ * @brief Streaming JSON serializer into a reusable buffer
+ *
+ * clear() keeps the buffer's capacity, so a long-lived writer stops
+ * allocating once it has grown to its working size. Commas and key/value
+ * separators are inserted automatically.
+ */
+class JSONWriter {
+public:
+    static constexpr int MAX_DEPTH = 64;
+
+    void clear() { buf_.clear(); depth_ = 0; need_comma_ = 0; after_key_ = false; overflow_ = 0; overflowed_ = false; }
+    void reserve(size_t bytes) { buf_.reserve(bytes); }
+
+    JSONWriter& beginObject() { open('{'); return *this; }
+    JSONWriter& endObject() { close('}'); return *this; }
+    JSONWriter& beginArray() { open('['); return *this; }
+    JSONWriter& endArray() { close(']'); return *this; }
+
+    JSONWriter& key(std::string_view name);
+
+    JSONWriter& value(std::string_view text);
+    JSONWriter& value(const char* text) { return value(std::string_view(text)); }
+    JSONWriter& value(const std::string& text) { return value(std::string_view(text)); }
+    JSONWriter& value(bool b);
+    JSONWriter& value(double d);
+    JSONWriter& null();
+
+    template<typename T>
+    std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, JSONWriter&>
+    value(T number) {
+        separator();
+        if constexpr (std::is_signed_v<T>) {
+            appendInteger(static_cast<int64_t>(number));
+        } else {
+            appendUnsigned(static_cast<uint64_t>(number));
+        }
+        return *this;
+    }
+
+    /** @brief Insert an already-serialized JSON value verbatim */
+    JSONWriter& raw(std::string_view json);
+
+    /** @brief Append bytes after the document (e.g. a line terminator) */
+    void append(std::string_view bytes) { buf_.append(bytes); }
+
+    const std::string& str() const { return buf_; }
+    std::string_view view() const { return buf_; }
+    bool empty() const { return buf_.empty(); }
+
+    /** @brief False once a container was opened past MAX_DEPTH; str() is then unusable */
+    bool ok() const { return !overflowed_; }
+
+private:
+    std::string buf_;
+    int depth_ = 0;
+    uint64_t need_comma_ = 0;       // bit n set: level n already has an element
+    bool after_key_ = false;
+    int overflow_ = 0;              // opens refused at the depth cap, still to be closed
+    bool overflowed_ = false;
+
+    void separator();
+    void open(char c);
+    void close(char c);
+    void appendEscaped(std::string_view text);
+    void appendInteger(int64_t number);
+    void appendUnsigned(uint64_t number);
+};
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "pointblank/ipc/pb_state.h"
+
+#include <string>
+
+namespace pblank {
+
+/**
+ * @brief Writer side of the status-bar shared-memory region (see pb_state.h)
+ *
+ * Owned by the main thread, which is the only writer. publish() performs a
+ * seqlock update of the mapped pb_state and wakes futex waiters; identical
+ * updates are dropped so bars are only woken for real changes.
+ */
+class SharedStateRegion {
+public:
+    SharedStateRegion() = default;
+    ~SharedStateRegion();
+
+    SharedStateRegion(const SharedStateRegion&) = delete;
+    SharedStateRegion& operator=(const SharedStateRegion&) = delete;
+
+    /** @brief Create (or take over) and map the region; unlinked again by close() */
+    bool open();
+    void close();
+    bool isOpen() const { return state_ != nullptr; }
+
+    /** @return true if the data differed from the last publish and was written */
+    bool publish(const pb_state_data& data);
+
+    const std::string& getName() const { return name_; }
+
+private:
+    pb_state* state_ = nullptr;
+    std::string name_;
+    pb_state_data last_{};
+    bool has_last_ = false;
+};
+
+}
@@ -0,0 +1,181 @@
+/**
+ * @file pb_state.h
+ * @brief Shared-memory window manager state for status bars (C ABI)
+ *
+ * When `status_bar { shared_state: true; }` is set, Point Blank publishes
+ * the state external bars care about in a POSIX shared-memory object named
+ * "/pointblank-<uid>.state". The window manager is the only writer; bars
+ * map it read-only and never talk to the X server to learn this state.
+ *
+ * Consistency: `sequence` is a seqlock. It is odd while the writer is
+ * updating `data`; pb_state_read() copies `data` and retries until it sees
+ * the same even sequence before and after the copy.
+ *
+ * Change notification: `change_count` is incremented after every update
+ * and woken with FUTEX_WAKE (shared, not FUTEX_PRIVATE). pb_state_wait()
+ * sleeps until it differs from the value the caller last saw.
+ *
+ * Shutdown: the writer zeroes `magic` and wakes all waiters before it
+ * unlinks the region. Both helpers then return PB_STATE_CLOSED; the caller
+ * should pb_state_close() and pb_state_open() again later.
+ *
+ *     struct pb_state *st = pb_state_open();
+ *     uint32_t seen = 0;
+ *     for (;;) {
+ *         struct pb_state_data d;
+ *         if (pb_state_wait(st, &seen, NULL) == PB_STATE_CLOSED ||
+ *             pb_state_read(st, &d) == PB_STATE_CLOSED)
+ *             break;
+ *         redraw(&d);
+ *     }
+ *     pb_state_close(st);
+ *
+ * The layout only grows at the end; consumers must check `version` and
+ * `size` (pb_state_open() does).
+ *
+ * Linux only. With strict ISO modes (-std=c11) define _DEFAULT_SOURCE
+ * before including any header.
+ *
+ * @author Point Blank Systems Engineering Team
+ * @version 2.0.0
+ */
+
+#ifndef POINTBLANK_PB_STATE_H
+#define POINTBLANK_PB_STATE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PB_STATE_MAGIC          0x54534250u     /* "PBST" */
+#define PB_STATE_VERSION        1u
+#define PB_STATE_NAME_FORMAT    "/pointblank-%u.state"
+
+#define PB_STATE_CLOSED         (-1)            /* writer has torn the region down */
+
+#define PB_STATE_MAX_WORKSPACES 64
+#define PB_STATE_LAYOUT_LEN     32
+#define PB_STATE_CLASS_LEN      64
+#define PB_STATE_TITLE_LEN      256
+
+struct pb_state_data {
+    int32_t  current_workspace;     /* 0-based, same as _PB_CURRENT_WORKSPACE */
+    uint32_t workspace_count;       /* entries of window_counts in use */
+    uint64_t occupied;              /* bit n set: workspace n has windows */
+    uint64_t active_window;         /* X window id, 0 when nothing is focused */
+    uint32_t window_counts[PB_STATE_MAX_WORKSPACES];
+    char     layout[PB_STATE_LAYOUT_LEN];           /* NUL-terminated */
+    char     active_class[PB_STATE_CLASS_LEN];      /* NUL-terminated, truncated */
+    char     active_title[PB_STATE_TITLE_LEN];      /* NUL-terminated UTF-8, truncated */
+};
+
+struct pb_state {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                  /* sizeof(struct pb_state) of the writer */
+    uint32_t sequence;              /* seqlock, odd while an update is in progress */
+    uint32_t change_count;          /* futex word, bumped after every update */
+    uint32_t reserved;
+    struct pb_state_data data;
+};
+
+/** Map the region read-only. Returns NULL if it does not exist or is incompatible. */
+static inline struct pb_state *pb_state_open(void)
+{
+    char name[64];
+    snprintf(name, sizeof(name), PB_STATE_NAME_FORMAT, (unsigned)getuid());
+
+    char path[80];
+    snprintf(path, sizeof(path), "/dev/shm%s", name);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(struct pb_state)) {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, sizeof(struct pb_state), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return NULL;
+
+    struct pb_state *state = (struct pb_state *)map;
+    if (state->magic != PB_STATE_MAGIC || state->version != PB_STATE_VERSION ||
+        state->size < sizeof(struct pb_state)) {
+        munmap(map, sizeof(struct pb_state));
+        return NULL;
+    }
+    return state;
+}
+
+static inline void pb_state_close(struct pb_state *state)
+{
+    if (state)
+        munmap(state, sizeof(struct pb_state));
+}
+
+static inline int pb_state_alive(const struct pb_state *state)
+{
+    return __atomic_load_n(&state->magic, __ATOMIC_ACQUIRE) == PB_STATE_MAGIC;
+}
+
+/**
+ * Copy a consistent snapshot of the published state into @p out.
+ * Returns 0, or PB_STATE_CLOSED once the writer has gone away.
+ */
+static inline int pb_state_read(const struct pb_state *state, struct pb_state_data *out)
+{
+    for (;;) {
+        if (!pb_state_alive(state))
+            return PB_STATE_CLOSED;
+        uint32_t seq = __atomic_load_n(&state->sequence, __ATOMIC_ACQUIRE);
+        if (seq & 1u)
+            continue;
+        memcpy(out, (const void *)&state->data, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&state->sequence, __ATOMIC_RELAXED) == seq)
+            return 0;
+    }
+}
+
+/**
+ * Block until change_count differs from @p *seen (or @p timeout expires,
+ * NULL waits forever) and store the current change_count in @p *seen.
+ * Returns 1 on a change, 0 on timeout, PB_STATE_CLOSED once the writer
+ * has gone away.
+ */
+static inline int pb_state_wait(const struct pb_state *state, uint32_t *seen,
+                                const struct timespec *timeout)
+{
+    uint32_t now = __atomic_load_n(&state->change_count, __ATOMIC_ACQUIRE);
+    if (now == *seen && pb_state_alive(state)) {
+        syscall(SYS_futex, &state->change_count, FUTEX_WAIT, *seen, timeout, NULL, 0);
+        now = __atomic_load_n(&state->change_count, __ATOMIC_ACQUIRE);
+    }
+    if (!pb_state_alive(state))
+        return PB_STATE_CLOSED;
+    int changed = now != *seen;
+    *seen = now;
+    return changed;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POINTBLANK_PB_STATE_H */
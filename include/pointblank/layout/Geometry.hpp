@@ -0,0 +1,52 @@
+#pragma once
+
+/**
+ * @file Geometry.hpp
+ * @brief Screen rectangles shared by the layout engine and EWMH
+ *
+ * Kept apart from LayoutEngine.hpp so headers that only pass rectangles
+ * around do not pull in the whole engine.
+ */
+
+#include <string>
+
+namespace pblank {
+
+/**
+ * @brief Split direction for BSP nodes
+ */
+enum class SplitType {
+    Horizontal,  
+    Vertical     
+};
+
+struct Rect {
+    int x, y;
+    unsigned int width, height;
+    
+    inline int area() const { return static_cast<int>(width * height); }
+    
+    inline bool contains(int px, int py) const {
+        return px >= x && px < x + static_cast<int>(width) &&
+               py >= y && py < y + static_cast<int>(height);
+    }
+    
+    inline int centerX() const { return x + static_cast<int>(width) / 2; }
+    inline int centerY() const { return y + static_cast<int>(height) / 2; }
+    
+    inline int left() const { return x; }
+    inline int right() const { return x + static_cast<int>(width); }
+    inline int top() const { return y; }
+    inline int bottom() const { return y + static_cast<int>(height); }
+    
+    Rect subRect(bool is_left, SplitType split, double ratio) const;
+    
+    inline bool isLeftOf(const Rect& other) const { return right() <= other.left(); }
+    inline bool isRightOf(const Rect& other) const { return left() >= other.right(); }
+    inline bool isAbove(const Rect& other) const { return bottom() <= other.top(); }
+    inline bool isBelow(const Rect& other) const { return top() >= other.bottom(); }
+    
+    int distanceTo(const Rect& other, const std::string& direction) const;
+};
+
+}
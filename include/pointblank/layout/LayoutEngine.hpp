@@ -13,6 +13,7 @@
 #include "pointblank/utils/Camera.hpp"
 #include "pointblank/utils/SpatialGrid.hpp"
 #include "pointblank/utils/GapConfig.hpp"
+#include "pointblank/layout/Geometry.hpp"
 
 namespace pblank {
 
@@ -33,14 +34,6 @@ namespace layout_constants {
 
 class ManagedWindow;
 
-/**
- * @brief Split direction for BSP nodes
- */
-enum class SplitType {
-    Horizontal,  
-    Vertical     
-};
-
 enum class FocusWrapMode {
     Traditional,    
     Infinite        
@@ -56,35 +49,6 @@ struct WorkspaceNode {
     int64_t saved_camera_y{0};
 };
 
-struct Rect {
-    int x, y;
-    unsigned int width, height;
-    
-    inline int area() const { return static_cast<int>(width * height); }
-    
-    inline bool contains(int px, int py) const {
-        return px >= x && px < x + static_cast<int>(width) &&
-               py >= y && py < y + static_cast<int>(height);
-    }
-    
-    inline int centerX() const { return x + static_cast<int>(width) / 2; }
-    inline int centerY() const { return y + static_cast<int>(height) / 2; }
-    
-    inline int left() const { return x; }
-    inline int right() const { return x + static_cast<int>(width); }
-    inline int top() const { return y; }
-    inline int bottom() const { return y + static_cast<int>(height); }
-    
-    Rect subRect(bool is_left, SplitType split, double ratio) const;
-    
-    inline bool isLeftOf(const Rect& other) const { return right() <= other.left(); }
-    inline bool isRightOf(const Rect& other) const { return left() >= other.right(); }
-    inline bool isAbove(const Rect& other) const { return bottom() <= other.top(); }
-    inline bool isBelow(const Rect& other) const { return top() >= other.bottom(); }
-    
-    int distanceTo(const Rect& other, const std::string& direction) const;
-};
-
 class BSPNode {
 public:
     
@@ -153,8 +117,17 @@ public:
 
     void setGapConfig(const GapConfig* gap_config) { gap_config_ = gap_config; }
 
+    /** @brief Per-window border widths set by window rules (owned by LayoutEngine) */
+    void setBorderOverrides(const std::unordered_map<Window, int>* overrides) { border_overrides_ = overrides; }
+
 protected:
     
+    int borderWidthFor(Window win, int fallback) const {
+        if (!border_overrides_) return fallback;
+        auto it = border_overrides_->find(win);
+        return it != border_overrides_->end() ? it->second : fallback;
+    }
+    
     void placeWindow(Display* display, Window win,
                      int x, int y, unsigned int w, unsigned int h,
                      int border_width, unsigned long border_color);
@@ -163,6 +136,7 @@ protected:
     
     RenderPipeline* render_pipeline_{nullptr};
     const GapConfig* gap_config_{nullptr};  
+    const std::unordered_map<Window, int>* border_overrides_{nullptr};
 };
 
 class BSPLayout : public LayoutVisitor {
@@ -489,6 +463,14 @@ public:
     
     void ensureWorkspace(int workspace);
     
+    /**
+     * @brief Per-workspace layout rules, owned by the caller (LayoutConfigParser)
+     *
+     * Resolved whenever a workspace is created; existing workspaces without
+     * windows are switched now.
+     */
+    void setWorkspaceLayouts(const LayoutConfig::WorkspaceLayouts* layouts);
+    
     int getCurrentWorkspace() const { return current_workspace_; }
     
     bool isEmpty() const;
@@ -599,6 +581,10 @@ public:
     GapConfig& getGapConfig() { return gap_config_; }
     const GapConfig& getGapConfig() const { return gap_config_; }
     
+    /** @brief Border width for one window, overriding the layout's (window rules) */
+    void setWindowBorderWidth(Window window, int width) { border_overrides_[window] = width; }
+    void clearWindowBorderWidth(Window window) { border_overrides_.erase(window); }
+    
     void updateSpatialGrid();
 
 private:
@@ -608,6 +594,7 @@ private:
     };
     
     std::vector<WorkspaceData> workspaces_;
+    const LayoutConfig::WorkspaceLayouts* workspace_layouts_{nullptr};
     int current_workspace_{0};
     BSPNode* focused_node_{nullptr};
     Display* display_{nullptr};
@@ -647,6 +634,7 @@ private:
     SpatialGrid spatial_grid_;
     
     GapConfig gap_config_;
+    std::unordered_map<Window, int> border_overrides_;   ///< Shared with every layout visitor
     
     FocusWrapMode focus_wrap_mode_{FocusWrapMode::Traditional};
     
@@ -655,6 +643,9 @@ private:
     
     std::vector<WorkspaceNode> workspace_nodes_;
     
+    /** @brief Build @p mode from the engine's settings, or from @p rule's parameters */
+    std::unique_ptr<LayoutVisitor> makeLayout(LayoutMode mode, const LayoutConfig::WorkspaceLayout* rule) const;
+    
     BSPNode* findNode(BSPNode* root, Window window);
     BSPNode* findParentNode(BSPNode* root, BSPNode* target);
     SplitType determineSplitType() const;
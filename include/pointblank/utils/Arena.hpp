@@ -0,0 +1,149 @@
+#pragma once
+
+/**
+ * @file Arena.hpp
+ * @brief Bump allocator for parse trees
+ *
+ * Objects are carved out of large blocks and released all at once when
+ * the arena is destroyed. Types that are not trivially destructible get
+ * their destructor queued (in the arena itself) and run, newest first,
+ * before the blocks are freed; everything else costs nothing to free.
+ *
+ * @author Point Blank Systems Engineering Team
+ * @version 1.0.0
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace pblank {
+
+class Arena {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 16 * 1024;
+
+    explicit Arena(size_t block_size = DEFAULT_BLOCK_SIZE) : block_size_(block_size) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    Arena(Arena&& other) noexcept { *this = std::move(other); }
+
+    Arena& operator=(Arena&& other) noexcept {
+        if (this != &other) {
+            release();
+            block_size_ = other.block_size_;
+            blocks_ = std::exchange(other.blocks_, nullptr);
+            finalizers_ = std::exchange(other.finalizers_, nullptr);
+            cursor_ = std::exchange(other.cursor_, nullptr);
+            end_ = std::exchange(other.end_, nullptr);
+            bytes_used_ = std::exchange(other.bytes_used_, 0);
+        }
+        return *this;
+    }
+
+    ~Arena() { release(); }
+
+    void* allocate(size_t size, size_t align) {
+        uintptr_t p = (reinterpret_cast<uintptr_t>(cursor_) + align - 1) & ~(uintptr_t(align) - 1);
+        if (!cursor_ || p + size > reinterpret_cast<uintptr_t>(end_)) {
+            grow(size + align);
+            p = (reinterpret_cast<uintptr_t>(cursor_) + align - 1) & ~(uintptr_t(align) - 1);
+        }
+        cursor_ = reinterpret_cast<char*>(p + size);
+        bytes_used_ += size;
+        return reinterpret_cast<void*>(p);
+    }
+
+    template<typename T, typename... Args>
+    T* make(Args&&... args) {
+        T* object = new (allocate(sizeof(T), alignof(T))) T{std::forward<Args>(args)...};
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            auto* fin = new (allocate(sizeof(Finalizer), alignof(Finalizer))) Finalizer;
+            fin->object = object;
+            fin->destroy = [](void* p) { static_cast<T*>(p)->~T(); };
+            fin->next = finalizers_;
+            finalizers_ = fin;
+        }
+        return object;
+    }
+
+    /** @brief Copy @p count trivially copyable elements into the arena */
+    template<typename T>
+    std::span<T> copy(const T* data, size_t count) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (count == 0) {
+            return {};
+        }
+        T* out = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        std::memcpy(out, data, sizeof(T) * count);
+        return {out, count};
+    }
+
+    std::string_view copy(std::string_view text) {
+        if (text.empty()) {
+            return {};
+        }
+        char* out = static_cast<char*>(allocate(text.size(), 1));
+        std::memcpy(out, text.data(), text.size());
+        return {out, text.size()};
+    }
+
+    /** @brief Bytes handed out so far (excluding alignment and block slack) */
+    size_t bytesUsed() const { return bytes_used_; }
+
+    /** @brief Run pending destructors and free every block */
+    void release() {
+        for (Finalizer* f = finalizers_; f; f = f->next) {
+            f->destroy(f->object);
+        }
+        finalizers_ = nullptr;
+
+        while (blocks_) {
+            Block* next = blocks_->next;
+            std::free(blocks_);
+            blocks_ = next;
+        }
+        cursor_ = end_ = nullptr;
+        bytes_used_ = 0;
+    }
+
+private:
+    struct Block {
+        Block* next;
+    };
+
+    struct Finalizer {
+        void* object;
+        void (*destroy)(void*);
+        Finalizer* next;
+    };
+
+    size_t block_size_{DEFAULT_BLOCK_SIZE};
+    Block* blocks_{nullptr};
+    Finalizer* finalizers_{nullptr};
+    char* cursor_{nullptr};
+    char* end_{nullptr};
+    size_t bytes_used_{0};
+
+    void grow(size_t min_size) {
+        size_t size = sizeof(Block) + (min_size > block_size_ ? min_size : block_size_);
+        auto* block = static_cast<Block*>(std::malloc(size));
+        if (!block) {
+            throw std::bad_alloc();
+        }
+        block->next = blocks_;
+        blocks_ = block;
+        cursor_ = reinterpret_cast<char*>(block + 1);
+        end_ = reinterpret_cast<char*>(block) + size;
+    }
+};
+
+}
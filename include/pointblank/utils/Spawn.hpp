@@ -0,0 +1,43 @@
+#pragma once
+
+/**
+ * @file Spawn.hpp
+ * @brief Launching child processes without forking the window manager
+ *
+ * Children are started with posix_spawn, which glibc implements as
+ * clone(CLONE_VM | CLONE_VFORK): no page tables are copied, so launch
+ * cost does not grow with the WM's heap and does not fail under memory
+ * pressure the way fork() can. Every descriptor above stderr is closed
+ * in one closefrom/close_range call instead of a loop over the fd table,
+ * and signal dispositions and the signal mask are reset to defaults.
+ *
+ * @author Point Blank Systems Engineering Team
+ * @version 1.0.0
+ */
+
+#include <string>
+#include <sys/types.h>
+
+namespace pblank {
+
+struct SpawnOptions {
+    bool new_session{true};     ///< setsid(): detach from the WM's session and terminal
+    bool null_stdio{true};      ///< stdin/stdout/stderr on /dev/null instead of inherited
+};
+
+/**
+ * @brief Start @p argv[0] (looked up in PATH) with @p argv
+ * @return The child's pid, or -1 with errno set
+ */
+pid_t spawnProcess(char* const argv[], const SpawnOptions& options = {});
+
+/** @brief Start `/bin/sh -c command`; the child's pid, or -1 with errno set */
+pid_t spawnShell(const std::string& command, const SpawnOptions& options = {});
+
+/**
+ * @brief spawnShell() and wait for the child
+ * @return The wait status from waitpid(), or -1 if it could not be started
+ */
+int runShell(const std::string& command, const SpawnOptions& options = {});
+
+}
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <X11/Xlib.h>
+#include <cstdint>
 #include <unordered_map>
 #include <string>
 #include <functional>
+#include <utility>
 #include <vector>
 
 namespace pblank {
@@ -19,17 +21,85 @@ class WindowManager;
  */
 class KeybindManager {
 public:
+    /** @brief An action string parsed once, when its bind is registered */
+    struct Action {
+        enum class Op : uint8_t {
+            Invalid,
+            KillActive, Fullscreen, ToggleFloating, Reload, Exit,
+            Workspace, MoveToWorkspace, MoveToWorkspaceSilent, WorkspaceNext, WorkspacePrev,
+            Layout, CycleNext, CyclePrev,
+            Focus, Swap, Resize, ToggleSplit,
+            ScratchpadShow, ScratchpadShowNext, ScratchpadShowPrev, ScratchpadHide,
+            Exec
+        };
+        enum class Direction : uint8_t { Left, Right, Up, Down };
+        
+        Op op{Op::Invalid};
+        int workspace{0};
+        Direction direction{Direction::Left};
+        std::string argument;       ///< Layout name or command line
+    };
+    
     KeybindManager();
     
+    /** @brief Parse "workspace 3", "exec kitty", ...; Op::Invalid if unrecognised */
+    static Action parseAction(const std::string& action);
+    
     void registerKeybind(const std::string& keybind_string, const std::string& action);
     
     void registerDefaultKeybind(const std::string& keybind_string, const std::string& action);
     
+    /**
+     * @brief Dispatch a press; auto-repeats of resize/swap binds already
+     * queued behind it are merged into one action with a repeat count
+     */
     void handleKeyPress(const XKeyEvent& event, WindowManager* wm);
     
+    /** @brief Drop repeats of a coalesced bind still queued behind its release */
+    void handleKeyRelease(const XKeyEvent& event);
+    
     void grabKeys(Display* display, Window root);
     
-    void clearKeybinds() { keybinds_.clear(); }
+    void clearKeybinds() {
+        keybinds_.clear();
+        dispatch_.clear();
+    }
+    
+    /**
+     * @brief Rebuild the keycode dispatch table after a MappingNotify
+     *
+     * Keycodes are resolved here and when grabbing, never on a key press.
+     */
+    void refreshKeymap(Display* display, Window root) { grabKeys(display, root); }
+    
+    /** @brief Grabs changed by syncKeybinds() */
+    struct SyncStats {
+        size_t added{0};
+        size_t removed{0};
+        size_t rebound{0};   ///< Same key combo, different action (no regrab)
+    };
+    
+    /**
+     * @brief Replace the keybind set with @p binds ({keybind string, action})
+     *
+     * Only combos that appear or disappear are grabbed or ungrabbed; combos
+     * kept with a new action just have their action swapped. Later entries
+     * win for duplicate combos, as with registerKeybind().
+     */
+    SyncStats syncKeybinds(const std::vector<std::pair<std::string, std::string>>& binds,
+                           Display* display, Window root);
+    
+    /**
+     * @brief Run a named action ("workspace 3", "exec kitty", ...)
+     * @return false if the action is not recognised
+     */
+    bool executeAction(const std::string& action, WindowManager* wm);
+    
+    /**
+     * @brief Run a pre-parsed action; false for Op::Invalid
+     * @param count Merged auto-repeats; scales resize and swap, ignored otherwise
+     */
+    bool executeAction(const Action& action, WindowManager* wm, int count = 1);
     
 private:
     
@@ -37,23 +107,43 @@ private:
         unsigned int modifiers;  
         KeySym keysym;          
         std::string action;      
-        std::string exec_command; 
+        Action parsed;
     };
     
     std::vector<Keybind> keybinds_;
     
+    /** @brief (keycode << 8 | modifiers) -> index into keybinds_ */
+    std::unordered_map<uint32_t, uint32_t> dispatch_;
+    
+    static constexpr unsigned int BIND_MODIFIERS = ShiftMask | ControlMask | Mod1Mask | Mod4Mask;
+    
+    static uint32_t dispatchKey(KeyCode keycode, unsigned int modifiers) {
+        return (static_cast<uint32_t>(keycode) << 8) | (modifiers & BIND_MODIFIERS);
+    }
+    
+    void rebuildDispatch(Display* display);
+    
+    /** @brief Resize and swap repeat while held; everything else fires once */
+    static bool isCoalesced(Action::Op op) {
+        return op == Action::Op::Resize || op == Action::Op::Swap;
+    }
+    
+    /** @brief Remove queued repeats of @p event's key; returns how many */
+    static int takeQueuedRepeats(const XKeyEvent& event);
+    
     inline void reserveKeybinds(size_t size) { keybinds_.reserve(size); }
     
+    Keybind makeKeybind(const std::string& keybind_string, const std::string& action);
+    
     unsigned int parseModifiers(const std::string& modifiers);
     
     KeySym parseKey(const std::string& key);
     
-    void executeAction(const std::string& action, WindowManager* wm);
-    
-    void executeCommand(const std::string& command);
-    
     void grabKeyWithLocks(Display* display, KeyCode keycode, 
                           unsigned int modifiers, Window root);
+    
+    void ungrabKeyWithLocks(Display* display, KeyCode keycode,
+                            unsigned int modifiers, Window root);
 };
 
 } 
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "pointblank/config/ConfigParser.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace pblank {
+
+/**
+ * @brief Merged outcome of every window rule that matched a window
+ */
+struct WindowRuleDecision {
+    std::optional<bool> floating;
+    std::optional<int> workspace;      ///< 1-based
+    std::optional<double> opacity;
+    std::optional<int> border_width;
+
+    bool empty() const { return !floating && !workspace && !opacity && !border_width; }
+};
+
+/**
+ * @brief Per-window rules compiled once at config load
+ *
+ * Exact class and instance criteria are hash lookups. Title globs share one
+ * Aho-Corasick automaton built over each glob's longest literal run; only
+ * globs whose literal occurs in the title are then verified. A rule matches
+ * when every criterion it names was hit, and the outcomes of all matching
+ * rules are merged in config order (later rules win). Rules compiled to
+ * bytecode are run on every match and contribute whatever they assign.
+ *
+ * match() touches no X state, so it is run once per map against the
+ * properties ManagedWindow has already cached.
+ */
+class WindowRuleMatcher {
+public:
+    void compile(const std::vector<Config::WindowRule>& rules);
+
+    WindowRuleDecision match(const bytecode::WindowProperties& window) const;
+
+    size_t size() const { return outcomes_.size(); }
+
+private:
+    struct StringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+    using Index = std::unordered_map<std::string, std::vector<uint32_t>, StringHash, std::equal_to<>>;
+
+    struct TitleGlob {
+        std::string pattern;
+        uint32_t rule;
+    };
+
+    /** @brief Automaton node; edges are sorted by byte */
+    struct Node {
+        std::vector<std::pair<unsigned char, uint32_t>> edges;
+        uint32_t fail{0};
+        std::vector<uint32_t> globs;       ///< Globs whose literal ends here (fail chain merged)
+    };
+
+    std::vector<WindowRuleDecision> outcomes_;   ///< Decision table, one row per rule
+    std::vector<uint8_t> required_;              ///< Criteria each rule needs hit
+
+    Index by_class_;
+    Index by_instance_;
+    Index by_title_;                             ///< Titles without wildcards
+
+    std::vector<TitleGlob> globs_;
+    std::vector<uint32_t> unanchored_globs_;     ///< No literal run ("*", "?*"), always verified
+    std::vector<Node> nodes_;
+
+    std::vector<std::pair<uint32_t, bytecode::Program>> programs_;
+    mutable bytecode::VM vm_;
+
+    void addLiteral(std::string_view literal, uint32_t glob);
+    void buildFailLinks();
+    uint32_t step(uint32_t state, unsigned char c) const;
+};
+
+}
@@ -0,0 +1,483 @@
+#include "pointblank/config/ConfigCache.hpp"
+#include "pointblank/config/ConfigParser.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <type_traits>
+#include <fcntl.h>
+#include <pwd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pblank {
+
+namespace {
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t config_size;       // sizeof(Config) of the writer
+    uint32_t source_count;
+    uint64_t payload_size;
+    uint64_t payload_hash;
+};
+
+template<typename T, typename U>
+concept Is = std::is_same_v<std::remove_const_t<T>, U>;
+
+template<typename T>
+struct IsOptional : std::false_type {};
+template<typename T>
+struct IsOptional<std::optional<T>> : std::true_type {};
+
+template<typename T>
+struct IsVector : std::false_type {};
+template<typename T>
+struct IsVector<std::vector<T>> : std::true_type {};
+
+template<typename T>
+struct IsMap : std::false_type {};
+template<typename K, typename V>
+struct IsMap<std::unordered_map<K, V>> : std::true_type {};
+
+template<typename T>
+struct IsVariant : std::false_type {};
+template<typename... Ts>
+struct IsVariant<std::variant<Ts...>> : std::true_type {};
+
+
+// Field lists shared by the writer and the reader. Keep them in declaration
+// order and bump ConfigCache::FORMAT_VERSION when they change.
+
+template<typename A, Is<Config::WindowRules> T>
+void fields(A& ar, T& c) { ar(c.opacity, c.blur, c.border_width, c.gap_size); }
+
+template<typename A, Is<Config::WindowRule> T>
+void fields(A& ar, T& c) {
+    ar(c.window_class, c.instance, c.title, c.floating, c.workspace, c.opacity, c.border_width, c.program);
+}
+
+template<typename A, Is<bytecode::Instruction> T>
+void fields(A& ar, T& c) { ar(c.op, c.dst, c.a, c.b, c.imm); }
+
+template<typename A, Is<bytecode::Program> T>
+void fields(A& ar, T& c) { ar(c.code, c.numbers, c.strings, c.arrays, c.registers); }
+
+template<typename A, Is<Config::Keybind> T>
+void fields(A& ar, T& c) { ar(c.modifiers, c.key, c.action, c.exec_command); }
+
+template<typename A, Is<Config::DragConfig> T>
+void fields(A& ar, T& c) { ar(c.swap_on_drag, c.threshold, c.swap_threshold, c.visual_feedback); }
+
+template<typename A, Is<Config::BordersConfig> T>
+void fields(A& ar, T& c) { ar(c.focused_color, c.unfocused_color, c.urgent_color, c.width); }
+
+template<typename A, Is<Config::MouseConfig> T>
+void fields(A& ar, T& c) { ar(c.focus_follows_mouse, c.mouse_warping, c.cursor_speed); }
+
+template<typename A, Is<Config::AnimationsConfig> T>
+void fields(A& ar, T& c) { ar(c.enabled, c.curve, c.duration); }
+
+template<typename A, Is<Config::PerformanceConfig> T>
+void fields(A& ar, T& c) {
+    ar(c.scheduler_policy, c.scheduler_priority,
+       c.cpu_cores, c.cpu_exclusive, c.hyperthreading_aware,
+       c.realtime_mode, c.realtime_priority, c.lock_memory, c.locked_memory_mb,
+       c.target_fps, c.min_fps, c.max_fps, c.vsync, c.adaptive_sync,
+       c.throttle_threshold_us, c.throttle_delay_us, c.throttle_on_battery,
+       c.max_batch_size, c.batch_timeout_us,
+       c.dirty_rectangles_only, c.double_buffer, c.triple_buffer,
+       c.metrics_enabled, c.metrics_interval_ms, c.latency_tracking);
+}
+
+template<typename A, Is<Config::ExtensionsConfig> T>
+void fields(A& ar, T& c) {
+    ar(c.enabled, c.strict_validation, c.health_check_interval_s,
+       c.builtin_extension_dir, c.user_extension_dir,
+       c.init_timeout_ms, c.max_extensions, c.allow_event_blocking);
+}
+
+template<typename A, Is<Config::WorkspaceConfig> T>
+void fields(A& ar, T& c) {
+    ar(c.infinite, c.max_workspaces, c.initial_count, c.dynamic_creation,
+       c.auto_remove, c.min_persist, c.per_monitor, c.virtual_mapping,
+       c.workspace_to_monitor);
+}
+
+template<typename A, Is<Config::StatusBarConfig> T>
+void fields(A& ar, T& c) {
+    ar(c.height, c.padding_x, c.padding_y, c.position,
+       c.bg_color, c.fg_color, c.accent_color, c.urgent_color, c.inactive_bg,
+       c.font_family, c.font_size,
+       c.show_workspace_icons, c.show_layout_mode, c.show_window_title,
+       c.workspace_clickable, c.enabled, c.shared_state,
+       c.workspace_icons);
+}
+
+template<typename A, Is<Config::WindowsConfig> T>
+void fields(A& ar, T& c) {
+    ar(c.auto_resize_non_docks, c.floating_resize_enabled, c.floating_resize_edge_size,
+       c.smart_gaps, c.smart_borders, c.focus_new_windows, c.focus_urgent_windows,
+       c.default_floating_width, c.default_floating_height, c.center_floating_windows);
+}
+
+template<typename A, Is<Config::LayoutGapConfig> T>
+void fields(A& ar, T& c) {
+    ar(c.inner_gap, c.outer_gap, c.top_gap, c.bottom_gap, c.left_gap, c.right_gap);
+}
+
+template<typename A, Is<Config::AutostartConfig> T>
+void fields(A& ar, T& c) { ar(c.commands, c.xdg); }
+
+template<typename A, Is<Config::LayoutConfig> T>
+void fields(A& ar, T& c) { ar(c.cycle_direction, c.wrap_cycle); }
+
+template<typename A, Is<Config> T>
+void fields(A& ar, T& c) {
+    ar(c.focus_follows_mouse, c.monitor_focus_follows_mouse,
+       c.window_rules, c.per_window_rules, c.keybinds, c.drag, c.borders, c.workspaces,
+       c.status_bar, c.layout, c.windows, c.layout_gaps, c.autostart,
+       c.mouse, c.animations, c.performance, c.extensions,
+       c.system_paths, c.variables, c.config_version, c.is_v2_format);
+}
+
+
+class Writer {
+public:
+    std::string buf;
+
+    template<typename... Ts>
+    void operator()(const Ts&... values) { (put(values), ...); }
+
+private:
+    template<typename T>
+    void put(const T& value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            buf += static_cast<char>(value ? 1 : 0);
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            buf.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        } else if constexpr (std::is_enum_v<T>) {
+            put(static_cast<std::underlying_type_t<T>>(value));
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            put(static_cast<uint32_t>(value.size()));
+            buf.append(value);
+        } else if constexpr (IsOptional<T>::value) {
+            put(value.has_value());
+            if (value) put(*value);
+        } else if constexpr (IsVector<T>::value || IsMap<T>::value) {
+            put(static_cast<uint32_t>(value.size()));
+            for (const auto& element : value) put(element);
+        } else if constexpr (IsVariant<T>::value) {
+            put(static_cast<uint8_t>(value.index()));
+            std::visit([this](const auto& alt) { put(alt); }, value);
+        } else if constexpr (requires { value.first; value.second; }) {
+            put(value.first);
+            put(value.second);
+        } else {
+            fields(*this, value);
+        }
+    }
+};
+
+
+class Reader {
+public:
+    Reader(const char* data, size_t size) : p_(data), end_(data + size) {}
+
+    template<typename... Ts>
+    void operator()(Ts&... values) { (get(values), ...); }
+
+    bool ok() const { return ok_; }
+    bool atEnd() const { return p_ == end_; }
+    const char* position() const { return p_; }
+    size_t remaining() const { return static_cast<size_t>(end_ - p_); }
+
+private:
+    const char* p_;
+    const char* end_;
+    bool ok_{true};
+
+    bool take(void* out, size_t n) {
+        if (!ok_ || remaining() < n) {
+            ok_ = false;
+            return false;
+        }
+        std::memcpy(out, p_, n);
+        p_ += n;
+        return true;
+    }
+
+    uint32_t count() {
+        uint32_t n = 0;
+        get(n);
+        // Every element takes at least one byte; reject counts that could
+        // not fit before allocating for them.
+        if (n > remaining()) {
+            ok_ = false;
+            return 0;
+        }
+        return n;
+    }
+
+    template<size_t I = 0, typename... Ts>
+    void getAlternative(std::variant<Ts...>& value, size_t index) {
+        if constexpr (I < sizeof...(Ts)) {
+            if (index == I) {
+                get(value.template emplace<I>());
+            } else {
+                getAlternative<I + 1>(value, index);
+            }
+        } else {
+            ok_ = false;
+        }
+    }
+
+    template<typename T>
+    void get(T& value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            uint8_t b = 0;
+            take(&b, 1);
+            value = b != 0;
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            take(&value, sizeof(value));
+        } else if constexpr (std::is_enum_v<T>) {
+            std::underlying_type_t<T> raw{};
+            get(raw);
+            value = static_cast<T>(raw);
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            uint32_t n = count();
+            if (ok_) {
+                value.assign(p_, n);
+                p_ += n;
+            }
+        } else if constexpr (IsOptional<T>::value) {
+            bool present = false;
+            get(present);
+            if (present) {
+                get(value.emplace());
+            } else {
+                value.reset();
+            }
+        } else if constexpr (IsVector<T>::value) {
+            uint32_t n = count();
+            value.clear();
+            value.resize(n);
+            for (auto& element : value) get(element);
+        } else if constexpr (IsMap<T>::value) {
+            uint32_t n = count();
+            value.clear();
+            value.reserve(n);
+            for (uint32_t i = 0; i < n && ok_; ++i) {
+                typename T::key_type key{};
+                typename T::mapped_type mapped{};
+                get(key);
+                get(mapped);
+                value.emplace(std::move(key), std::move(mapped));
+            }
+        } else if constexpr (IsVariant<T>::value) {
+            uint8_t index = 0;
+            get(index);
+            getAlternative(value, index);
+        } else {
+            fields(*this, value);
+        }
+    }
+};
+
+
+bool readFile(const std::filesystem::path& path, std::string& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    out = buffer.str();
+    return true;
+}
+
+bool writeAll(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+}
+
+
+
+
+
+ConfigCache::ConfigCache(std::filesystem::path path) : path_(std::move(path)) {}
+
+std::filesystem::path ConfigCache::getDefaultCachePath() {
+    if (auto xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return std::filesystem::path(xdg) / "pblank" / "config.cache";
+    }
+    if (auto home = std::getenv("HOME"); home && *home) {
+        return std::filesystem::path(home) / ".cache" / "pblank" / "config.cache";
+    }
+
+    // The cache carries exec keybinds and autostart commands, so it never
+    // goes anywhere another user could plant or redirect it
+    struct passwd* pw = getpwuid(getuid());
+    if (pw && pw->pw_dir && *pw->pw_dir) {
+        return std::filesystem::path(pw->pw_dir) / ".cache" / "pblank" / "config.cache";
+    }
+    return {};
+}
+
+uint64_t ConfigCache::hash(std::string_view data) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+std::string ConfigCache::encode(const Config& config) {
+    Writer writer;
+    writer(config);
+    return std::move(writer.buf);
+}
+
+bool ConfigCache::decode(std::string_view payload, Config& out) {
+    Reader reader(payload.data(), payload.size());
+    Config config;
+    reader(config);
+    if (!reader.ok() || !reader.atEnd()) {
+        return false;
+    }
+    out = std::move(config);
+    return true;
+}
+
+ConfigCache::Source ConfigCache::describe(const std::filesystem::path& path) {
+    Source source;
+    source.path = path;
+    std::string content;
+    if (readFile(path, content)) {
+        source.hash = hash(content);
+        source.exists = true;
+    }
+    return source;
+}
+
+bool ConfigCache::load(const Source& main, Config& out) const {
+    if (path_.empty()) {
+        return false;
+    }
+    int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(CacheHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    const char* base = static_cast<const char*>(map);
+    bool hit = false;
+
+    CacheHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (header.magic == MAGIC && header.version == FORMAT_VERSION &&
+        header.config_size == sizeof(Config) && header.source_count > 0) {
+
+        Reader reader(base + sizeof(header), size - sizeof(header));
+        bool fresh = true;
+        for (uint32_t i = 0; i < header.source_count && fresh && reader.ok(); ++i) {
+            std::string path;
+            uint64_t stored_hash = 0;
+            bool exists = false;
+            reader(path, stored_hash, exists);
+            if (!reader.ok()) break;
+
+            if (i == 0) {
+                fresh = path == main.path.string() && stored_hash == main.hash;
+            } else {
+                Source now = describe(path);
+                fresh = now.exists == exists && now.hash == stored_hash;
+            }
+        }
+
+        std::string_view payload(reader.position(), reader.remaining());
+        if (fresh && reader.ok() && payload.size() == header.payload_size &&
+            hash(payload) == header.payload_hash) {
+            hit = decode(payload, out);
+        }
+    }
+
+    munmap(map, size);
+    return hit;
+}
+
+bool ConfigCache::store(const std::vector<Source>& sources, const Config& config) const {
+    if (sources.empty() || path_.empty()) {
+        return false;
+    }
+
+    Writer prefix;
+    for (const auto& source : sources) {
+        prefix(source.path.string(), source.hash, source.exists);
+    }
+
+    std::string payload = encode(config);
+
+    CacheHeader header{};
+    header.magic = MAGIC;
+    header.version = FORMAT_VERSION;
+    header.config_size = sizeof(Config);
+    header.source_count = static_cast<uint32_t>(sources.size());
+    header.payload_size = payload.size();
+    header.payload_hash = hash(payload);
+
+    std::error_code ec;
+    std::filesystem::create_directories(path_.parent_path(), ec);
+
+    // mkstemp gives a fresh 0600 file that cannot be a planted symlink, and
+    // a unique name per call: the watcher and main thread share one pid
+    std::string tmp = path_.string() + ".XXXXXX";
+    int fd = mkostemp(tmp.data(), O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool written = writeAll(fd, reinterpret_cast<const char*>(&header), sizeof(header)) &&
+                   writeAll(fd, prefix.buf.data(), prefix.buf.size()) &&
+                   writeAll(fd, payload.data(), payload.size());
+    if (::close(fd) < 0 || !written) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+
+    std::filesystem::rename(tmp, path_, ec);
+    if (ec) {
+        std::cerr << "[ConfigCache] Failed to write " << path_ << ": " << ec.message() << std::endl;
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+}
@@ -5,15 +5,282 @@
 #include <sstream>
 #include <cctype>
 #include <algorithm>
+#include <charconv>
 #include <iostream>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 
 namespace pblank {
 
+namespace {
+
+/** @brief The property name if expr is `window.<member>`, else empty */
+std::string_view windowMember(const ast::Expression& expr) {
+    auto* access = std::get_if<ast::MemberAccess>(&expr.value);
+    if (!access || !access->object) return {};
+    auto* object = std::get_if<ast::Identifier>(&access->object->value);
+    return object && object->name == "window" ? access->member : std::string_view{};
+}
+
+bool isRuleSetting(std::string_view name) {
+    return name == "floating" || name == "float" || name == "workspace" ||
+           name == "opacity" || name == "border_width";
+}
+
+std::string importKey(const ast::ImportDirective& import) {
+    return (import.is_user_extension ? "user:" : "pb:") + import.module_name;
+}
+
+/** @brief Parsed import files shared by every ConfigParser, keyed by path */
+struct ModuleCache {
+    struct Entry {
+        std::filesystem::file_time_type mtime;
+        uintmax_t size{0};
+        std::shared_ptr<const ast::Module> module;
+    };
+    
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+};
+
+ModuleCache& moduleCache() {
+    static ModuleCache cache;
+    return cache;
+}
+
+struct FileStamp {
+    std::filesystem::file_time_type mtime;
+    uintmax_t size{0};
+    bool ok{false};
+};
+
+FileStamp stampOf(const std::filesystem::path& path) {
+    FileStamp stamp;
+    std::error_code ec;
+    stamp.mtime = std::filesystem::last_write_time(path, ec);
+    stamp.size = ec ? 0 : std::filesystem::file_size(path, ec);
+    stamp.ok = !ec;
+    return stamp;
+}
+
+/** @brief The cached module for @p path if the file is unchanged, else null */
+std::shared_ptr<const ast::Module> cachedModule(const std::filesystem::path& path, const FileStamp& stamp) {
+    if (!stamp.ok) {
+        return nullptr;
+    }
+    auto& cache = moduleCache();
+    std::lock_guard lock(cache.mutex);
+    auto it = cache.entries.find(path.string());
+    if (it != cache.entries.end() && it->second.mtime == stamp.mtime && it->second.size == stamp.size) {
+        return it->second.module;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const ast::Module> parseModule(const std::filesystem::path& path, const FileStamp& stamp) {
+    auto& cache = moduleCache();
+    if (auto module = cachedModule(path, stamp)) {
+        return module;
+    }
+    
+    
+    auto module = std::make_shared<ast::Module>();
+    module->path = path;
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        module->errors.push_back("Could not open import file: " + path.string());
+        return module;
+    }
+    module->source.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    module->hash = ConfigCache::hash(module->source);
+    
+    // Touched but unchanged (e.g. an editor rewriting the same bytes)
+    {
+        std::lock_guard lock(cache.mutex);
+        auto it = cache.entries.find(path.string());
+        if (it != cache.entries.end() && it->second.module->hash == module->hash) {
+            if (stamp.ok) {
+                it->second.mtime = stamp.mtime;
+                it->second.size = stamp.size;
+            }
+            return it->second.module;
+        }
+    }
+    
+    
+    Lexer lexer(module->source);
+    auto tokens = lexer.tokenize();
+    module->errors = lexer.getErrors();
+    if (module->errors.empty()) {
+        Parser parser(std::move(tokens));
+        module->file = parser.parse();
+        module->errors = parser.getErrors();
+        if (!module->file && module->errors.empty()) {
+            module->errors.push_back("Failed to parse import");
+        }
+    }
+    
+    if (stamp.ok) {
+        std::lock_guard lock(cache.mutex);
+        cache.entries[path.string()] = {stamp.mtime, stamp.size, module};
+    }
+    return module;
+}
+
+/** @brief Drop cached modules for files outside the import closure @p live */
+void pruneModuleCache(const std::unordered_set<std::string>& live) {
+    auto& cache = moduleCache();
+    std::lock_guard lock(cache.mutex);
+    std::erase_if(cache.entries, [&](const auto& entry) { return !live.count(entry.first); });
+}
+
+/**
+ * @brief Import parsers kept alive across loads
+ *
+ * hardware_concurrency - 1 threads, started on the first load with more
+ * than one import to parse. run() hands out indices to the workers and
+ * the calling thread and returns when all of them are done; concurrent
+ * loads take turns.
+ */
+class ModulePool {
+public:
+    static ModulePool& instance() {
+        static ModulePool pool;
+        return pool;
+    }
+    
+    bool empty() const { return threads_.empty(); }
+    
+    void run(size_t count, const std::function<void(size_t)>& fn) {
+        std::lock_guard batch(run_mutex_);
+        {
+            std::lock_guard lock(mutex_);
+            job_ = &fn;
+            count_ = count;
+            next_.store(0, std::memory_order_relaxed);
+            ++generation_;
+        }
+        wake_.notify_all();
+        drain(&fn, count);
+        
+        std::unique_lock lock(mutex_);
+        done_.wait(lock, [this] { return active_ == 0; });
+        // Workers that wake after this see no job and go back to sleep
+        job_ = nullptr;
+    }
+    
+private:
+    std::mutex run_mutex_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::function<void(size_t)>* job_ = nullptr;
+    size_t count_ = 0;
+    std::atomic<size_t> next_{0};
+    size_t active_ = 0;
+    uint64_t generation_ = 0;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+    
+    ModulePool() {
+        unsigned workers = std::thread::hardware_concurrency();
+        for (unsigned i = 1; i < workers; ++i) {
+            threads_.emplace_back([this] { work(); });
+        }
+    }
+    
+    ~ModulePool() {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+    
+    void drain(const std::function<void(size_t)>* job, size_t count) {
+        for (size_t i; (i = next_.fetch_add(1, std::memory_order_relaxed)) < count; ) {
+            (*job)(i);
+        }
+    }
+    
+    void work() {
+        uint64_t seen = 0;
+        std::unique_lock lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = generation_;
+            if (!job_) {
+                continue;
+            }
+            
+            const auto* job = job_;
+            size_t count = count_;
+            ++active_;
+            lock.unlock();
+            drain(job, count);
+            lock.lock();
+            if (--active_ == 0) {
+                done_.notify_all();
+            }
+        }
+    }
+};
+
+/** @brief parseModule() over @p paths; only cache misses go to the pool */
+std::vector<std::shared_ptr<const ast::Module>> parseModules(const std::vector<std::filesystem::path>& paths) {
+    std::vector<std::shared_ptr<const ast::Module>> modules(paths.size());
+    std::vector<FileStamp> stamps(paths.size());
+    std::vector<size_t> misses;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        stamps[i] = stampOf(paths[i]);
+        modules[i] = cachedModule(paths[i], stamps[i]);
+        if (!modules[i]) {
+            misses.push_back(i);
+        }
+    }
+    
+    auto parse = [&](size_t k) {
+        size_t i = misses[k];
+        modules[i] = parseModule(paths[i], stamps[i]);
+    };
+    if (misses.size() <= 1 || ModulePool::instance().empty()) {
+        for (size_t k = 0; k < misses.size(); ++k) {
+            parse(k);
+        }
+    } else {
+        ModulePool::instance().run(misses.size(), parse);
+    }
+    return modules;
+}
+
+bool referencesWindow(const ast::Expression& expr) {
+    if (!windowMember(expr).empty()) return true;
+    if (auto* bin = std::get_if<ast::BinaryOp>(&expr.value)) {
+        return referencesWindow(*bin->left) || referencesWindow(*bin->right);
+    }
+    if (auto* un = std::get_if<ast::UnaryOp>(&expr.value)) {
+        return referencesWindow(*un->operand);
+    }
+    return false;
+}
+
+}
+
 
 
 
 
-Lexer::Lexer(std::string source) : source_(std::move(source)) {}
+Lexer::Lexer(std::string_view source) : source_(source) {}
 
 std::vector<Token> Lexer::tokenize() {
     std::vector<Token> tokens;
@@ -155,7 +422,7 @@ std::vector<Token> Lexer::tokenize() {
         }
     }
     
-    tokens.emplace_back(Token(TokenType::EndOfFile, "", line_, column_));
+    tokens.emplace_back(Token(TokenType::EndOfFile, std::string_view{}, line_, column_));
     return tokens;
 }
 
@@ -205,7 +472,7 @@ Token Lexer::makeToken(TokenType type) {
     
     
     
-    return Token(type, std::string{}, line_, column_);
+    return Token(type, std::string_view{}, line_, column_);
 }
 
 Token Lexer::number() {
@@ -223,12 +490,18 @@ Token Lexer::number() {
         while (!isAtEnd() && std::isdigit(peek())) {
             advance();
         }
-        std::string num(source_.data() + start, current_ - start);
-        return Token(TokenType::Float, num, start_line, start_col, std::stod(num));
+        std::string_view num = source_.substr(start, current_ - start);
+        double value = 0.0;
+        std::from_chars(num.data(), num.data() + num.size(), value);
+        return Token(TokenType::Float, num, start_line, start_col, value);
     }
     
-    std::string num(source_.data() + start, current_ - start);
-    return Token(TokenType::Integer, num, start_line, start_col, std::stoi(num));
+    std::string_view num = source_.substr(start, current_ - start);
+    int value = 0;
+    if (std::from_chars(num.data(), num.data() + num.size(), value).ec != std::errc{}) {
+        addError("Integer out of range: " + std::string(num));
+    }
+    return Token(TokenType::Integer, num, start_line, start_col, value);
 }
 
 Token Lexer::string() {
@@ -237,24 +510,35 @@ Token Lexer::string() {
     
     advance(); 
     
-    std::string str;
-    str.reserve(32);  
+    size_t start = current_;
+    bool escaped = false;
     while (!isAtEnd() && peek() != '"') {
         if (peek() == '\\') {
+            escaped = true;
             advance();
-            if (!isAtEnd()) {
-                char c = advance();
-                switch (c) {
-                    case 'n': str += '\n'; break;
-                    case 't': str += '\t'; break;
-                    case '"': str += '"'; break;
-                    case '\\': str += '\\'; break;
-                    default: str += c; break;
-                }
+            if (isAtEnd()) break;
+        }
+        advance();
+    }
+    
+    std::string_view raw = source_.substr(start, current_ - start);
+    std::string_view str = raw;
+    if (escaped) {
+        // Only literals with escapes need their own storage
+        std::string& decoded = decoded_.emplace_back();
+        decoded.reserve(raw.size());
+        for (size_t i = 0; i < raw.size(); ++i) {
+            if (raw[i] != '\\' || i + 1 >= raw.size()) {
+                decoded += raw[i];
+                continue;
+            }
+            switch (char c = raw[++i]) {
+                case 'n': decoded += '\n'; break;
+                case 't': decoded += '\t'; break;
+                default: decoded += c; break;
             }
-        } else {
-            str += advance();
         }
+        str = decoded;
     }
     
     if (isAtEnd()) {
@@ -277,22 +561,20 @@ Token Lexer::identifier() {
     }
     
     
-    std::string text(source_.data() + start, current_ - start);
-    
-    std::string_view text_view(text);
+    std::string_view text_view = source_.substr(start, current_ - start);
     TokenType type = TokenType::Identifier;
     if (text_view == "let") type = TokenType::Let;
     else if (text_view == "if") type = TokenType::If;
     else if (text_view == "else") type = TokenType::Else;
     else if (text_view == "exec") type = TokenType::Exec;
     else if (text_view == "true") {
-        return Token(TokenType::TokTrue, text, start_line, start_col, true);
+        return Token(TokenType::TokTrue, text_view, start_line, start_col, true);
     }
     else if (text_view == "false") {
-        return Token(TokenType::TokFalse, text, start_line, start_col, false);
+        return Token(TokenType::TokFalse, text_view, start_line, start_col, false);
     }
     
-    return Token(type, std::move(text), start_line, start_col);
+    return Token(type, text_view, start_line, start_col);
 }
 
 Token Lexer::preprocessor() {
@@ -305,7 +587,7 @@ Token Lexer::preprocessor() {
     while (!isAtEnd() && std::isalpha(peek())) {
         advance();
     }
-    std::string directive(source_.data() + dir_start, current_ - dir_start);
+    std::string_view directive = source_.substr(dir_start, current_ - dir_start);
     
     skipWhitespace();
     
@@ -313,16 +595,15 @@ Token Lexer::preprocessor() {
     while (!isAtEnd() && !std::isspace(peek())) {
         advance();
     }
-    std::string name(source_.data() + name_start, current_ - name_start);
+    std::string_view name = source_.substr(name_start, current_ - name_start);
     
-    std::string_view dir_view(directive);
     TokenType type = TokenType::Invalid;
-    if (dir_view == "import") {
+    if (directive == "import") {
         type = TokenType::Import;
-    } else if (dir_view == "include") {
+    } else if (directive == "include") {
         type = TokenType::Include;
     } else {
-        addError("Unknown preprocessor directive: #" + directive);
+        addError("Unknown preprocessor directive: #" + std::string(directive));
     }
     
     return Token(type, name, start_line, start_col, name);
@@ -383,12 +664,21 @@ const Token& Parser::consume(TokenType type, const std::string& message) {
     return peek();
 }
 
+template<typename T>
+std::span<T*> Parser::takeFrom(std::vector<T*>& stack, size_t mark) {
+    // Children are pushed on a shared stack while their parent is open and
+    // moved into the arena in one piece when it closes.
+    auto out = arena_->copy(stack.data() + mark, stack.size() - mark);
+    stack.resize(mark);
+    return out;
+}
+
 std::unique_ptr<ast::ConfigFile> Parser::configFile() {
     auto config = std::make_unique<ast::ConfigFile>();
+    arena_ = &config->arena;
     
     
-    auto toplevel_block = std::make_unique<ast::Block>();
-    toplevel_block->name = "toplevel";
+    size_t toplevel_mark = statement_stack_.size();
     
     std::cerr << "[Parser] configFile() starting, current token: " << peek().lexeme << std::endl;
     
@@ -422,9 +712,9 @@ std::unique_ptr<ast::ConfigFile> Parser::configFile() {
                         std::cerr << "[Parser] Block parsed, name: " << blk->name << std::endl;
                         
                         if (!config->root) {
-                            config->root = std::move(blk);
+                            config->root = blk;
                         } else {
-                            config->blocks.emplace_back(std::move(blk));
+                            config->blocks.push_back(blk);
                         }
                     }
                     continue;
@@ -440,15 +730,16 @@ std::unique_ptr<ast::ConfigFile> Parser::configFile() {
         auto stmt = statement();
         if (stmt) {
             
-            toplevel_block->statements.emplace_back(std::move(stmt));
+            statement_stack_.push_back(stmt);
         } else {
             break;
         }
     }
     
     
-    if (!toplevel_block->statements.empty()) {
-        config->blocks.emplace_back(std::move(toplevel_block));
+    if (statement_stack_.size() > toplevel_mark) {
+        config->blocks.push_back(arena_->make<ast::Block>(
+            std::string_view("toplevel"), takeFrom(statement_stack_, toplevel_mark)));
     }
     
     return config;
@@ -464,7 +755,7 @@ std::vector<ast::ImportDirective> Parser::imports() {
         std::string name;
         
         
-        if (auto* val = std::get_if<std::string>(&previous().literal_value)) {
+        if (auto* val = std::get_if<std::string_view>(&previous().literal_value)) {
             name = *val;
         }
         
@@ -478,26 +769,24 @@ std::vector<ast::ImportDirective> Parser::imports() {
     return result;
 }
 
-std::unique_ptr<ast::Block> Parser::block() {
+ast::Block* Parser::block() {
     std::cerr << "[Parser] block() called, current token: " << peek().lexeme << std::endl;
     if (!check(TokenType::Identifier)) {
         addError("Expected block name, got: " + std::string(peek().lexeme));
         return nullptr;
     }
     
-    std::string name{advance().lexeme};
+    std::string_view name = arena_->copy(advance().lexeme);
     std::cerr << "[Parser] block name: " << name << std::endl;
     
     consume(TokenType::Colon, "Expected ':' after block name");
     consume(TokenType::LeftBrace, "Expected '{' to start block");
     
-    auto blk = std::make_unique<ast::Block>();
-    blk->name = name;
-    
+    size_t mark = statement_stack_.size();
     while (!check(TokenType::RightBrace) && !isAtEnd()) {
         auto stmt = statement();
         if (stmt) {
-            blk->statements.push_back(std::move(stmt));
+            statement_stack_.push_back(stmt);
         }
     }
     
@@ -506,10 +795,10 @@ std::unique_ptr<ast::Block> Parser::block() {
     
     match({TokenType::Semicolon});
     
-    return blk;
+    return arena_->make<ast::Block>(name, takeFrom(statement_stack_, mark));
 }
 
-std::unique_ptr<ast::Statement> Parser::statement() {
+ast::Statement* Parser::statement() {
     
     if (match({TokenType::Let})) {
         return letStatement();
@@ -528,11 +817,9 @@ std::unique_ptr<ast::Statement> Parser::statement() {
             return nullptr;
         }
         
-        std::string command = std::get<std::string>(advance().literal_value);
+        std::string_view command = std::get<std::string_view>(advance().literal_value);
         
-        auto stmt = std::make_unique<ast::Statement>();
-        stmt->value = ast::ExecDirective{command};
-        return stmt;
+        return arena_->make<ast::Statement>(ast::ExecDirective{arena_->copy(command)});
     }
     
     
@@ -547,11 +834,9 @@ std::unique_ptr<ast::Statement> Parser::statement() {
             current_ = saved;
         } else {
             
-            std::string command = std::get<std::string>(previous().literal_value);
+            std::string_view command = std::get<std::string_view>(previous().literal_value);
             
-            auto stmt = std::make_unique<ast::Statement>();
-            stmt->value = ast::ExecDirective{command};
-            return stmt;
+            return arena_->make<ast::Statement>(ast::ExecDirective{arena_->copy(command)});
         }
     }
     
@@ -560,36 +845,33 @@ std::unique_ptr<ast::Statement> Parser::statement() {
     if (check(TokenType::Identifier)) {
         
         size_t saved = current_;
-        std::string first_token{advance().lexeme};
+        std::string_view first_token = advance().lexeme;
         
         if (check(TokenType::Colon)) {
             
             current_ = saved;
         } else {
             
-            std::string command = first_token;
+            std::string command{first_token};
             
             
             
             
             while (!check(TokenType::Semicolon) && !check(TokenType::RightBrace) && !isAtEnd()) {
-                Token tok = advance();
+                const Token& tok = advance();
                 
                 
-                if (tok.type == TokenType::Minus) {
-                    command += std::string{tok.lexeme};  
-                } else {
-                    command += std::string{" "} + std::string{tok.lexeme};
+                if (tok.type != TokenType::Minus) {
+                    command += ' ';
                 }
+                command += tok.lexeme;
             }
             
             
             
             match({TokenType::Semicolon});
             
-            auto stmt = std::make_unique<ast::Statement>();
-            stmt->value = ast::ExecDirective{command};
-            return stmt;
+            return arena_->make<ast::Statement>(ast::ExecDirective{arena_->copy(command)});
         }
     }
     
@@ -611,9 +893,10 @@ std::unique_ptr<ast::Statement> Parser::statement() {
                     return nullptr;
                 }
                 auto blk = block();
-                auto stmt = std::make_unique<ast::Statement>();
-                stmt->value = std::move(*blk);
-                return stmt;
+                if (!blk) {
+                    return nullptr;
+                }
+                return arena_->make<ast::Statement>(*blk);
             }
         }
         
@@ -627,33 +910,35 @@ std::unique_ptr<ast::Statement> Parser::statement() {
     return nullptr;
 }
 
-std::unique_ptr<ast::Statement> Parser::ifStatement() {
+ast::Statement* Parser::ifStatement() {
     consume(TokenType::LeftParen, "Expected '(' after if");
     auto condition = expression();
     consume(TokenType::RightParen, "Expected ')' after condition");
     
     consume(TokenType::LeftBrace, "Expected '{' after if condition");
     
-    std::vector<std::unique_ptr<ast::Statement>> then_branch;
+    size_t mark = statement_stack_.size();
     while (!check(TokenType::RightBrace) && !isAtEnd()) {
         auto stmt = statement();
         if (stmt) {
-            then_branch.push_back(std::move(stmt));
+            statement_stack_.push_back(stmt);
         }
     }
+    auto then_branch = takeFrom(statement_stack_, mark);
     
     consume(TokenType::RightBrace, "Expected '}' to close if block");
     
-    std::vector<std::unique_ptr<ast::Statement>> else_branch;
+    std::span<ast::Statement*> else_branch;
     if (match({TokenType::Else})) {
         consume(TokenType::LeftBrace, "Expected '{' after else");
         
         while (!check(TokenType::RightBrace) && !isAtEnd()) {
             auto stmt = statement();
             if (stmt) {
-                else_branch.push_back(std::move(stmt));
+                statement_stack_.push_back(stmt);
             }
         }
+        else_branch = takeFrom(statement_stack_, mark);
         
         consume(TokenType::RightBrace, "Expected '}' to close else block");
     }
@@ -661,26 +946,19 @@ std::unique_ptr<ast::Statement> Parser::ifStatement() {
     
     match({TokenType::Semicolon});
     
-    auto stmt = std::make_unique<ast::Statement>();
-    stmt->value = ast::IfStatement{
-        std::move(condition),
-        std::move(then_branch),
-        std::move(else_branch)
-    };
-    
-    return stmt;
+    return arena_->make<ast::Statement>(ast::IfStatement{condition, then_branch, else_branch});
 }
 
-std::unique_ptr<ast::Statement> Parser::assignment() {
-    std::string name;
+ast::Statement* Parser::assignment() {
+    std::string_view name;
     
     
     
     if (match({TokenType::Identifier})) {
-        name = previous().lexeme;
+        name = arena_->copy(previous().lexeme);
     } else if (match({TokenType::String})) {
-        if (auto* val = std::get_if<std::string>(&previous().literal_value)) {
-            name = *val;
+        if (auto* val = std::get_if<std::string_view>(&previous().literal_value)) {
+            name = arena_->copy(*val);
         }
     } else {
         addError("Expected identifier or string for assignment name");
@@ -697,14 +975,12 @@ std::unique_ptr<ast::Statement> Parser::assignment() {
             return nullptr;
         }
         
-        std::string command = std::get<std::string>(advance().literal_value);
+        std::string command{"exec: "};
+        command += std::get<std::string_view>(advance().literal_value);
         
         
-        auto stmt = std::make_unique<ast::Statement>();
-        auto expr = std::make_unique<ast::Expression>();
-        expr->value = ast::StringLiteral{"exec: " + command};
-        stmt->value = ast::Assignment{name, std::move(expr)};
-        return stmt;
+        auto expr = arena_->make<ast::Expression>(ast::StringLiteral{arena_->copy(command)});
+        return arena_->make<ast::Statement>(ast::Assignment{name, expr});
     }
     
     auto value = expression();
@@ -712,20 +988,17 @@ std::unique_ptr<ast::Statement> Parser::assignment() {
     
     match({TokenType::Semicolon});
     
-    auto stmt = std::make_unique<ast::Statement>();
-    stmt->value = ast::Assignment{name, std::move(value)};
-    
-    return stmt;
+    return arena_->make<ast::Statement>(ast::Assignment{name, value});
 }
 
-std::unique_ptr<ast::Statement> Parser::letStatement() {
+ast::Statement* Parser::letStatement() {
     
     if (!check(TokenType::Identifier)) {
         addError("Expected identifier after 'let'");
         return nullptr;
     }
     
-    std::string name{advance().lexeme};
+    std::string_view name = arena_->copy(advance().lexeme);
     
     consume(TokenType::Assign, "Expected '=' after identifier");
     
@@ -734,54 +1007,36 @@ std::unique_ptr<ast::Statement> Parser::letStatement() {
     
     match({TokenType::Semicolon});
     
-    auto stmt = std::make_unique<ast::Statement>();
-    stmt->value = ast::VariableDeclaration{name, std::move(value)};
-    
-    
-    
-    
-    return stmt;
+    return arena_->make<ast::Statement>(ast::VariableDeclaration{name, value});
 }
 
-std::unique_ptr<ast::Expression> Parser::expression() {
+ast::Expression* Parser::expression() {
     return logicalOr();
 }
 
-std::unique_ptr<ast::Expression> Parser::logicalOr() {
+ast::Expression* Parser::logicalOr() {
     auto left = logicalAnd();
     
     while (match({TokenType::Or})) {
         auto right = logicalAnd();
-        auto expr = std::make_unique<ast::Expression>();
-        expr->value = ast::BinaryOp{
-            ast::BinaryOp::Op::Or,
-            std::move(left),
-            std::move(right)
-        };
-        left = std::move(expr);
+        left = arena_->make<ast::Expression>(ast::BinaryOp{ast::BinaryOp::Op::Or, left, right});
     }
     
     return left;
 }
 
-std::unique_ptr<ast::Expression> Parser::logicalAnd() {
+ast::Expression* Parser::logicalAnd() {
     auto left = equality();
     
     while (match({TokenType::And})) {
         auto right = equality();
-        auto expr = std::make_unique<ast::Expression>();
-        expr->value = ast::BinaryOp{
-            ast::BinaryOp::Op::And,
-            std::move(left),
-            std::move(right)
-        };
-        left = std::move(expr);
+        left = arena_->make<ast::Expression>(ast::BinaryOp{ast::BinaryOp::Op::And, left, right});
     }
     
     return left;
 }
 
-std::unique_ptr<ast::Expression> Parser::equality() {
+ast::Expression* Parser::equality() {
     auto left = comparison();
     
     while (match({TokenType::Equals, TokenType::NotEquals})) {
@@ -789,15 +1044,13 @@ std::unique_ptr<ast::Expression> Parser::equality() {
             ast::BinaryOp::Op::Eq : ast::BinaryOp::Op::Ne;
         
         auto right = comparison();
-        auto expr = std::make_unique<ast::Expression>();
-        expr->value = ast::BinaryOp{op, std::move(left), std::move(right)};
-        left = std::move(expr);
+        left = arena_->make<ast::Expression>(ast::BinaryOp{op, left, right});
     }
     
     return left;
 }
 
-std::unique_ptr<ast::Expression> Parser::comparison() {
+ast::Expression* Parser::comparison() {
     auto left = term();
     
     while (match({TokenType::Less, TokenType::Greater, 
@@ -812,15 +1065,13 @@ std::unique_ptr<ast::Expression> Parser::comparison() {
         }
         
         auto right = term();
-        auto expr = std::make_unique<ast::Expression>();
-        expr->value = ast::BinaryOp{op, std::move(left), std::move(right)};
-        left = std::move(expr);
+        left = arena_->make<ast::Expression>(ast::BinaryOp{op, left, right});
     }
     
     return left;
 }
 
-std::unique_ptr<ast::Expression> Parser::term() {
+ast::Expression* Parser::term() {
     auto left = factor();
     
     while (match({TokenType::Plus, TokenType::Minus})) {
@@ -828,15 +1079,13 @@ std::unique_ptr<ast::Expression> Parser::term() {
             ast::BinaryOp::Op::Add : ast::BinaryOp::Op::Sub;
         
         auto right = factor();
-        auto expr = std::make_unique<ast::Expression>();
-        expr->value = ast::BinaryOp{op, std::move(left), std::move(right)};
-        left = std::move(expr);
+        left = arena_->make<ast::Expression>(ast::BinaryOp{op, left, right});
     }
     
     return left;
 }
 
-std::unique_ptr<ast::Expression> Parser::factor() {
+ast::Expression* Parser::factor() {
     auto left = unary();
     
     while (match({TokenType::Star, TokenType::Slash})) {
@@ -844,32 +1093,28 @@ std::unique_ptr<ast::Expression> Parser::factor() {
             ast::BinaryOp::Op::Mul : ast::BinaryOp::Op::Div;
         
         auto right = unary();
-        auto expr = std::make_unique<ast::Expression>();
-        expr->value = ast::BinaryOp{op, std::move(left), std::move(right)};
-        left = std::move(expr);
+        left = arena_->make<ast::Expression>(ast::BinaryOp{op, left, right});
     }
     
     return left;
 }
 
-std::unique_ptr<ast::Expression> Parser::unary() {
+ast::Expression* Parser::unary() {
     if (match({TokenType::Not, TokenType::Minus})) {
         auto op = previous().type == TokenType::Not ? 
             ast::UnaryOp::Op::Not : ast::UnaryOp::Op::Neg;
         
         auto operand = unary();
-        auto expr = std::make_unique<ast::Expression>();
-        expr->value = ast::UnaryOp{op, std::move(operand)};
-        return expr;
+        return arena_->make<ast::Expression>(ast::UnaryOp{op, operand});
     }
     
     return primary();
 }
 
-std::unique_ptr<ast::Expression> Parser::primary() {
+ast::Expression* Parser::primary() {
     
     if (match({TokenType::Integer})) {
-        auto expr = std::make_unique<ast::Expression>();
+        auto expr = arena_->make<ast::Expression>();
         if (auto* val = std::get_if<int>(&previous().literal_value)) {
             expr->value = ast::IntLiteral{*val};
         }
@@ -877,7 +1122,7 @@ std::unique_ptr<ast::Expression> Parser::primary() {
     }
     
     if (match({TokenType::Float})) {
-        auto expr = std::make_unique<ast::Expression>();
+        auto expr = arena_->make<ast::Expression>();
         if (auto* val = std::get_if<double>(&previous().literal_value)) {
             expr->value = ast::FloatLiteral{*val};
         }
@@ -885,15 +1130,15 @@ std::unique_ptr<ast::Expression> Parser::primary() {
     }
     
     if (match({TokenType::String})) {
-        auto expr = std::make_unique<ast::Expression>();
-        if (auto* val = std::get_if<std::string>(&previous().literal_value)) {
-            expr->value = ast::StringLiteral{*val};
+        auto expr = arena_->make<ast::Expression>();
+        if (auto* val = std::get_if<std::string_view>(&previous().literal_value)) {
+            expr->value = ast::StringLiteral{arena_->copy(*val)};
         }
         return expr;
     }
     
     if (match({TokenType::TokTrue, TokenType::TokFalse})) {
-        auto expr = std::make_unique<ast::Expression>();
+        auto expr = arena_->make<ast::Expression>();
         if (auto* val = std::get_if<bool>(&previous().literal_value)) {
             expr->value = ast::BoolLiteral{*val};
         }
@@ -902,29 +1147,15 @@ std::unique_ptr<ast::Expression> Parser::primary() {
     
     
     if (match({TokenType::Identifier})) {
-        std::string name{previous().lexeme};
+        auto expr = arena_->make<ast::Expression>(ast::Identifier{arena_->copy(previous().lexeme)});
         
         
-        if (match({TokenType::Dot})) {
-            auto expr = std::make_unique<ast::Expression>();
-            expr->value = ast::Identifier{name};
-            
-            while (true) {
-                std::string member{consume(TokenType::Identifier, 
-                    "Expected identifier after '.'").lexeme};
-                
-                auto member_expr = std::make_unique<ast::Expression>();
-                member_expr->value = ast::MemberAccess{std::move(expr), member};
-                expr = std::move(member_expr);
-                
-                if (!match({TokenType::Dot})) break;
-            }
-            
-            return expr;
+        while (match({TokenType::Dot})) {
+            std::string_view member = arena_->copy(consume(TokenType::Identifier, 
+                "Expected identifier after '.'").lexeme);
+            expr = arena_->make<ast::Expression>(ast::MemberAccess{expr, member});
         }
         
-        auto expr = std::make_unique<ast::Expression>();
-        expr->value = ast::Identifier{name};
         return expr;
     }
     
@@ -937,23 +1168,21 @@ std::unique_ptr<ast::Expression> Parser::primary() {
     
     
     if (match({TokenType::LeftBracket})) {
-        ast::ArrayLiteral array;
+        size_t mark = element_stack_.size();
         
         
         if (!check(TokenType::RightBracket)) {
             do {
                 auto elem = expression();
                 if (elem) {
-                    array.elements.push_back(std::move(elem));
+                    element_stack_.push_back(elem);
                 }
             } while (match({TokenType::Comma}));
         }
         
         consume(TokenType::RightBracket, "Expected ']' after array elements");
         
-        auto expr = std::make_unique<ast::Expression>();
-        expr->value = std::move(array);
-        return expr;
+        return arena_->make<ast::Expression>(ast::ArrayLiteral{takeFrom(element_stack_, mark)});
     }
     
     addError("Expected expression");
@@ -979,7 +1208,20 @@ void Parser::synchronize() {
 
 
 
-ConfigParser::ConfigParser(Toaster* toaster) : toaster_(toaster) {}
+ConfigParser::ConfigParser(Toaster* toaster)
+    : toaster_(toaster)
+    , current_(std::make_shared<const Config>())
+    , active_(current_) {}
+
+void ConfigParser::setConfig(std::shared_ptr<const Config> config) {
+    current_ = std::move(config);
+    active_.store(current_, std::memory_order_release);
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void ConfigParser::publish() {
+    setConfig(std::make_shared<const Config>(config_));
+}
 
 bool ConfigParser::load(const std::filesystem::path& path) {
     
@@ -1000,6 +1242,25 @@ bool ConfigParser::load(const std::filesystem::path& path) {
     std::string source = buffer.str();
     
     
+    ConfigCache cache;
+    ConfigCache::Source main_source{std::filesystem::absolute(path), ConfigCache::hash(source), true};
+    if (cache_enabled_) {
+        Config cached;
+        if (cache.load(main_source, cached)) {
+            config_ = std::move(cached);
+            imported_modules_.clear();
+            publish();
+            return true;
+        }
+    }
+    
+    // Parse into a fresh Config so a reload matches what the cache would hold
+    config_ = Config{};
+    imported_modules_.clear();
+    import_sources_.clear();
+    size_t errors_before = errors_.size();
+    
+    
     std::cerr << "[ConfigParser] SOURCE FIRST 200 CHARS: '" << source.substr(0, 200) << "'" << std::endl;
     
     
@@ -1028,6 +1289,18 @@ bool ConfigParser::load(const std::filesystem::path& path) {
     
     
     bool result = interpret(*ast);
+    
+    
+    if (result && cache_enabled_ && errors_.size() == errors_before) {
+        std::vector<ConfigCache::Source> sources;
+        sources.reserve(import_sources_.size() + 1);
+        sources.push_back(std::move(main_source));
+        sources.insert(sources.end(), import_sources_.begin(), import_sources_.end());
+        cache.store(sources, config_);
+    }
+    if (result) {
+        publish();
+    }
     return result;
 }
 
@@ -1051,7 +1324,11 @@ bool ConfigParser::loadFromString(const std::string& source) {
     }
     
     
-    return interpret(*ast);
+    if (!interpret(*ast)) {
+        return false;
+    }
+    publish();
+    return true;
 }
 
 std::string ConfigParser::getEmbeddedConfig() {
@@ -1188,8 +1465,10 @@ pointblank: {
 
 bool ConfigParser::interpret(const ast::ConfigFile& ast) {
     
+    parseImports(ast.imports);
+    std::unordered_set<std::string> evaluated;
     for (const auto& import : ast.imports) {
-        if (!resolveImport(import)) {
+        if (!resolveImport(import, evaluated)) {
             
         }
     }
@@ -1214,7 +1493,10 @@ void ConfigParser::evaluateBlock(const ast::Block& block) {
     
     if (block.name == "window_rules") {
         for (const auto& stmt : block.statements) {
-            evaluateStatement(*stmt);
+            auto* cond = std::get_if<ast::IfStatement>(&stmt->value);
+            if (!cond || !compileWindowRule(*cond)) {
+                evaluateStatement(*stmt);
+            }
         }
     } else if (block.name == "workspaces") {
         for (const auto& stmt : block.statements) {
@@ -1258,12 +1540,12 @@ void ConfigParser::evaluateBlock(const ast::Block& block) {
             
             if (auto* var_decl = std::get_if<ast::VariableDeclaration>(&stmt->value)) {
                 auto result = evaluateExpression(*var_decl->value);
-                config_.variables[var_decl->name] = result;
+                config_.variables[std::string(var_decl->name)] = result;
                 continue;
             }
             
             if (auto* assign = std::get_if<ast::Assignment>(&stmt->value)) {
-                std::string keybind_str = assign->name;
+                std::string keybind_str{assign->name};
                 std::cerr << "[CONFIG] Found keybind assignment: " << keybind_str << std::endl;
                 auto action_value = evaluateExpression(*assign->value);
                 
@@ -1672,6 +1954,10 @@ void ConfigParser::evaluateBlock(const ast::Block& block) {
                         if (auto* b = std::get_if<bool>(&result)) {
                             config_.status_bar.enabled = *b;
                         }
+                    } else if (value.name == "shared_state") {
+                        if (auto* b = std::get_if<bool>(&result)) {
+                            config_.status_bar.shared_state = *b;
+                        }
                     } else if (value.name == "position") {
                         if (auto* s = std::get_if<std::string>(&result)) {
                             config_.status_bar.position = *s;
@@ -1914,7 +2200,11 @@ void ConfigParser::evaluateBlock(const ast::Block& block) {
                     
                     auto result = evaluateExpression(*value.value);
                     
-                    if (auto* str = std::get_if<std::string>(&result)) {
+                    if (value.name == "xdg") {
+                        if (auto* b = std::get_if<bool>(&result)) {
+                            config_.autostart.xdg = *b;
+                        }
+                    } else if (auto* str = std::get_if<std::string>(&result)) {
                         std::string cmd = *str;
                         
                         
@@ -1937,7 +2227,7 @@ void ConfigParser::evaluateBlock(const ast::Block& block) {
                     }
                 } else if constexpr (std::is_same_v<T, ast::ExecDirective>) {
                     
-                    std::string cmd = value.command;
+                    std::string cmd{value.command};
                     
                     
                     
@@ -1971,7 +2261,7 @@ void ConfigParser::evaluateStatement(const ast::Statement& stmt) {
         
         if constexpr (std::is_same_v<T, ast::Assignment>) {
             auto result = evaluateExpression(*value.value);
-            config_.variables[value.name] = result;
+            config_.variables[std::string(value.name)] = result;
             
             
             if (auto* i = std::get_if<int>(&result)) {
@@ -2007,7 +2297,7 @@ void ConfigParser::evaluateStatement(const ast::Statement& stmt) {
             }
         } else if constexpr (std::is_same_v<T, ast::VariableDeclaration>) {
             auto result = evaluateExpression(*value.value);
-            config_.variables[value.name] = result;
+            config_.variables[std::string(value.name)] = result;
             
 
             if (auto* i = std::get_if<int>(&result)) {
@@ -2040,292 +2330,219 @@ void ConfigParser::evaluateStatement(const ast::Statement& stmt) {
     }, stmt.value);
 }
 
-std::variant<int, double, std::string, bool, std::vector<std::string>> 
-ConfigParser::evaluateExpression(const ast::Expression& expr) {
+bool ConfigParser::compileWindowRule(const ast::IfStatement& stmt) {
+    if (!referencesWindow(*stmt.condition)) {
+        return false;
+    }
     
     
-    return evaluateExpression(expr, None, nullptr);
-}
-
-std::variant<int, double, std::string, bool, std::vector<std::string>> 
-ConfigParser::evaluateExpression(const ast::Expression& expr, Window window, Display* display) {
-    return std::visit([this, window, display](auto&& value) -> std::variant<int, double, std::string, bool, std::vector<std::string>> {
-        using T = std::decay_t<decltype(value)>;
-        
-        if constexpr (std::is_same_v<T, ast::IntLiteral>) {
-            return value.value;
-        } else if constexpr (std::is_same_v<T, ast::FloatLiteral>) {
-            return value.value;
-        } else if constexpr (std::is_same_v<T, ast::StringLiteral>) {
-            return value.value;
-        } else if constexpr (std::is_same_v<T, ast::BoolLiteral>) {
-            return value.value;
-        } else if constexpr (std::is_same_v<T, ast::Identifier>) {
-            
-            auto it = config_.variables.find(value.name);
-            if (it != config_.variables.end()) {
-                return std::visit([](auto&& v) -> std::variant<int, double, std::string, bool, std::vector<std::string>> {
-                    return v;
-                }, it->second);
-            }
-            return 0; 
-        } else if constexpr (std::is_same_v<T, ast::BinaryOp>) {
-            auto left = evaluateExpression(*value.left, window, display);
-            auto right = evaluateExpression(*value.right, window, display);
-            
-            
-            switch (value.op) {
-                case ast::BinaryOp::Op::Add: {
-                    if (auto* l = std::get_if<int>(&left)) {
-                        if (auto* r = std::get_if<int>(&right)) {
-                            return *l + *r;
-                        }
-                    }
-                    
-                    if (auto* l = std::get_if<std::string>(&left)) {
-                        if (auto* r = std::get_if<std::string>(&right)) {
-                            return *l + *r;
-                        }
-                    }
-                    return 0;
-                }
-                case ast::BinaryOp::Op::Sub: {
-                    if (auto* l = std::get_if<int>(&left)) {
-                        if (auto* r = std::get_if<int>(&right)) {
-                            return *l - *r;
-                        }
-                    }
-                    return 0;
-                }
-                case ast::BinaryOp::Op::Mul: {
-                    if (auto* l = std::get_if<int>(&left)) {
-                        if (auto* r = std::get_if<int>(&right)) {
-                            return *l * *r;
-                        }
-                    }
-                    return 0;
-                }
-                case ast::BinaryOp::Op::Div: {
-                    if (auto* l = std::get_if<int>(&left)) {
-                        if (auto* r = std::get_if<int>(&right)) {
-                            if (*r != 0) return *l / *r;
-                        }
-                    }
-                    return 0;
-                }
-                case ast::BinaryOp::Op::And: {
-                    bool l = false, r = false;
-                    if (auto* b = std::get_if<bool>(&left)) l = *b;
-                    else if (auto* i = std::get_if<int>(&left)) l = *i != 0;
-                    if (auto* b = std::get_if<bool>(&right)) r = *b;
-                    else if (auto* i = std::get_if<int>(&right)) r = *i != 0;
-                    return l && r;
-                }
-                case ast::BinaryOp::Op::Or: {
-                    bool l = false, r = false;
-                    if (auto* b = std::get_if<bool>(&left)) l = *b;
-                    else if (auto* i = std::get_if<int>(&left)) l = *i != 0;
-                    if (auto* b = std::get_if<bool>(&right)) r = *b;
-                    else if (auto* i = std::get_if<int>(&right)) r = *i != 0;
-                    return l || r;
-                }
-                case ast::BinaryOp::Op::Eq: {
-                    
-                    if (auto* l = std::get_if<std::string>(&left)) {
-                        if (auto* r = std::get_if<std::string>(&right)) {
-                            return *l == *r;
-                        }
-                    }
-                    
-                    if (auto* l = std::get_if<int>(&left)) {
-                        if (auto* r = std::get_if<int>(&right)) {
-                            return *l == *r;
-                        }
-                    }
-                    
-                    if (auto* l = std::get_if<bool>(&left)) {
-                        if (auto* r = std::get_if<bool>(&right)) {
-                            return *l == *r;
-                        }
-                    }
-                    return false;
-                }
-                case ast::BinaryOp::Op::Ne: {
-                    
-                    if (auto* l = std::get_if<std::string>(&left)) {
-                        if (auto* r = std::get_if<std::string>(&right)) {
-                            return *l != *r;
-                        }
-                    }
-                    
-                    if (auto* l = std::get_if<int>(&left)) {
-                        if (auto* r = std::get_if<int>(&right)) {
-                            return *l != *r;
-                        }
-                    }
-                    
-                    if (auto* l = std::get_if<bool>(&left)) {
-                        if (auto* r = std::get_if<bool>(&right)) {
-                            return *l != *r;
-                        }
-                    }
-                    return true;
-                }
-                case ast::BinaryOp::Op::Lt: {
-                    if (auto* l = std::get_if<int>(&left)) {
-                        if (auto* r = std::get_if<int>(&right)) {
-                            return *l < *r;
-                        }
-                    }
-                    return false;
-                }
-                case ast::BinaryOp::Op::Gt: {
-                    if (auto* l = std::get_if<int>(&left)) {
-                        if (auto* r = std::get_if<int>(&right)) {
-                            return *l > *r;
-                        }
-                    }
-                    return false;
-                }
-                case ast::BinaryOp::Op::Le: {
-                    if (auto* l = std::get_if<int>(&left)) {
-                        if (auto* r = std::get_if<int>(&right)) {
-                            return *l <= *r;
-                        }
-                    }
-                    return false;
-                }
-                case ast::BinaryOp::Op::Ge: {
-                    if (auto* l = std::get_if<int>(&left)) {
-                        if (auto* r = std::get_if<int>(&right)) {
-                            return *l >= *r;
-                        }
-                    }
-                    return false;
-                }
-            }
-            return 0;
-        } else if constexpr (std::is_same_v<T, ast::MemberAccess>) {
-            
-            
-            auto obj_result = evaluateExpression(*value.object, window, display);
-            
-            std::string object_name;
-            if (auto* s = std::get_if<std::string>(&obj_result)) {
-                object_name = *s;
-            } else if (auto* i = std::get_if<int>(&obj_result)) {
-                object_name = std::to_string(*i);
-            }
-            
-            
-            if (object_name == "window") {
-                if (!window || !display) {
-                    
-                    return std::string("");
-                }
-                
-                
-                if (value.member == "class") {
-                    XClassHint class_hint;
-                    if (XGetClassHint(display, window, &class_hint)) {
-                        std::string result = class_hint.res_class ? class_hint.res_class : "";
-                        if (class_hint.res_name) XFree(class_hint.res_name);
-                        if (class_hint.res_class) XFree(class_hint.res_class);
-                        return result;
-                    }
-                    return std::string("");
-                } else if (value.member == "title") {
-                    char* name = nullptr;
-                    if (XFetchName(display, window, &name)) {
-                        std::string result = name ? name : "";
-                        if (name) XFree(name);
-                        return result;
-                    }
-                    return std::string("");
-                } else if (value.member == "workspace") {
-                    
-                    
-                    return 0;
-                }
-            }
-            
-            return std::string("");
-        } else if constexpr (std::is_same_v<T, ast::ArrayLiteral>) {
-            std::vector<std::string> result;
-            for (const auto& elem : value.elements) {
-                auto elem_val = evaluateExpression(*elem, window, display);
-                if (auto* s = std::get_if<std::string>(&elem_val)) {
-                    result.push_back(*s);
-                } else if (auto* i = std::get_if<int>(&elem_val)) {
-                    result.push_back(std::to_string(*i));
-                } else if (auto* d = std::get_if<double>(&elem_val)) {
-                    result.push_back(std::to_string(*d));
-                } else if (auto* b = std::get_if<bool>(&elem_val)) {
-                    result.push_back(*b ? "true" : "false");
-                }
+    std::vector<Config::WindowRule> alternatives(1);
+    bool indexable = stmt.else_branch.empty() && collectRuleCriteria(*stmt.condition, alternatives);
+    for (const auto* s : stmt.then_branch) {
+        auto* assign = std::get_if<ast::Assignment>(&s->value);
+        indexable = indexable && assign && !referencesWindow(*assign->value);
+    }
+    
+    if (!indexable) {
+        bytecode::Compiler compiler(config_.variables);
+        auto program = compiler.compileRule(stmt);
+        if (!program) {
+            reportError("Invalid window rule: " + compiler.error());
+            return true;
+        }
+        for (const auto& in : program->code) {
+            if (in.op == bytecode::Op::Set && !isRuleSetting(program->strings[in.imm])) {
+                reportError("Invalid window rule setting: " + program->strings[in.imm]);
+                return true;
             }
-            return result;
+        }
+        
+        Config::WindowRule rule;
+        rule.program = std::move(*program);
+        config_.per_window_rules.push_back(std::move(rule));
+        return true;
+    }
+    
+    
+    Config::WindowRule outcome;
+    for (const auto* s : stmt.then_branch) {
+        const auto& assign = std::get<ast::Assignment>(s->value);
+        auto result = evaluateExpression(*assign.value);
+        auto* b = std::get_if<bool>(&result);
+        auto* i = std::get_if<int>(&result);
+        auto* d = std::get_if<double>(&result);
+        
+        if ((assign.name == "floating" || assign.name == "float") && b) {
+            outcome.floating = *b;
+        } else if (assign.name == "workspace" && i && *i > 0) {
+            outcome.workspace = *i;
+        } else if (assign.name == "opacity" && (d || i)) {
+            outcome.opacity = d ? *d : static_cast<double>(*i);
+        } else if (assign.name == "border_width" && i && *i >= 0) {
+            outcome.border_width = *i;
         } else {
-            return 0;
+            reportError("Invalid window rule setting: " + std::string(assign.name));
         }
-    }, expr.value);
+    }
+    
+    for (auto& rule : alternatives) {
+        rule.floating = outcome.floating;
+        rule.workspace = outcome.workspace;
+        rule.opacity = outcome.opacity;
+        rule.border_width = outcome.border_width;
+        config_.per_window_rules.push_back(std::move(rule));
+    }
+    return true;
 }
 
-bool ConfigParser::resolveImport(const ast::ImportDirective& import) {
+bool ConfigParser::collectRuleCriteria(const ast::Expression& expr,
+                                       std::vector<Config::WindowRule>& alternatives) {
+    auto* bin = std::get_if<ast::BinaryOp>(&expr.value);
+    if (!bin) return false;
     
-    if (imported_modules_.find(import.module_name) != imported_modules_.end()) {
-        return true; 
+    if (bin->op == ast::BinaryOp::Op::And) {
+        return collectRuleCriteria(*bin->left, alternatives) &&
+               collectRuleCriteria(*bin->right, alternatives);
+    }
+    if (bin->op == ast::BinaryOp::Op::Or) {
+        
+        auto right = alternatives;
+        if (!collectRuleCriteria(*bin->left, alternatives) ||
+            !collectRuleCriteria(*bin->right, right)) {
+            return false;
+        }
+        alternatives.insert(alternatives.end(), right.begin(), right.end());
+        return true;
     }
+    if (bin->op != ast::BinaryOp::Op::Eq) return false;
     
     
-    auto file_path = findImportFile(import.module_name, import.is_user_extension);
-    if (!file_path) {
-        reportError("Could not find import file: " + import.module_name);
-        return false;
+    const ast::Expression* operand = bin->right;
+    std::string_view member = windowMember(*bin->left);
+    if (member.empty()) {
+        member = windowMember(*bin->right);
+        operand = bin->left;
     }
     
+    auto result = evaluateExpression(*operand);
+    auto* value = std::get_if<std::string>(&result);
+    if (!value || value->empty()) return false;
     
-    std::ifstream file(*file_path);
-    if (!file.is_open()) {
-        reportError("Could not open import file: " + file_path->string());
-        return false;
-    }
+    std::string Config::WindowRule::* field = nullptr;
+    if (member == "class") field = &Config::WindowRule::window_class;
+    else if (member == "instance") field = &Config::WindowRule::instance;
+    else if (member == "title") field = &Config::WindowRule::title;
+    else return false;
     
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string source = buffer.str();
-    file.close();
     
+    std::erase_if(alternatives, [&](Config::WindowRule& rule) {
+        std::string& current = rule.*field;
+        if (current.empty()) {
+            current = *value;
+            return false;
+        }
+        return current != *value;
+    });
+    return true;
+}
+
+std::variant<int, double, std::string, bool, std::vector<std::string>> 
+ConfigParser::evaluateExpression(const ast::Expression& expr) {
+    return evaluateExpression(expr, bytecode::WindowProperties{});
+}
+
+std::variant<int, double, std::string, bool, std::vector<std::string>> 
+ConfigParser::evaluateExpression(const ast::Expression& expr, const bytecode::WindowProperties& window) {
+    bytecode::Compiler compiler(config_.variables);
+    auto program = compiler.compileExpression(expr);
+    if (!program) {
+        reportError(compiler.error());
+        return 0;
+    }
+    return bytecode::VM::toConfigValue(vm_.run(*program, window));
+}
+
+void ConfigParser::parseImports(const std::vector<ast::ImportDirective>& imports) {
+    std::vector<const ast::ImportDirective*> frontier;
+    for (const auto& import : imports) {
+        frontier.push_back(&import);
+    }
     
-    Lexer lexer(source);
-    auto tokens = lexer.tokenize();
     
+    std::unordered_set<std::string> closure;
+    while (!frontier.empty()) {
+        std::vector<std::string> keys;
+        std::vector<std::filesystem::path> paths;
+        for (const auto* import : frontier) {
+            auto key = importKey(*import);
+            if (imported_modules_.count(key)) continue;
+            
+            auto path = findImportFile(import->module_name, import->is_user_extension);
+            imported_modules_[key] = nullptr;
+            if (path) {
+                keys.push_back(std::move(key));
+                paths.push_back(std::move(*path));
+            }
+        }
+        
+        
+        for (const auto& path : paths) {
+            closure.insert(path.string());
+        }
+        auto modules = parseModules(paths);
+        frontier.clear();
+        for (size_t i = 0; i < modules.size(); ++i) {
+            const auto& module = modules[i];
+            if (module->hash) {
+                import_sources_.push_back({module->path, module->hash, true});
+            }
+            if (module->file) {
+                for (const auto& import : module->file->imports) {
+                    frontier.push_back(&import);
+                }
+            }
+            imported_modules_[keys[i]] = module;
+        }
+    }
     
-    Parser parser(std::move(tokens));
-    auto ast = parser.parse();
+    // Files no longer imported would otherwise stay cached for good
+    pruneModuleCache(closure);
+}
+
+bool ConfigParser::resolveImport(const ast::ImportDirective& import, std::unordered_set<std::string>& evaluated) {
+    auto key = importKey(import);
+    if (!evaluated.insert(key).second) {
+        return true; 
+    }
     
     
-    const auto& errors = parser.getErrors();
-    if (!errors.empty()) {
-        reportErrors(errors);
+    auto it = imported_modules_.find(key);
+    if (it == imported_modules_.end() || !it->second) {
+        reportError("Could not find import file: " + import.module_name);
         return false;
     }
     
-    if (!ast) {
-        reportError("Failed to parse import: " + import.module_name);
+    const auto& module = *it->second;
+    if (!module.errors.empty()) {
+        for (const auto& error : module.errors) {
+            reportError(module.path.filename().string() + ": " + error);
+        }
         return false;
     }
     
     
-    for (auto& block : ast->blocks) {
+    for (const auto& nested : module.file->imports) {
+        resolveImport(nested, evaluated);
+    }
+    if (module.file->root) {
+        evaluateBlock(*module.file->root);
+    }
+    for (const auto* block : module.file->blocks) {
         if (block) {
             evaluateBlock(*block);
         }
     }
     
-    
-    imported_modules_[import.module_name] = std::move(ast);
-    
     return true;
 }
 
@@ -2344,6 +2561,7 @@ ConfigParser::findImportFile(const std::string& name, bool is_user) {
 }
 
 void ConfigParser::reportError(const std::string& message) {
+    errors_.push_back(message);
     if (toaster_) {
         toaster_->error(message);
     }
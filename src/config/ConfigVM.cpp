@@ -0,0 +1,508 @@
+#include "pointblank/config/ConfigVM.hpp"
+#include "pointblank/config/ConfigParser.hpp"
+#include <climits>
+
+namespace pblank::bytecode {
+
+namespace {
+
+// Array literals hold strings; other element types are converted as the
+// tree-walking interpreter did
+void appendAsString(std::vector<std::string>& out, const Value& value) {
+    switch (value.type) {
+        case Value::Type::Int:    out.push_back(std::to_string(value.i)); break;
+        case Value::Type::Double: out.push_back(std::to_string(value.d)); break;
+        case Value::Type::Boolean:   out.push_back(value.b ? "true" : "false"); break;
+        case Value::Type::String: out.emplace_back(value.s); break;
+        case Value::Type::Array:  break;
+    }
+}
+
+Value applyUnary(Op op, const Value& operand) {
+    if (op == Op::Not) {
+        return Value::ofBool(!operand.truthy());
+    }
+    if (operand.type == Value::Type::Int) {
+        return Value::ofInt(static_cast<int>(0u - static_cast<unsigned>(operand.i)));
+    }
+    if (operand.type == Value::Type::Double) {
+        return Value::ofDouble(-operand.d);
+    }
+    return Value::ofInt(0);
+}
+
+bool isWindowTitle(const ast::Expression& expr) {
+    auto* access = std::get_if<ast::MemberAccess>(&expr.value);
+    if (!access || access->member != "title") return false;
+    auto* object = std::get_if<ast::Identifier>(&access->object->value);
+    return object && object->name == "window";
+}
+
+bool isGlob(const Value& value) {
+    return value.type == Value::Type::String && value.s.find_first_of("*?") != std::string_view::npos;
+}
+
+std::optional<Op> binaryOp(ast::BinaryOp::Op op) {
+    switch (op) {
+        case ast::BinaryOp::Op::Add: return Op::Add;
+        case ast::BinaryOp::Op::Sub: return Op::Sub;
+        case ast::BinaryOp::Op::Mul: return Op::Mul;
+        case ast::BinaryOp::Op::Div: return Op::Div;
+        case ast::BinaryOp::Op::Eq:  return Op::Eq;
+        case ast::BinaryOp::Op::Ne:  return Op::Ne;
+        case ast::BinaryOp::Op::Lt:  return Op::Lt;
+        case ast::BinaryOp::Op::Gt:  return Op::Gt;
+        case ast::BinaryOp::Op::Le:  return Op::Le;
+        case ast::BinaryOp::Op::Ge:  return Op::Ge;
+        case ast::BinaryOp::Op::And:
+        case ast::BinaryOp::Op::Or:  break;
+    }
+    return std::nullopt;
+}
+
+}
+
+
+bool globMatch(std::string_view pattern, std::string_view text) {
+    size_t p = 0, t = 0;
+    size_t star = std::string_view::npos, resume = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+            ++p;
+            ++t;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = t;
+        } else if (star != std::string_view::npos) {
+            p = star + 1;
+            t = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
+
+Value VM::apply(Op op, const Value& left, const Value& right, std::deque<std::string>& scratch) {
+    using Type = Value::Type;
+    bool ints = left.type == Type::Int && right.type == Type::Int;
+    bool strings = left.type == Type::String && right.type == Type::String;
+    bool bools = left.type == Type::Boolean && right.type == Type::Boolean;
+
+    switch (op) {
+        case Op::Add:
+            if (ints) return Value::ofInt(static_cast<int>(static_cast<unsigned>(left.i) + static_cast<unsigned>(right.i)));
+            if (strings) {
+                std::string& joined = scratch.emplace_back(left.s);
+                joined += right.s;
+                return Value::ofString(joined);
+            }
+            return Value::ofInt(0);
+        case Op::Sub:
+            return Value::ofInt(ints ? static_cast<int>(static_cast<unsigned>(left.i) - static_cast<unsigned>(right.i)) : 0);
+        case Op::Mul:
+            return Value::ofInt(ints ? static_cast<int>(static_cast<unsigned>(left.i) * static_cast<unsigned>(right.i)) : 0);
+        case Op::Div:
+            if (ints && right.i != 0 && !(left.i == INT_MIN && right.i == -1)) {
+                return Value::ofInt(left.i / right.i);
+            }
+            return Value::ofInt(0);
+        case Op::Eq:
+            if (strings) return Value::ofBool(left.s == right.s);
+            if (ints) return Value::ofBool(left.i == right.i);
+            if (bools) return Value::ofBool(left.b == right.b);
+            return Value::ofBool(false);
+        case Op::Ne:
+            if (strings) return Value::ofBool(left.s != right.s);
+            if (ints) return Value::ofBool(left.i != right.i);
+            if (bools) return Value::ofBool(left.b != right.b);
+            return Value::ofBool(true);
+        case Op::Lt: return Value::ofBool(ints && left.i < right.i);
+        case Op::Gt: return Value::ofBool(ints && left.i > right.i);
+        case Op::Le: return Value::ofBool(ints && left.i <= right.i);
+        case Op::Ge: return Value::ofBool(ints && left.i >= right.i);
+        default:
+            return Value::ofInt(0);
+    }
+}
+
+Value VM::run(const Program& program, const WindowProperties& window) {
+    strings_.clear();
+    arrays_.clear();
+    assignments_.clear();
+    registers_.assign(program.registers, Value{});
+
+    Value* r = registers_.data();
+    const auto& code = program.code;
+    size_t pc = 0;
+    while (pc < code.size()) {
+        const Instruction& in = code[pc++];
+        switch (in.op) {
+            case Op::LoadInt:    r[in.dst] = Value::ofInt(in.imm); break;
+            case Op::LoadDouble: r[in.dst] = Value::ofDouble(program.numbers[in.imm]); break;
+            case Op::LoadBool:   r[in.dst] = Value::ofBool(in.imm != 0); break;
+            case Op::LoadString: r[in.dst] = Value::ofString(program.strings[in.imm]); break;
+            case Op::LoadArray:  r[in.dst] = Value::ofArray(&program.arrays[in.imm]); break;
+            case Op::LoadWindow:
+                switch (static_cast<WindowProperty>(in.imm)) {
+                    case WindowProperty::Class:     r[in.dst] = Value::ofString(window.window_class); break;
+                    case WindowProperty::Instance:  r[in.dst] = Value::ofString(window.instance); break;
+                    case WindowProperty::Title:     r[in.dst] = Value::ofString(window.title); break;
+                    case WindowProperty::Workspace: r[in.dst] = Value::ofInt(window.workspace); break;
+                }
+                break;
+            case Op::Add: case Op::Sub: case Op::Mul: case Op::Div:
+            case Op::Eq: case Op::Ne: case Op::Lt: case Op::Gt: case Op::Le: case Op::Ge:
+                r[in.dst] = apply(in.op, r[in.a], r[in.b], strings_);
+                break;
+            case Op::Glob:
+                r[in.dst] = Value::ofBool(r[in.a].type == Value::Type::String &&
+                                          globMatch(r[in.b].s, r[in.a].s));
+                break;
+            case Op::Not:
+            case Op::Neg:
+                r[in.dst] = applyUnary(in.op, r[in.a]);
+                break;
+            case Op::ToBool:
+                r[in.dst] = Value::ofBool(r[in.a].truthy());
+                break;
+            case Op::MakeArray: {
+                auto& array = arrays_.emplace_back();
+                for (int k = in.a; k < in.a + in.b; ++k) {
+                    appendAsString(array, r[k]);
+                }
+                r[in.dst] = Value::ofArray(&array);
+                break;
+            }
+            case Op::Jump:
+                pc = static_cast<size_t>(in.imm);
+                break;
+            case Op::JumpIfFalse:
+                if (!r[in.a].truthy()) pc = static_cast<size_t>(in.imm);
+                break;
+            case Op::JumpIfTrue:
+                if (r[in.a].truthy()) pc = static_cast<size_t>(in.imm);
+                break;
+            case Op::Set:
+                assignments_.emplace_back(program.strings[in.imm], r[in.a]);
+                break;
+            case Op::Return:
+                return r[in.a];
+        }
+    }
+    return Value{};
+}
+
+ConfigValue VM::toConfigValue(const Value& value) {
+    switch (value.type) {
+        case Value::Type::Int:    return value.i;
+        case Value::Type::Double: return value.d;
+        case Value::Type::Boolean:   return value.b;
+        case Value::Type::String: return std::string(value.s);
+        case Value::Type::Array:  return *value.array;
+    }
+    return 0;
+}
+
+
+std::optional<Program> Compiler::compileExpression(const ast::Expression& expr) {
+    reset();
+    Operand result = expression(expr);
+    if (!error_.empty()) {
+        return std::nullopt;
+    }
+    emit(Op::Return, 0, materialize(result));
+    if (!finish()) {
+        return std::nullopt;
+    }
+    return std::move(program_);
+}
+
+std::optional<Program> Compiler::compileRule(const ast::IfStatement& stmt) {
+    reset();
+    if (!branch(stmt) || !finish()) {
+        return std::nullopt;
+    }
+    return std::move(program_);
+}
+
+void Compiler::reset() {
+    program_ = Program{};
+    error_.clear();
+    top_ = 0;
+    interned_.clear();
+    fold_scratch_.clear();
+    fold_arrays_.clear();
+}
+
+bool Compiler::finish() {
+    program_.strings.resize(interned_.size());
+    for (auto& [text, id] : interned_) {
+        program_.strings[id] = text;
+    }
+    return error_.empty();
+}
+
+
+Compiler::Operand Compiler::expression(const ast::Expression& expr) {
+    return std::visit([this](auto&& value) -> Operand {
+        using T = std::decay_t<decltype(value)>;
+
+        if constexpr (std::is_same_v<T, ast::IntLiteral>) {
+            return {true, Value::ofInt(value.value)};
+        } else if constexpr (std::is_same_v<T, ast::FloatLiteral>) {
+            return {true, Value::ofDouble(value.value)};
+        } else if constexpr (std::is_same_v<T, ast::StringLiteral>) {
+            return {true, Value::ofString(value.value)};
+        } else if constexpr (std::is_same_v<T, ast::BoolLiteral>) {
+            return {true, Value::ofBool(value.value)};
+        } else if constexpr (std::is_same_v<T, ast::Identifier>) {
+            auto it = variables_.find(std::string(value.name));
+            return it != variables_.end() ? constant(it->second) : Operand{true, Value::ofInt(0)};
+        } else if constexpr (std::is_same_v<T, ast::BinaryOp>) {
+            if (value.op == ast::BinaryOp::Op::And || value.op == ast::BinaryOp::Op::Or) {
+                return logical(*value.left, *value.right, value.op == ast::BinaryOp::Op::And);
+            }
+
+            Op op = *binaryOp(value.op);
+            uint8_t base = top_;
+            Operand left = expression(*value.left);
+            Operand right = expression(*value.right);
+            if (left.constant && right.constant) {
+                return {true, VM::apply(op, left.value, right.value, fold_scratch_)};
+            }
+            uint8_t a = materialize(left);
+            uint8_t b = materialize(right);
+
+            bool negate = value.op == ast::BinaryOp::Op::Ne;
+            if ((op == Op::Eq || negate) && isWindowTitle(*value.left) && right.constant && isGlob(right.value)) {
+                emit(Op::Glob, base, a, b);
+            } else if ((op == Op::Eq || negate) && isWindowTitle(*value.right) && left.constant && isGlob(left.value)) {
+                emit(Op::Glob, base, b, a);
+            } else {
+                negate = false;
+                emit(op, base, a, b);
+            }
+            if (negate) {
+                emit(Op::Not, base, base);
+            }
+            top_ = base + 1;
+            return {false, {}, base};
+        } else if constexpr (std::is_same_v<T, ast::UnaryOp>) {
+            Op op = value.op == ast::UnaryOp::Op::Not ? Op::Not : Op::Neg;
+            Operand operand = expression(*value.operand);
+            if (operand.constant) {
+                return {true, applyUnary(op, operand.value)};
+            }
+            emit(op, operand.reg, operand.reg);
+            return operand;
+        } else if constexpr (std::is_same_v<T, ast::MemberAccess>) {
+            auto* object = std::get_if<ast::Identifier>(&value.object->value);
+            if (!object || object->name != "window") {
+                return {true, Value::ofString("")};
+            }
+
+            WindowProperty property;
+            if (value.member == "class") property = WindowProperty::Class;
+            else if (value.member == "instance") property = WindowProperty::Instance;
+            else if (value.member == "title") property = WindowProperty::Title;
+            else if (value.member == "workspace") property = WindowProperty::Workspace;
+            else return {true, Value::ofString("")};
+
+            uint8_t reg = allocate();
+            emit(Op::LoadWindow, reg, 0, 0, static_cast<int32_t>(property));
+            return {false, {}, reg};
+        } else if constexpr (std::is_same_v<T, ast::ArrayLiteral>) {
+            uint8_t base = top_;
+            size_t code_size = program_.code.size();
+            size_t numbers = program_.numbers.size();
+            size_t arrays = program_.arrays.size();
+
+
+            std::vector<Operand> elements;
+            elements.reserve(value.elements.size());
+            bool folded = true;
+            for (const auto* element : value.elements) {
+                elements.push_back(expression(*element));
+                folded = folded && elements.back().constant;
+                materialize(elements.back());
+            }
+
+            if (folded) {
+                program_.code.resize(code_size);
+                program_.numbers.resize(numbers);
+                program_.arrays.resize(arrays);
+                top_ = base;
+                auto& array = fold_arrays_.emplace_back();
+                for (const auto& element : elements) {
+                    appendAsString(array, element.value);
+                }
+                return {true, Value::ofArray(&array)};
+            }
+            if (elements.size() > UINT8_MAX) {
+                fail("Array literal has too many elements");
+                return {true, Value::ofInt(0)};
+            }
+            emit(Op::MakeArray, base, base, static_cast<uint8_t>(elements.size()));
+            top_ = base + 1;
+            return {false, {}, base};
+        } else {
+            return {true, Value::ofInt(0)};
+        }
+    }, expr.value);
+}
+
+Compiler::Operand Compiler::constant(const ConfigValue& value) {
+    return std::visit([this](auto&& v) -> Operand {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, int>) {
+            return {true, Value::ofInt(v)};
+        } else if constexpr (std::is_same_v<T, double>) {
+            return {true, Value::ofDouble(v)};
+        } else if constexpr (std::is_same_v<T, bool>) {
+            return {true, Value::ofBool(v)};
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            return {true, Value::ofString(v)};
+        } else {
+            return {true, Value::ofArray(&fold_arrays_.emplace_back(v))};
+        }
+    }, value);
+}
+
+Compiler::Operand Compiler::logical(const ast::Expression& left, const ast::Expression& right, bool is_and) {
+    uint8_t base = top_;
+    Operand lhs = expression(left);
+    if (lhs.constant) {
+        if (lhs.value.truthy() != is_and) {
+            return {true, Value::ofBool(!is_and)};
+        }
+        Operand rhs = expression(right);
+        if (rhs.constant) {
+            return {true, Value::ofBool(rhs.value.truthy())};
+        }
+        emit(Op::ToBool, rhs.reg, rhs.reg);
+        return rhs;
+    }
+
+    emit(Op::ToBool, base, base);
+    size_t jump = emit(is_and ? Op::JumpIfFalse : Op::JumpIfTrue, 0, base);
+    Operand rhs = expression(right);
+    if (rhs.constant) {
+        emit(Op::LoadBool, base, 0, 0, rhs.value.truthy());
+    } else {
+        emit(Op::ToBool, base, rhs.reg);
+    }
+    program_.code[jump].imm = static_cast<int32_t>(program_.code.size());
+    top_ = base + 1;
+    return {false, {}, base};
+}
+
+
+bool Compiler::branch(const ast::IfStatement& stmt) {
+    uint8_t base = top_;
+    Operand condition = expression(*stmt.condition);
+    if (!error_.empty()) {
+        return false;
+    }
+    top_ = base;
+
+
+    if (condition.constant) {
+        for (const auto* s : condition.value.truthy() ? stmt.then_branch : stmt.else_branch) {
+            if (!statement(*s)) return false;
+        }
+        return true;
+    }
+
+    size_t skip = emit(Op::JumpIfFalse, 0, condition.reg);
+    for (const auto* s : stmt.then_branch) {
+        if (!statement(*s)) return false;
+    }
+    if (!stmt.else_branch.empty()) {
+        size_t end = emit(Op::Jump, 0);
+        program_.code[skip].imm = static_cast<int32_t>(program_.code.size());
+        for (const auto* s : stmt.else_branch) {
+            if (!statement(*s)) return false;
+        }
+        program_.code[end].imm = static_cast<int32_t>(program_.code.size());
+    } else {
+        program_.code[skip].imm = static_cast<int32_t>(program_.code.size());
+    }
+    return error_.empty();
+}
+
+bool Compiler::statement(const ast::Statement& stmt) {
+    if (auto* assign = std::get_if<ast::Assignment>(&stmt.value)) {
+        uint8_t base = top_;
+        Operand value = expression(*assign->value);
+        emit(Op::Set, 0, materialize(value), 0, static_cast<int32_t>(intern(assign->name)));
+        top_ = base;
+        return error_.empty();
+    }
+    if (auto* nested = std::get_if<ast::IfStatement>(&stmt.value)) {
+        return branch(*nested);
+    }
+    fail("Window rules may only contain assignments and if statements");
+    return false;
+}
+
+
+uint8_t Compiler::allocate() {
+    if (top_ == UINT8_MAX) {
+        fail("Expression is nested too deeply");
+        return 0;
+    }
+    uint8_t reg = top_++;
+    if (top_ > program_.registers) {
+        program_.registers = top_;
+    }
+    return reg;
+}
+
+uint8_t Compiler::materialize(const Operand& operand) {
+    if (!operand.constant) {
+        return operand.reg;
+    }
+
+    uint8_t reg = allocate();
+    const Value& v = operand.value;
+    switch (v.type) {
+        case Value::Type::Int:
+            emit(Op::LoadInt, reg, 0, 0, v.i);
+            break;
+        case Value::Type::Double:
+            emit(Op::LoadDouble, reg, 0, 0, static_cast<int32_t>(program_.numbers.size()));
+            program_.numbers.push_back(v.d);
+            break;
+        case Value::Type::Boolean:
+            emit(Op::LoadBool, reg, 0, 0, v.b);
+            break;
+        case Value::Type::String:
+            emit(Op::LoadString, reg, 0, 0, static_cast<int32_t>(intern(v.s)));
+            break;
+        case Value::Type::Array:
+            emit(Op::LoadArray, reg, 0, 0, static_cast<int32_t>(program_.arrays.size()));
+            program_.arrays.push_back(*v.array);
+            break;
+    }
+    return reg;
+}
+
+size_t Compiler::emit(Op op, uint8_t dst, uint8_t a, uint8_t b, int32_t imm) {
+    program_.code.push_back({op, dst, a, b, imm});
+    return program_.code.size() - 1;
+}
+
+uint32_t Compiler::intern(std::string_view s) {
+    auto [it, inserted] = interned_.try_emplace(std::string(s), static_cast<uint32_t>(interned_.size()));
+    return it->second;
+}
+
+void Compiler::fail(const std::string& message) {
+    if (error_.empty()) {
+        error_ = message;
+    }
+}
+
+}
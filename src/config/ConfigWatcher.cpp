@@ -273,30 +273,38 @@ void ConfigWatcher::debounceAndProcess(const std::filesystem::path& path) {
 }
 
 void ConfigWatcher::processDebouncedChanges() {
-    std::lock_guard<std::mutex> lock(pending_mutex_);
     
-    auto now = std::chrono::system_clock::now();
-    
-    for (auto it = pending_changes_.begin(); it != pending_changes_.end(); ) {
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now - it->second);
+    // Collect due paths first so requestReload() never waits on a parse
+    std::vector<std::filesystem::path> due;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
         
+        auto now = std::chrono::system_clock::now();
         
-        if (debounce_interval_.count() == 0 || elapsed >= debounce_interval_) {
+        for (auto it = pending_changes_.begin(); it != pending_changes_.end(); ) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                now - it->second);
             
-            ValidationResult result = reload(it->first);
             
-            if (result) {
-                std::cout << "ConfigWatcher: Successfully reloaded: " 
-                          << it->first << std::endl;
+            if (debounce_interval_.count() == 0 || elapsed >= debounce_interval_) {
+                due.push_back(it->first);
+                it = pending_changes_.erase(it);
             } else {
-                std::cerr << "ConfigWatcher: Failed to reload: " 
-                          << it->first << std::endl;
+                ++it;
             }
-            
-            it = pending_changes_.erase(it);
+        }
+    }
+    
+    for (const auto& path : due) {
+        
+        ValidationResult result = reload(path);
+        
+        if (result) {
+            std::cout << "ConfigWatcher: Successfully reloaded: " 
+                      << path << std::endl;
         } else {
-            ++it;
+            std::cerr << "ConfigWatcher: Failed to reload: " 
+                      << path << std::endl;
         }
     }
 }
@@ -314,13 +322,18 @@ ValidationResult ConfigWatcher::reload(const std::filesystem::path& path) {
     }
     
     
-    if (applyConfig(path)) {
+    if (applyConfig(path, std::move(result.config))) {
         last_good_config_ = path;
         
         
         {
             std::lock_guard<std::mutex> lock(callback_mutex_);
             if (notify_callback_) {
+                // The validating parser has no Toaster; surface what the
+                // live parser used to report itself
+                for (const auto& warn : result.warnings) {
+                    notify_callback_(warn, "error");
+                }
                 notify_callback_("Configuration reloaded successfully", "success");
             }
         }
@@ -461,6 +474,11 @@ ValidationResult ConfigWatcher::validateConfig(const std::filesystem::path& path
         std::lock_guard<std::mutex> lock(callback_mutex_);
         if (validation_callback_) {
             ValidationResult custom_result = validation_callback_(path);
+            result.config = std::move(custom_result.config);
+            // Non-fatal problems come back as warnings on a successful load
+            for (const auto& warn : custom_result.warnings) {
+                result.warnings.push_back(warn);
+            }
             if (!custom_result) {
                 
                 result.success = false;
@@ -470,34 +488,22 @@ ValidationResult ConfigWatcher::validateConfig(const std::filesystem::path& path
                 for (const auto& loc : custom_result.error_locations) {
                     result.error_locations.push_back(loc);
                 }
-                for (const auto& warn : custom_result.warnings) {
-                    result.warnings.push_back(warn);
-                }
             }
         }
     }
     
     
-    if (result.error_locations.empty() && result.errors.empty()) {
-        result.success = true;
-    } else {
-        result.success = false;
-        
-        
-        for (const auto& loc : result.error_locations) {
-            std::ostringstream oss;
-            oss << "Line " << loc.line << ": " << loc.message;
-            result.errors.push_back(oss.str());
-        }
-    }
+    // Located errors stay in error_locations only; consumers report both
+    result.success = result.error_locations.empty() && result.errors.empty();
     
     return result;
 }
 
-bool ConfigWatcher::applyConfig(const std::filesystem::path& path) {
+bool ConfigWatcher::applyConfig(const std::filesystem::path& path,
+                                std::shared_ptr<const Config> config) {
     std::lock_guard<std::mutex> lock(callback_mutex_);
     if (apply_callback_) {
-        return apply_callback_(path);
+        return apply_callback_(path, std::move(config));
     }
     return false;
 }
@@ -510,8 +516,11 @@ void ConfigWatcher::reportErrors(const ValidationResult& result) {
     }
     
     for (const auto& loc : result.error_locations) {
-        std::cerr << "  Line " << loc.line << ", Col " << loc.column 
-                  << ": " << loc.message << std::endl;
+        std::cerr << "  Line " << loc.line;
+        if (loc.column > 0) {
+            std::cerr << ", Col " << loc.column;
+        }
+        std::cerr << ": " << loc.message << std::endl;
         if (!loc.context.empty()) {
             std::cerr << "    Context: " << loc.context << std::endl;
         }
@@ -530,8 +539,9 @@ void ConfigWatcher::reportErrors(const ValidationResult& result) {
         
         
         if (notify_callback_) {
+            size_t count = result.errors.size() + result.error_locations.size();
             std::string msg = "Configuration validation failed with " + 
-                             std::to_string(result.errors.size()) + " error(s)";
+                             std::to_string(count) + " error(s)";
             notify_callback_(msg, "error");
         }
     }
@@ -0,0 +1,63 @@
+/**
+ * @brief Build-time compiler for the embedded default config
+ *
+ * Interprets ConfigParser::getEmbeddedConfig() and writes the serialized
+ * Config as a byte array for EmbeddedConfig.cpp to include. Fails the build
+ * if the config does not parse cleanly or if decoding the bytes does not
+ * give back the Config that parsing the text produced.
+ *
+ * Usage: pblank-config-compiler <output.inc>
+ */
+
+#include "pointblank/config/ConfigParser.hpp"
+#include "pointblank/config/ConfigCache.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace pblank;
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "usage: " << argv[0] << " <output.inc>" << std::endl;
+        return 2;
+    }
+
+    ConfigParser parser(nullptr);
+    if (!parser.loadFromString(ConfigParser::getEmbeddedConfig()) || !parser.getErrors().empty()) {
+        std::cerr << "Embedded default config does not parse:" << std::endl;
+        for (const auto& error : parser.getErrors()) {
+            std::cerr << "  " << error << std::endl;
+        }
+        return 1;
+    }
+
+
+    const Config& parsed = parser.getConfig();
+    std::string payload = ConfigCache::encode(parsed);
+    Config decoded;
+    if (!ConfigCache::decode(payload, decoded) || !(decoded == parsed)) {
+        std::cerr << "Embedded default config does not survive encode/decode; "
+                     "check the fields() lists in ConfigCache.cpp" << std::endl;
+        return 1;
+    }
+
+
+    std::ofstream out(argv[1], std::ios::trunc);
+    out << "// Generated by pblank-config-compiler from ConfigParser::getEmbeddedConfig().\n"
+        << "// Do not edit.\n\n"
+        << "alignas(8) static constexpr unsigned char EMBEDDED_CONFIG[] = {";
+    for (size_t i = 0; i < payload.size(); ++i) {
+        char byte[16];
+        std::snprintf(byte, sizeof(byte), "%s0x%02x,", i % 16 ? " " : "\n    ",
+                      static_cast<unsigned char>(payload[i]));
+        out << byte;
+    }
+    out << "\n};\n";
+
+    if (!out) {
+        std::cerr << "Failed to write " << argv[1] << std::endl;
+        return 1;
+    }
+    return 0;
+}
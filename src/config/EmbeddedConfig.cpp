@@ -0,0 +1,32 @@
+#include "pointblank/config/ConfigParser.hpp"
+#include "pointblank/config/ConfigCache.hpp"
+#include <iostream>
+
+namespace pblank {
+
+namespace {
+
+// Serialized Config produced by pblank-config-compiler at build time
+#include "EmbeddedConfigData.inc"
+
+}
+
+
+bool ConfigParser::loadEmbeddedConfig() {
+    std::string_view payload(reinterpret_cast<const char*>(EMBEDDED_CONFIG), sizeof(EMBEDDED_CONFIG));
+
+    Config config;
+    if (!ConfigCache::decode(payload, config)) {
+        // Only possible if the generated data is stale; the text is still good
+        std::cerr << "[ConfigParser] Precompiled default config is unreadable, parsing it" << std::endl;
+        config_ = Config{};
+        return loadFromString(getEmbeddedConfig());
+    }
+
+    config_ = std::move(config);
+    imported_modules_.clear();
+    publish();
+    return true;
+}
+
+}
@@ -6,17 +6,89 @@
 #include <sstream>
 #include <cmath>
 #include <cctype>
+#include <charconv>
 #include <cstdlib>
-#include <regex>
+#include <climits>
 
 namespace pblank {
 
+namespace {
+
+/** @brief Explicit IDs up to this go in the direct table, larger ones become intervals */
+constexpr int MAX_DIRECT_WORKSPACE = 1024;
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+    return text;
+}
+
+bool parseWorkspaceId(std::string_view text, int& out) {
+    text = trim(text);
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    return ec == std::errc() && end == text.data() + text.size() && out >= 1;
+}
+
+/** @brief Rule parameters take the same names as the global layout settings */
+void setParameter(LayoutConfig::WorkspaceLayout& layout, const std::string& name,
+                  const std::variant<int, double, std::string, bool>& value) {
+    auto* i = std::get_if<int>(&value);
+    auto* d = std::get_if<double>(&value);
+    auto* b = std::get_if<bool>(&value);
+    
+    if (name == "gap_size" && i) {
+        layout.bsp.gap_size = *i;
+        layout.master_stack.gap_size = *i;
+        layout.centered_master.gap_size = *i;
+        layout.dynamic_grid.gap_size = *i;
+        layout.dwindle_spiral.gap_size = *i;
+    } else if (name == "border_width" && i) {
+        layout.bsp.border_width = *i;
+    } else if (name == "padding" && i) {
+        layout.bsp.padding = *i;
+    } else if (name == "dwindle" && b) {
+        layout.bsp.dwindle = *b;
+    } else if (name == "master_ratio" && d) {
+        layout.master_stack.master_ratio = *d;
+    } else if (name == "max_master" && i) {
+        layout.master_stack.max_master = *i;
+    } else if (name == "center_ratio" && d) {
+        layout.centered_master.center_ratio = *d;
+    } else if (name == "max_center" && i) {
+        layout.centered_master.max_center = *i;
+    } else if (name == "center_on_focus" && b) {
+        layout.centered_master.center_on_focus = *b;
+    } else if (name == "prefer_horizontal" && b) {
+        layout.dynamic_grid.prefer_horizontal = *b;
+    } else if (name == "min_cell_width" && i) {
+        layout.dynamic_grid.min_cell_width = *i;
+    } else if (name == "min_cell_height" && i) {
+        layout.dynamic_grid.min_cell_height = *i;
+    } else if (name == "initial_ratio" && d) {
+        layout.dwindle_spiral.initial_ratio = *d;
+    } else if (name == "ratio_increment" && d) {
+        layout.dwindle_spiral.ratio_increment = *d;
+    } else if (name == "shift_by_focus" && b) {
+        layout.dwindle_spiral.shift_by_focus = *b;
+    } else if (name == "tab_height" && i) {
+        layout.tabbed_stacked.tab_height = *i;
+    } else if (name == "tab_min_width" && i) {
+        layout.tabbed_stacked.tab_min_width = *i;
+    } else if (name == "show_focused_only" && b) {
+        layout.tabbed_stacked.show_focused_only = *b;
+    } else if (name == "tab_at_top" && b) {
+        layout.tabbed_stacked.tab_at_top = *b;
+    }
+}
+
+}
 
 
 
 
-LayoutLexer::LayoutLexer(std::string source)
-    : source_(std::move(source)) {}
+
+LayoutLexer::LayoutLexer(std::string_view source)
+    : source_(source) {}
 
 std::vector<LayoutToken> LayoutLexer::tokenize() {
     std::vector<LayoutToken> tokens;
@@ -188,34 +260,41 @@ void LayoutLexer::skipComment() {
 }
 
 LayoutToken LayoutLexer::makeToken(LayoutTokenType type) {
-    return LayoutToken(type, std::string(1, source_[current_ - 1]), line_, column_ - 1);
+    size_t at = current_ > 0 ? current_ - 1 : 0;
+    return LayoutToken(type, source_.substr(at, 1), line_, column_ - 1);
 }
 
 LayoutToken LayoutLexer::number() {
     int start_col = column_;
-    std::string num_str;
+    size_t start = current_;
     
     
     if (peek() == '-') {
-        num_str += advance();
+        advance();
     }
     
     while (!isAtEnd() && std::isdigit(peek())) {
-        num_str += advance();
+        advance();
     }
     
     
     if (peek() == '.' && std::isdigit(peekNext())) {
-        num_str += advance(); 
+        advance(); 
         while (!isAtEnd() && std::isdigit(peek())) {
-            num_str += advance();
+            advance();
         }
-        return LayoutToken(LayoutTokenType::Float, num_str, line_, start_col, 
-                          std::stod(num_str));
+        std::string_view num = source_.substr(start, current_ - start);
+        double value = 0.0;
+        std::from_chars(num.data(), num.data() + num.size(), value);
+        return LayoutToken(LayoutTokenType::Float, num, line_, start_col, value);
     }
     
-    return LayoutToken(LayoutTokenType::Integer, num_str, line_, start_col, 
-                      std::stoi(num_str));
+    std::string_view num = source_.substr(start, current_ - start);
+    int value = 0;
+    if (std::from_chars(num.data(), num.data() + num.size(), value).ec != std::errc{}) {
+        addError("Integer out of range: " + std::string(num));
+    }
+    return LayoutToken(LayoutTokenType::Integer, num, line_, start_col, value);
 }
 
 LayoutToken LayoutLexer::stringLiteral() {
@@ -223,33 +302,44 @@ LayoutToken LayoutLexer::stringLiteral() {
     int start_col = column_;
     advance(); 
     
-    std::string value;
+    size_t start = current_;
+    bool escaped = false;
     while (!isAtEnd() && peek() != '"') {
         if (peek() == '\n') {
             addError("Unterminated string");
             break;
         }
         if (peek() == '\\') {
+            escaped = true;
             advance();
-            if (!isAtEnd()) {
-                char escaped = advance();
-                switch (escaped) {
-                    case 'n': value += '\n'; break;
-                    case 't': value += '\t'; break;
-                    case 'r': value += '\r'; break;
-                    case '\\': value += '\\'; break;
-                    case '"': value += '"'; break;
-                    default: value += escaped; break;
-                }
+            if (isAtEnd()) break;
+        }
+        advance();
+    }
+    
+    std::string_view value = source_.substr(start, current_ - start);
+    if (escaped) {
+        // Only literals with escapes need their own storage
+        std::string& decoded = decoded_.emplace_back();
+        decoded.reserve(value.size());
+        for (size_t i = 0; i < value.size(); ++i) {
+            if (value[i] != '\\' || i + 1 >= value.size()) {
+                decoded += value[i];
+                continue;
+            }
+            switch (char c = value[++i]) {
+                case 'n': decoded += '\n'; break;
+                case 't': decoded += '\t'; break;
+                case 'r': decoded += '\r'; break;
+                default: decoded += c; break;
             }
-        } else {
-            value += advance();
         }
+        value = decoded;
     }
     
     if (isAtEnd()) {
         addError("Unterminated string");
-    } else {
+    } else if (peek() == '"') {
         advance(); 
     }
     
@@ -258,14 +348,15 @@ LayoutToken LayoutLexer::stringLiteral() {
 
 LayoutToken LayoutLexer::identifier() {
     int start_col = column_;
-    std::string ident;
+    size_t start = current_;
     
     while (!isAtEnd() && (std::isalnum(peek()) || peek() == '_')) {
-        ident += advance();
+        advance();
     }
+    std::string_view ident = source_.substr(start, current_ - start);
     
     
-    static const std::unordered_map<std::string, LayoutTokenType> keywords = {
+    static const std::unordered_map<std::string_view, LayoutTokenType> keywords = {
         {"let", LayoutTokenType::Let},
         {"layout", LayoutTokenType::Layout},
         {"workspace", LayoutTokenType::Workspace},
@@ -292,23 +383,25 @@ LayoutToken LayoutLexer::identifier() {
 LayoutToken LayoutLexer::preprocessor() {
     int start_line = line_;
     int start_col = column_;
+    size_t start = current_;
     advance(); 
     
-    std::string directive;
+    size_t dir_start = current_;
     while (!isAtEnd() && (std::isalpha(peek()) || peek() == '_' || peek() == '.')) {
-        directive += advance();
+        advance();
     }
+    std::string_view directive = source_.substr(dir_start, current_ - dir_start);
     
     
     if (directive == "include") {
         
         skipWhitespace();
-        std::string next_word;
+        size_t word_start = current_;
         while (!isAtEnd() && (std::isalpha(peek()) || peek() == '_')) {
-            next_word += advance();
+            advance();
         }
         
-        if (next_word == "layout") {
+        if (source_.substr(word_start, current_ - word_start) == "layout") {
             return LayoutToken(LayoutTokenType::IncludeLayout, "#include layout", 
                              start_line, start_col);
         }
@@ -318,19 +411,20 @@ LayoutToken LayoutLexer::preprocessor() {
     if (directive == "included.layout") {
         
         skipWhitespace();
-        std::string next_word;
+        size_t word_start = current_;
         while (!isAtEnd() && (std::isalpha(peek()) || peek() == '_')) {
-            next_word += advance();
+            advance();
         }
         
-        if (next_word == "user") {
+        if (source_.substr(word_start, current_ - word_start) == "user") {
             return LayoutToken(LayoutTokenType::IncludeLayoutUser, "#included.layout user", 
                              start_line, start_col);
         }
     }
     
-    addError("Unknown preprocessor directive: #" + directive);
-    return LayoutToken(LayoutTokenType::Invalid, "#" + directive, start_line, start_col);
+    addError("Unknown preprocessor directive: #" + std::string(directive));
+    return LayoutToken(LayoutTokenType::Invalid, source_.substr(start, dir_start - start + directive.size()),
+                       start_line, start_col);
 }
 
 void LayoutLexer::addError(const std::string& message) {
@@ -387,8 +481,16 @@ const LayoutToken& LayoutParser::consume(LayoutTokenType type, const std::string
     throw std::runtime_error(message);
 }
 
+template<typename T>
+std::span<T*> LayoutParser::takeFrom(std::vector<T*>& stack, size_t mark) {
+    auto out = arena_->copy(stack.data() + mark, stack.size() - mark);
+    stack.resize(mark);
+    return out;
+}
+
 std::unique_ptr<layout_ast::LayoutConfigFile> LayoutParser::configFile() {
     auto config = std::make_unique<layout_ast::LayoutConfigFile>();
+    arena_ = &config->arena;
     
     
     config->includes = includes();
@@ -410,7 +512,7 @@ std::vector<layout_ast::LayoutIncludeDirective> LayoutParser::includes() {
         
         
         if (match({LayoutTokenType::String})) {
-            directive.layout_name = std::get<std::string>(previous().literal_value);
+            directive.layout_name = std::get<std::string_view>(previous().literal_value);
         } else if (match({LayoutTokenType::Identifier})) {
             directive.layout_name = std::string{previous().lexeme};
         } else {
@@ -424,12 +526,12 @@ std::vector<layout_ast::LayoutIncludeDirective> LayoutParser::includes() {
     return directives;
 }
 
-std::unique_ptr<layout_ast::LayoutBlock> LayoutParser::block() {
-    auto blk = std::make_unique<layout_ast::LayoutBlock>();
+layout_ast::LayoutBlock* LayoutParser::block() {
+    auto blk = arena_->make<layout_ast::LayoutBlock>();
     
     
     if (match({LayoutTokenType::Identifier})) {
-        blk->name = std::string{previous().lexeme};
+        blk->name = arena_->copy(previous().lexeme);
     }
     
     
@@ -439,12 +541,14 @@ std::unique_ptr<layout_ast::LayoutBlock> LayoutParser::block() {
     }
     
     
+    size_t mark = statement_stack_.size();
     while (!check(LayoutTokenType::RightBrace) && !isAtEnd()) {
         auto stmt = statement();
         if (stmt) {
-            blk->statements.push_back(std::move(stmt));
+            statement_stack_.push_back(stmt);
         }
     }
+    blk->statements = takeFrom(statement_stack_, mark);
     
     
     if (!match({LayoutTokenType::RightBrace})) {
@@ -454,7 +558,7 @@ std::unique_ptr<layout_ast::LayoutBlock> LayoutParser::block() {
     return blk;
 }
 
-std::unique_ptr<layout_ast::LayoutStatement> LayoutParser::statement() {
+layout_ast::LayoutStatement* LayoutParser::statement() {
     
     if (match({LayoutTokenType::Layout})) {
         return layoutRule();
@@ -467,11 +571,9 @@ std::unique_ptr<layout_ast::LayoutStatement> LayoutParser::statement() {
     
     
     if (check(LayoutTokenType::Identifier)) {
-        auto next = tokens_[current_ + 1];
+        const auto& next = tokens_[current_ + 1];
         if (next.type == LayoutTokenType::LeftBrace) {
-            return std::make_unique<layout_ast::LayoutStatement>(
-                layout_ast::LayoutStatementValue{block()}
-            );
+            return arena_->make<layout_ast::LayoutStatement>(block());
         }
     }
     
@@ -480,12 +582,12 @@ std::unique_ptr<layout_ast::LayoutStatement> LayoutParser::statement() {
     return nullptr;
 }
 
-std::unique_ptr<layout_ast::LayoutStatement> LayoutParser::layoutRule() {
+layout_ast::LayoutStatement* LayoutParser::layoutRule() {
     layout_ast::LayoutRule rule;
     
     
     if (match({LayoutTokenType::String})) {
-        rule.workspace_pattern = std::get<std::string>(previous().literal_value);
+        rule.workspace_pattern = std::get<std::string_view>(previous().literal_value);
     } else if (match({LayoutTokenType::Identifier})) {
         rule.workspace_pattern = std::string{previous().lexeme};
     } else if (match({LayoutTokenType::Integer})) {
@@ -527,28 +629,15 @@ std::unique_ptr<layout_ast::LayoutStatement> LayoutParser::layoutRule() {
                 
                 auto value_expr = expression();
                 if (value_expr) {
-                    
-                    try {
-                        auto val = std::make_unique<layout_ast::LayoutExpression>(
-                            layout_ast::LayoutExpressionValue{
-                                layout_ast::IntLiteral{0}
-                            }
-                        );
-                        
-                        if (std::holds_alternative<layout_ast::IntLiteral>(value_expr->value)) {
-                            rule.parameters[param_name] = 
-                                std::get<layout_ast::IntLiteral>(value_expr->value).value;
-                        } else if (std::holds_alternative<layout_ast::FloatLiteral>(value_expr->value)) {
-                            rule.parameters[param_name] = 
-                                std::get<layout_ast::FloatLiteral>(value_expr->value).value;
-                        } else if (std::holds_alternative<layout_ast::StringLiteral>(value_expr->value)) {
-                            rule.parameters[param_name] = 
-                                std::get<layout_ast::StringLiteral>(value_expr->value).value;
-                        } else if (std::holds_alternative<layout_ast::BoolLiteral>(value_expr->value)) {
-                            rule.parameters[param_name] = 
-                                std::get<layout_ast::BoolLiteral>(value_expr->value).value;
-                        }
-                    } catch (...) {}
+                    if (auto* i = std::get_if<layout_ast::IntLiteral>(&value_expr->value)) {
+                        rule.parameters[param_name] = i->value;
+                    } else if (auto* f = std::get_if<layout_ast::FloatLiteral>(&value_expr->value)) {
+                        rule.parameters[param_name] = f->value;
+                    } else if (auto* str = std::get_if<layout_ast::StringLiteral>(&value_expr->value)) {
+                        rule.parameters[param_name] = std::string(str->value);
+                    } else if (auto* b = std::get_if<layout_ast::BoolLiteral>(&value_expr->value)) {
+                        rule.parameters[param_name] = b->value;
+                    }
                 }
                 
                 match({LayoutTokenType::Semicolon});
@@ -564,20 +653,20 @@ std::unique_ptr<layout_ast::LayoutStatement> LayoutParser::layoutRule() {
     
     match({LayoutTokenType::Semicolon});
     
-    return std::make_unique<layout_ast::LayoutStatement>(
-        layout_ast::LayoutStatementValue{std::move(rule)}
+    return arena_->make<layout_ast::LayoutStatement>(
+        arena_->make<layout_ast::LayoutRule>(std::move(rule))
     );
 }
 
-std::unique_ptr<layout_ast::LayoutStatement> LayoutParser::assignment() {
-    layout_ast::LayoutAssignment assignment;
+layout_ast::LayoutStatement* LayoutParser::assignment() {
+    layout_ast::LayoutAssignment assignment{};
     
     
     if (!match({LayoutTokenType::Identifier})) {
         addError("Expected variable name after 'let'");
         return nullptr;
     }
-    assignment.name = std::string{previous().lexeme};
+    assignment.name = arena_->copy(previous().lexeme);
     
     
     if (!match({LayoutTokenType::Assign})) {
@@ -590,52 +679,40 @@ std::unique_ptr<layout_ast::LayoutStatement> LayoutParser::assignment() {
     
     match({LayoutTokenType::Semicolon});
     
-    return std::make_unique<layout_ast::LayoutStatement>(
-        layout_ast::LayoutStatementValue{std::move(assignment)}
-    );
+    return arena_->make<layout_ast::LayoutStatement>(assignment);
 }
 
-std::unique_ptr<layout_ast::LayoutExpression> LayoutParser::expression() {
+layout_ast::LayoutExpression* LayoutParser::expression() {
     return logicalOr();
 }
 
-std::unique_ptr<layout_ast::LayoutExpression> LayoutParser::logicalOr() {
+layout_ast::LayoutExpression* LayoutParser::logicalOr() {
     auto left = logicalAnd();
     
     while (match({LayoutTokenType::Or})) {
         auto right = logicalAnd();
-        auto bin = layout_ast::BinaryOp{
-            layout_ast::BinaryOp::Op::Or,
-            std::move(left),
-            std::move(right)
-        };
-        left = std::make_unique<layout_ast::LayoutExpression>(
-            layout_ast::LayoutExpressionValue{std::move(bin)}
+        left = arena_->make<layout_ast::LayoutExpression>(
+            layout_ast::BinaryOp{layout_ast::BinaryOp::Op::Or, left, right}
         );
     }
     
     return left;
 }
 
-std::unique_ptr<layout_ast::LayoutExpression> LayoutParser::logicalAnd() {
+layout_ast::LayoutExpression* LayoutParser::logicalAnd() {
     auto left = equality();
     
     while (match({LayoutTokenType::And})) {
         auto right = equality();
-        auto bin = layout_ast::BinaryOp{
-            layout_ast::BinaryOp::Op::And,
-            std::move(left),
-            std::move(right)
-        };
-        left = std::make_unique<layout_ast::LayoutExpression>(
-            layout_ast::LayoutExpressionValue{std::move(bin)}
+        left = arena_->make<layout_ast::LayoutExpression>(
+            layout_ast::BinaryOp{layout_ast::BinaryOp::Op::And, left, right}
         );
     }
     
     return left;
 }
 
-std::unique_ptr<layout_ast::LayoutExpression> LayoutParser::equality() {
+layout_ast::LayoutExpression* LayoutParser::equality() {
     auto left = comparison();
     
     while (match({LayoutTokenType::Equals, LayoutTokenType::NotEquals})) {
@@ -643,16 +720,13 @@ std::unique_ptr<layout_ast::LayoutExpression> LayoutParser::equality() {
             ? layout_ast::BinaryOp::Op::Eq 
             : layout_ast::BinaryOp::Op::Ne;
         auto right = comparison();
-        auto bin = layout_ast::BinaryOp{op, std::move(left), std::move(right)};
-        left = std::make_unique<layout_ast::LayoutExpression>(
-            layout_ast::LayoutExpressionValue{std::move(bin)}
-        );
+        left = arena_->make<layout_ast::LayoutExpression>(layout_ast::BinaryOp{op, left, right});
     }
     
     return left;
 }
 
-std::unique_ptr<layout_ast::LayoutExpression> LayoutParser::comparison() {
+layout_ast::LayoutExpression* LayoutParser::comparison() {
     auto left = term();
     
     while (match({LayoutTokenType::Less, LayoutTokenType::Greater, 
@@ -666,16 +740,13 @@ std::unique_ptr<layout_ast::LayoutExpression> LayoutParser::comparison() {
             default: op = layout_ast::BinaryOp::Op::Lt; break;
         }
         auto right = term();
-        auto bin = layout_ast::BinaryOp{op, std::move(left), std::move(right)};
-        left = std::make_unique<layout_ast::LayoutExpression>(
-            layout_ast::LayoutExpressionValue{std::move(bin)}
-        );
+        left = arena_->make<layout_ast::LayoutExpression>(layout_ast::BinaryOp{op, left, right});
     }
     
     return left;
 }
 
-std::unique_ptr<layout_ast::LayoutExpression> LayoutParser::term() {
+layout_ast::LayoutExpression* LayoutParser::term() {
     auto left = factor();
     
     while (match({LayoutTokenType::Plus, LayoutTokenType::Minus})) {
@@ -683,16 +754,13 @@ std::unique_ptr<layout_ast::LayoutExpression> LayoutParser::term() {
             ? layout_ast::BinaryOp::Op::Add 
             : layout_ast::BinaryOp::Op::Sub;
         auto right = factor();
-        auto bin = layout_ast::BinaryOp{op, std::move(left), std::move(right)};
-        left = std::make_unique<layout_ast::LayoutExpression>(
-            layout_ast::LayoutExpressionValue{std::move(bin)}
-        );
+        left = arena_->make<layout_ast::LayoutExpression>(layout_ast::BinaryOp{op, left, right});
     }
     
     return left;
 }
 
-std::unique_ptr<layout_ast::LayoutExpression> LayoutParser::factor() {
+layout_ast::LayoutExpression* LayoutParser::factor() {
     auto left = unary();
     
     while (match({LayoutTokenType::Star, LayoutTokenType::Slash})) {
@@ -700,77 +768,59 @@ std::unique_ptr<layout_ast::LayoutExpression> LayoutParser::factor() {
             ? layout_ast::BinaryOp::Op::Mul 
             : layout_ast::BinaryOp::Op::Div;
         auto right = unary();
-        auto bin = layout_ast::BinaryOp{op, std::move(left), std::move(right)};
-        left = std::make_unique<layout_ast::LayoutExpression>(
-            layout_ast::LayoutExpressionValue{std::move(bin)}
-        );
+        left = arena_->make<layout_ast::LayoutExpression>(layout_ast::BinaryOp{op, left, right});
     }
     
     return left;
 }
 
-std::unique_ptr<layout_ast::LayoutExpression> LayoutParser::unary() {
+layout_ast::LayoutExpression* LayoutParser::unary() {
     if (match({LayoutTokenType::Not, LayoutTokenType::Minus})) {
         auto op = (previous().type == LayoutTokenType::Not) 
             ? layout_ast::UnaryOp::Op::Not 
             : layout_ast::UnaryOp::Op::Neg;
         auto operand = unary();
-        auto un = layout_ast::UnaryOp{op, std::move(operand)};
-        return std::make_unique<layout_ast::LayoutExpression>(
-            layout_ast::LayoutExpressionValue{std::move(un)}
-        );
+        return arena_->make<layout_ast::LayoutExpression>(layout_ast::UnaryOp{op, operand});
     }
     
     return primary();
 }
 
-std::unique_ptr<layout_ast::LayoutExpression> LayoutParser::primary() {
+layout_ast::LayoutExpression* LayoutParser::primary() {
     
     if (match({LayoutTokenType::Integer})) {
-        return std::make_unique<layout_ast::LayoutExpression>(
-            layout_ast::LayoutExpressionValue{
-                layout_ast::IntLiteral{std::get<int>(previous().literal_value)}
-            }
+        return arena_->make<layout_ast::LayoutExpression>(
+            layout_ast::IntLiteral{std::get<int>(previous().literal_value)}
         );
     }
     
     
     if (match({LayoutTokenType::Float})) {
-        return std::make_unique<layout_ast::LayoutExpression>(
-            layout_ast::LayoutExpressionValue{
-                layout_ast::FloatLiteral{std::get<double>(previous().literal_value)}
-            }
+        return arena_->make<layout_ast::LayoutExpression>(
+            layout_ast::FloatLiteral{std::get<double>(previous().literal_value)}
         );
     }
     
     
     if (match({LayoutTokenType::String})) {
-        return std::make_unique<layout_ast::LayoutExpression>(
-            layout_ast::LayoutExpressionValue{
-                layout_ast::StringLiteral{std::get<std::string>(previous().literal_value)}
-            }
+        return arena_->make<layout_ast::LayoutExpression>(
+            layout_ast::StringLiteral{arena_->copy(std::get<std::string_view>(previous().literal_value))}
         );
     }
     
     
     if (match({LayoutTokenType::TokTrue})) {
-        return std::make_unique<layout_ast::LayoutExpression>(
-            layout_ast::LayoutExpressionValue{layout_ast::BoolLiteral{true}}
-        );
+        return arena_->make<layout_ast::LayoutExpression>(layout_ast::BoolLiteral{true});
     }
     
     if (match({LayoutTokenType::TokFalse})) {
-        return std::make_unique<layout_ast::LayoutExpression>(
-            layout_ast::LayoutExpressionValue{layout_ast::BoolLiteral{false}}
-        );
+        return arena_->make<layout_ast::LayoutExpression>(layout_ast::BoolLiteral{false});
     }
     
     
     if (match({LayoutTokenType::Identifier})) {
-        return std::make_unique<layout_ast::LayoutExpression>(
-            layout_ast::LayoutExpressionValue{
-                layout_ast::Identifier{std::string{previous().lexeme}}
-            }
+        return arena_->make<layout_ast::LayoutExpression>(
+            layout_ast::Identifier{arena_->copy(previous().lexeme)}
         );
     }
     
@@ -785,23 +835,21 @@ std::unique_ptr<layout_ast::LayoutExpression> LayoutParser::primary() {
     
     
     if (match({LayoutTokenType::LeftBracket})) {
-        layout_ast::ArrayLiteral arr;
+        size_t mark = element_stack_.size();
         while (!check(LayoutTokenType::RightBracket) && !isAtEnd()) {
-            arr.elements.push_back(expression());
+            element_stack_.push_back(expression());
             if (!match({LayoutTokenType::Comma})) break;
         }
         if (!match({LayoutTokenType::RightBracket})) {
             addError("Expected ']' after array elements");
         }
-        return std::make_unique<layout_ast::LayoutExpression>(
-            layout_ast::LayoutExpressionValue{std::move(arr)}
+        return arena_->make<layout_ast::LayoutExpression>(
+            layout_ast::ArrayLiteral{takeFrom(element_stack_, mark)}
         );
     }
     
     addError("Expected expression");
-    return std::make_unique<layout_ast::LayoutExpression>(
-        layout_ast::LayoutExpressionValue{layout_ast::IntLiteral{0}}
-    );
+    return arena_->make<layout_ast::LayoutExpression>(layout_ast::IntLiteral{0});
 }
 
 void LayoutParser::addError(const std::string& message) {
@@ -976,7 +1024,11 @@ bool LayoutConfigParser::loadLayout(const std::string& filename, bool is_user) {
     parsed_layouts_[filename] = std::move(ast);
     
     
-    return interpret(*parsed_layouts_[filename]);
+    bool result = interpret(*parsed_layouts_[filename]);
+    if (include_stack_.empty()) {
+        config_.workspace_layouts.compile(config_);
+    }
+    return result;
 }
 
 std::optional<std::filesystem::path> LayoutConfigParser::findLayoutFile(
@@ -1158,17 +1210,13 @@ void LayoutConfigParser::evaluateStatement(const layout_ast::LayoutStatement& st
                     config_.wrap_cycle = std::get<bool>(value);
                 }
             }
-        } else if constexpr (std::is_same_v<T, std::unique_ptr<layout_ast::LayoutBlock>>) {
+        } else if constexpr (std::is_same_v<T, layout_ast::LayoutBlock*>) {
             if (arg) {
                 evaluateBlock(*arg);
             }
-        } else if constexpr (std::is_same_v<T, layout_ast::LayoutRule>) {
-            
-            auto workspaces = parseWorkspacePattern(arg.workspace_pattern);
-            for (int ws : workspaces) {
-                config_.workspace_modes[ws] = arg.mode;
-            }
-            config_.layout_rules.push_back(arg);
+        } else if constexpr (std::is_same_v<T, layout_ast::LayoutRule*>) {
+            // Compiled into workspace_layouts once the whole file is loaded
+            config_.layout_rules.push_back(*arg);
         }
     }, stmt.value);
 }
@@ -1184,7 +1232,7 @@ LayoutConfigParser::evaluateExpression(const layout_ast::LayoutExpression& expr)
         } else if constexpr (std::is_same_v<T, layout_ast::FloatLiteral>) {
             return arg.value;
         } else if constexpr (std::is_same_v<T, layout_ast::StringLiteral>) {
-            return arg.value;
+            return std::string(arg.value);
         } else if constexpr (std::is_same_v<T, layout_ast::BoolLiteral>) {
             return arg.value;
         } else if constexpr (std::is_same_v<T, layout_ast::Identifier>) {
@@ -1264,57 +1312,93 @@ LayoutConfigParser::evaluateExpression(const layout_ast::LayoutExpression& expr)
     }, expr.value);
 }
 
-std::vector<int> LayoutConfigParser::parseWorkspacePattern(const std::string& pattern) {
-    std::vector<int> workspaces;
-    
-    if (pattern == "*" || pattern == "all") {
+void LayoutConfig::WorkspaceLayouts::compile(const LayoutConfig& config) {
+    layouts_.clear();
+    direct_.clear();
+    intervals_.clear();
+    
+    for (const auto& rule : config.layout_rules) {
+        auto index = static_cast<int32_t>(layouts_.size());
+        auto& layout = layouts_.emplace_back();
+        layout.mode = rule.mode;
+        layout.bsp = config.bsp_params;
+        layout.master_stack = config.master_stack_params;
+        layout.centered_master = config.centered_master_params;
+        layout.dynamic_grid = config.dynamic_grid_params;
+        layout.dwindle_spiral = config.dwindle_spiral_params;
+        layout.tabbed_stacked = config.tabbed_stacked_params;
+        for (const auto& [name, value] : rule.parameters) {
+            setParameter(layout, name, value);
+        }
+        
         
-        for (int i = 1; i <= 12; ++i) {
-            workspaces.push_back(i);
+        std::string_view pattern = trim(rule.workspace_pattern);
+        if (pattern == "*" || pattern == "all") {
+            cover(1, INT_MAX, index);
+            continue;
         }
-        return workspaces;
-    }
-    
-    
-    std::regex range_regex(R"((\d+)-(\d+))");
-    std::smatch range_match;
-    if (std::regex_match(pattern, range_match, range_regex)) {
-        int start = std::stoi(range_match[1].str());
-        int end = std::stoi(range_match[2].str());
-        for (int i = start; i <= end; ++i) {
-            if (i >= 1 && i <= 12) {
-                workspaces.push_back(i);
+        
+        // Comma-separated IDs and first-last ranges
+        while (!pattern.empty()) {
+            size_t comma = pattern.find(',');
+            std::string_view item = pattern.substr(0, comma);
+            pattern = comma == std::string_view::npos ? std::string_view{} : pattern.substr(comma + 1);
+            
+            int first = 0;
+            int last = 0;
+            size_t dash = item.find('-');
+            bool valid = dash == std::string_view::npos
+                ? parseWorkspaceId(item, first) && parseWorkspaceId(item, last)
+                : parseWorkspaceId(item.substr(0, dash), first) && parseWorkspaceId(item.substr(dash + 1), last);
+            if (!valid || first > last) {
+                continue;
             }
-        }
-        return workspaces;
-    }
-    
-    
-    std::regex list_regex(R"((\d+)(?:,(\d+))*)");
-    std::smatch list_match;
-    if (std::regex_match(pattern, list_match, list_regex)) {
-        std::stringstream ss(pattern);
-        std::string token;
-        while (std::getline(ss, token, ',')) {
-            int ws = std::stoi(token);
-            if (ws >= 1 && ws <= 12) {
-                workspaces.push_back(ws);
+            
+            if (first == last && first <= MAX_DIRECT_WORKSPACE) {
+                if (direct_.size() <= static_cast<size_t>(first)) {
+                    direct_.resize(static_cast<size_t>(first) + 1, -1);
+                }
+                direct_[first] = index;
+            } else {
+                cover(first, last, index);
             }
         }
-        return workspaces;
     }
-    
-    
-    try {
-        int ws = std::stoi(pattern);
-        if (ws >= 1 && ws <= 12) {
-            workspaces.push_back(ws);
+}
+
+void LayoutConfig::WorkspaceLayouts::cover(int first, int last, int32_t layout) {
+    // Later rules win: cut [first, last] out of what is there, then add it
+    std::vector<Interval> next;
+    next.reserve(intervals_.size() + 2);
+    for (const auto& interval : intervals_) {
+        if (interval.last < first || interval.first > last) {
+            next.push_back(interval);
+            continue;
+        }
+        if (interval.first < first) {
+            next.push_back({interval.first, first - 1, interval.layout});
+        }
+        if (interval.last > last) {
+            next.push_back({last + 1, interval.last, interval.layout});
         }
-    } catch (...) {
-        
+    }
+    next.push_back({first, last, layout});
+    std::sort(next.begin(), next.end(), [](const Interval& a, const Interval& b) { return a.first < b.first; });
+    intervals_ = std::move(next);
+}
+
+const LayoutConfig::WorkspaceLayout* LayoutConfig::WorkspaceLayouts::find(int workspace) const {
+    int32_t best = -1;
+    if (workspace >= 0 && static_cast<size_t>(workspace) < direct_.size()) {
+        best = direct_[workspace];
     }
     
-    return workspaces;
+    auto it = std::upper_bound(intervals_.begin(), intervals_.end(), workspace,
+                               [](int ws, const Interval& interval) { return ws < interval.first; });
+    if (it != intervals_.begin() && std::prev(it)->last >= workspace) {
+        best = std::max(best, std::prev(it)->layout);
+    }
+    return best >= 0 ? &layouts_[best] : nullptr;
 }
 
 void LayoutConfigParser::applyToEngine() {
@@ -1325,6 +1409,7 @@ void LayoutConfigParser::applyToEngine() {
     engine_->setBorderWidth(config_.bsp_params.border_width);
     engine_->setBorderColors(config_.focused_border_color, config_.unfocused_border_color);
     engine_->setDwindleMode(config_.bsp_params.dwindle);
+    engine_->setWorkspaceLayouts(&config_.workspace_layouts);
 }
 
 void LayoutConfigParser::reportError(const std::string& message) {
@@ -1,16 +1,144 @@
 #include "pointblank/config/StartupApps.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <string_view>
 #include <cstdlib>
-#include <thread>
-#include <chrono>
 #include <filesystem>
+#include <unordered_map>
 #include <pwd.h>
+#include <unistd.h>
 
 namespace pblank {
 
+namespace {
+
+/**
+ * Autostart cache file: a "pblank-autostart 2 <desktops>" line, then one
+ * "<mtime>\t<file name>\t<TryExec>\t<command>" line per .desktop file. An
+ * empty command marks an entry that is hidden or not shown in this desktop;
+ * the desktop list is part of the header so a different session rescans.
+ * TryExec is kept rather than resolved so a later install is picked up.
+ */
+constexpr const char* AUTOSTART_CACHE_HEADER = "pblank-autostart 2 ";
+
+struct CachedEntry {
+    int64_t mtime;
+    std::string try_exec;
+    std::string command;
+};
+
+std::string cacheHeader(const std::vector<std::string>& desktops) {
+    std::string header = AUTOSTART_CACHE_HEADER;
+    for (size_t i = 0; i < desktops.size(); ++i) {
+        if (i) header += ':';
+        header += desktops[i];
+    }
+    return header;
+}
+
+std::unordered_map<std::string, CachedEntry> readAutostartCache(const std::filesystem::path& path,
+                                                               const std::string& header) {
+    std::unordered_map<std::string, CachedEntry> entries;
+    if (path.empty()) {
+        return entries;
+    }
+    std::ifstream file(path);
+    std::string line;
+    if (!std::getline(file, line) || line != header) {
+        return entries;
+    }
+    while (std::getline(file, line)) {
+        size_t first = line.find('\t');
+        size_t second = first == std::string::npos ? first : line.find('\t', first + 1);
+        size_t third = second == std::string::npos ? second : line.find('\t', second + 1);
+        if (third == std::string::npos) {
+            continue;
+        }
+        try {
+            entries[line.substr(first + 1, second - first - 1)] =
+                CachedEntry{std::stoll(line.substr(0, first)),
+                            line.substr(second + 1, third - second - 1),
+                            line.substr(third + 1)};
+        } catch (const std::exception&) {
+        }
+    }
+    return entries;
+}
+
+void writeAutostartCache(const std::filesystem::path& path, const std::string& header,
+                         const std::unordered_map<std::string, CachedEntry>& entries) {
+    if (path.empty()) {
+        return;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    
+    auto tmp = path;
+    tmp += ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream file(tmp, std::ios::trunc);
+        if (!file) {
+            return;
+        }
+        file << header << '\n';
+        for (const auto& [name, entry] : entries) {
+            file << entry.mtime << '\t' << name << '\t' << entry.try_exec << '\t'
+                 << entry.command << '\n';
+        }
+        if (!file) {
+            std::filesystem::remove(tmp, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp, path, ec);
+}
+
+/** @brief TryExec check: an absolute path must be executable, a bare name must be on PATH */
+bool tryExecFound(const std::string& try_exec) {
+    if (try_exec.empty()) {
+        return true;
+    }
+    if (try_exec.find('/') != std::string::npos) {
+        return access(try_exec.c_str(), X_OK) == 0;
+    }
+    const char* path = std::getenv("PATH");
+    std::string_view dirs = path ? path : "/usr/local/bin:/usr/bin:/bin";
+    while (!dirs.empty()) {
+        size_t colon = dirs.find(':');
+        std::string dir(dirs.substr(0, colon));
+        dirs = colon == std::string_view::npos ? std::string_view{} : dirs.substr(colon + 1);
+        std::string candidate = (dir.empty() ? std::string(".") : dir) + "/" + try_exec;
+        if (access(candidate.c_str(), X_OK) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** @brief True when any name in the ';'-separated @p list is one of @p desktops */
+bool listsDesktop(std::string_view list, const std::vector<std::string>& desktops) {
+    while (!list.empty()) {
+        size_t semi = list.find(';');
+        std::string_view name = list.substr(0, semi);
+        list = semi == std::string_view::npos ? std::string_view{} : list.substr(semi + 1);
+        if (!name.empty() && std::find(desktops.begin(), desktops.end(), name) != desktops.end()) {
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+StartupApps::~StartupApps() {
+    // A scan still in flight must not outlive the object it reports to
+    if (xdg_scan_.valid()) {
+        xdg_scan_.wait();
+    }
+}
+
 void StartupApps::loadFromConfig(const std::string& config_content) {
     
     
@@ -60,105 +188,219 @@ void StartupApps::loadFromConfig(const std::string& config_content) {
 
 void StartupApps::loadXDGAutostart() {
     std::string autostart_dir = getAutostartDir();
-    
-    if (!std::filesystem::exists(autostart_dir)) {
+    if (autostart_dir.empty() || xdg_scan_.valid()) {
         return;
     }
     
+    xdg_scan_ = std::async(std::launch::async, &StartupApps::scanAutostartDir,
+                           std::filesystem::path(autostart_dir), getCachePath(),
+                           getCurrentDesktops());
+}
+
+std::vector<std::string> StartupApps::scanAutostartDir(std::filesystem::path dir,
+                                                       std::filesystem::path cache_path,
+                                                       std::vector<std::string> desktops) {
+    std::vector<std::string> commands;
+    std::error_code ec;
+    if (!std::filesystem::exists(dir, ec)) {
+        return commands;
+    }
+    
+    std::string header = cacheHeader(desktops);
+    auto cache = readAutostartCache(cache_path, header);
+    std::unordered_map<std::string, CachedEntry> seen;
+    bool changed = false;
+    
     try {
-        for (const auto& entry : std::filesystem::directory_iterator(autostart_dir)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".desktop") {
-                std::string cmd = parseDesktopFile(entry.path());
-                if (!cmd.empty()) {
-                    addApp(cmd);
-                }
+        for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+            if (!entry.is_regular_file() || entry.path().extension() != ".desktop") {
+                continue;
+            }
+            
+            std::string name = entry.path().filename().string();
+            int64_t mtime = entry.last_write_time().time_since_epoch().count();
+            
+            auto cached = cache.find(name);
+            if (cached != cache.end() && cached->second.mtime == mtime) {
+                seen.emplace(name, std::move(cached->second));
+            } else {
+                DesktopEntry parsed = parseDesktopFile(entry.path(), desktops);
+                seen.emplace(name, CachedEntry{mtime, std::move(parsed.try_exec),
+                                               std::move(parsed.command)});
+                changed = true;
             }
         }
     } catch (const std::exception& e) {
         std::cerr << "StartupApps: Error loading autostart: " << e.what() << std::endl;
+        return commands;
+    }
+    
+    if (changed || seen.size() != cache.size()) {
+        writeAutostartCache(cache_path, header, seen);
+    }
+    
+    // Directory order is arbitrary; launch in name order like other XDG sessions
+    std::vector<std::pair<std::string, std::string>> ordered;
+    for (auto& [name, entry] : seen) {
+        if (!entry.command.empty() && tryExecFound(entry.try_exec)) {
+            ordered.emplace_back(name, std::move(entry.command));
+        }
+    }
+    std::sort(ordered.begin(), ordered.end());
+    for (auto& [name, command] : ordered) {
+        commands.push_back(std::move(command));
+    }
+    return commands;
+}
+
+void StartupApps::scheduleAll() {
+    if (epoch_) {
+        return;
+    }
+    epoch_ = Clock::now();
+    for (size_t i = 0; i < apps_.size(); ++i) {
+        schedule(i);
+    }
+}
+
+void StartupApps::schedule(size_t app) {
+    if (!apps_[app].launched) {
+        timers_.push({*epoch_ + std::chrono::milliseconds(apps_[app].delay_ms), app});
     }
 }
 
-void StartupApps::launchAll() {
+void StartupApps::poll() {
+    if (xdg_scan_.valid() &&
+        xdg_scan_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        for (const auto& command : xdg_scan_.get()) {
+            addApp(command);
+        }
+    }
+    
     if (!launcher_) {
         std::cerr << "StartupApps: No launcher callback set" << std::endl;
         return;
     }
     
-    for (auto& app : apps_) {
-        if (app.launched) continue;
-        
-        if (app.delay_ms > 0) {
-            std::thread([this, &app]() {
-                std::this_thread::sleep_for(std::chrono::milliseconds(app.delay_ms));
-                if (!app.launched) {
-                    launcher_(app.command);
-                    app.launched = true;
-                }
-            }).detach();
-        } else {
-            launcher_(app.command);
-            app.launched = true;
+    auto now = Clock::now();
+    while (!timers_.empty() && timers_.top().due <= now) {
+        StartupApp& app = apps_[timers_.top().app];
+        timers_.pop();
+        if (app.launched) {
+            continue;
         }
+        app.launched = true;
+        launcher_(app.command, app.workspace);
     }
 }
 
 void StartupApps::addApp(const std::string& command, int delay_ms, int workspace) {
     apps_.emplace_back(command, delay_ms, workspace);
+    if (epoch_) {
+        schedule(apps_.size() - 1);
+    }
 }
 
-std::string StartupApps::parseDesktopFile(const std::string& path) const {
+StartupApps::DesktopEntry StartupApps::parseDesktopFile(const std::string& path,
+                                                       const std::vector<std::string>& desktops) {
     std::ifstream file(path);
     if (!file.is_open()) {
-        return "";
+        return {};
     }
     
+    bool in_entry = false;
     bool hidden = false;
-    std::string exec_cmd;
+    bool shown = true;
+    DesktopEntry entry;
     
     std::string line;
     while (std::getline(file, line)) {
-        
-        if (line.find("Hidden=true") == 0 || line.find("Hidden=true") != std::string::npos) {
-            hidden = true;
-            break;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
         }
         
-        
-        if (line.find("OnlyShownIn=") == 0) {
-            
+        // Only the [Desktop Entry] group describes the autostart; actions
+        // groups carry their own Exec lines
+        if (line[0] == '[') {
+            in_entry = line == "[Desktop Entry]";
+            continue;
+        }
+        if (!in_entry) {
             continue;
         }
         
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            continue;
+        }
+        std::string_view key(line.data(), eq);
+        std::string_view value(line.data() + eq + 1, line.size() - eq - 1);
+        while (!key.empty() && key.back() == ' ') key.remove_suffix(1);
+        while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
         
-        if (line.find("Exec=") == 0) {
-            exec_cmd = line.substr(5);
-            
+        if (key == "Hidden") {
+            hidden = value == "true";
+        } else if (key == "OnlyShownIn") {
+            shown = shown && listsDesktop(value, desktops);
+        } else if (key == "NotShownIn") {
+            shown = shown && !listsDesktop(value, desktops);
+        } else if (key == "TryExec") {
+            entry.try_exec = value;
+        } else if (key == "Exec") {
+            std::string exec_cmd(value);
             
-            
-            size_t pos;
-            while ((pos = exec_cmd.find('%')) != std::string::npos) {
-                size_t end = pos + 1;
-                if (end < exec_cmd.length()) {
-                    char c = exec_cmd[end];
-                    
-                    if (c == 'f' || c == 'F' || c == 'u' || c == 'U' ||
-                        c == 'd' || c == 'D' || c == 'n' || c == 'N' ||
-                        c == 'm' || c == 'M') {
-                        exec_cmd.erase(pos, 2);
-                    } else if (c == '%') {
-                        exec_cmd.erase(pos, 1);
-                    } else {
-                        exec_cmd.erase(pos, 1);
-                    }
-                } else {
+            // Drop field codes; "%%" is a literal percent
+            size_t pos = 0;
+            while ((pos = exec_cmd.find('%', pos)) != std::string::npos) {
+                if (pos + 1 < exec_cmd.length() && exec_cmd[pos + 1] == '%') {
                     exec_cmd.erase(pos, 1);
+                    ++pos;
+                } else {
+                    exec_cmd.erase(pos, std::min<size_t>(2, exec_cmd.length() - pos));
                 }
             }
+            entry.command = std::move(exec_cmd);
         }
     }
     
-    return hidden ? "" : exec_cmd;
+    if (hidden || !shown) {
+        entry.command.clear();
+    }
+    return entry;
+}
+
+std::vector<std::string> StartupApps::getCurrentDesktops() {
+    std::vector<std::string> desktops;
+    const char* current = std::getenv("XDG_CURRENT_DESKTOP");
+    std::string_view list = current ? current : "";
+    while (!list.empty()) {
+        size_t colon = list.find(':');
+        if (colon != 0) {
+            desktops.emplace_back(list.substr(0, colon));
+        }
+        list = colon == std::string_view::npos ? std::string_view{} : list.substr(colon + 1);
+    }
+    return desktops;
+}
+
+std::filesystem::path StartupApps::getCachePath() {
+    if (auto xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return std::filesystem::path(xdg) / "pblank" / "autostart.cache";
+    }
+    if (auto home = std::getenv("HOME"); home && *home) {
+        return std::filesystem::path(home) / ".cache" / "pblank" / "autostart.cache";
+    }
+    
+    // No cache outside the user's own home: a shared directory would let
+    // anyone plant the commands we run
+    struct passwd* pw = getpwuid(getuid());
+    if (pw && pw->pw_dir && *pw->pw_dir) {
+        return std::filesystem::path(pw->pw_dir) / ".cache" / "pblank" / "autostart.cache";
+    }
+    return {};
 }
 
 std::string StartupApps::getAutostartDir() const {
@@ -0,0 +1,164 @@
+/**
+ * @file Launcher.cpp
+ * @brief Pre-forked launch helper
+ * 
+ * @author Point Blank Systems Engineering Team
+ * @version 1.0.0
+ */
+
+#include "pointblank/core/Launcher.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace pblank {
+
+namespace {
+
+// Requests larger than this are refused rather than truncated
+constexpr size_t MAX_REQUEST = 64 * 1024;
+
+}
+
+std::mutex Launcher::mutex_;
+int Launcher::fd_ = -1;
+pid_t Launcher::helper_pid_ = -1;
+
+bool Launcher::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ != -1) {
+        return true;
+    }
+    
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) == -1) {
+        std::cerr << "[Launcher] socketpair failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    
+    pid_t parent = getpid();
+    pid_t pid = fork();
+    if (pid == -1) {
+        std::cerr << "[Launcher] fork failed: " << strerror(errno) << std::endl;
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    
+    if (pid == 0) {
+        close(fds[0]);
+        // Go down with the WM even if it dies without closing the socket
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        if (getppid() != parent) {
+            _exit(0);
+        }
+        serve(fds[1]);
+    }
+    
+    close(fds[1]);
+    fd_ = fds[0];
+    helper_pid_ = pid;
+    return true;
+}
+
+void Launcher::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ == -1) {
+        return;
+    }
+    close(fd_);
+    fd_ = -1;
+    waitpid(helper_pid_, nullptr, 0);
+    helper_pid_ = -1;
+}
+
+bool Launcher::isRunning() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fd_ != -1;
+}
+
+pid_t Launcher::spawn(const std::string& command, const SpawnOptions& options) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (fd_ == -1 || sizeof(Request) + command.size() > MAX_REQUEST) {
+        lock.unlock();
+        return spawnShell(command, options);
+    }
+    
+    Request request{static_cast<uint8_t>(options.new_session), static_cast<uint8_t>(options.null_stdio)};
+    iovec iov[2] = {
+        {&request, sizeof(request)},
+        {const_cast<char*>(command.data()), command.size()}
+    };
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    
+    Reply reply{};
+    ssize_t sent, received = -1;
+    do {
+        sent = sendmsg(fd_, &msg, MSG_NOSIGNAL);
+    } while (sent == -1 && errno == EINTR);
+    if (sent != -1) {
+        do {
+            received = recv(fd_, &reply, sizeof(reply), 0);
+        } while (received == -1 && errno == EINTR);
+    }
+    
+    if (received != static_cast<ssize_t>(sizeof(reply))) {
+        std::cerr << "[Launcher] Helper went away, spawning inline from now on" << std::endl;
+        close(fd_);
+        fd_ = -1;
+        waitpid(helper_pid_, nullptr, WNOHANG);
+        helper_pid_ = -1;
+        lock.unlock();
+        return spawnShell(command, options);
+    }
+    
+    if (reply.pid == -1) {
+        errno = reply.error;
+    }
+    return reply.pid;
+}
+
+void Launcher::serve(int fd) {
+    // Launched processes are reaped by the kernel. SIGINT from the WM's
+    // terminal is left to the WM; the helper follows it via EOF or PDEATHSIG.
+    std::signal(SIGCHLD, SIG_IGN);
+    std::signal(SIGINT, SIG_IGN);
+    std::signal(SIGTERM, SIG_DFL);
+    std::signal(SIGPIPE, SIG_IGN);
+    
+    static char buffer[MAX_REQUEST];
+    for (;;) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            _exit(0);
+        }
+        
+        Reply reply{-1, EINVAL};
+        if (static_cast<size_t>(n) >= sizeof(Request)) {
+            Request request;
+            std::memcpy(&request, buffer, sizeof(request));
+            std::string command(buffer + sizeof(request), n - sizeof(request));
+            
+            SpawnOptions options;
+            options.new_session = request.new_session;
+            options.null_stdio = request.null_stdio;
+            reply.pid = spawnShell(command, options);
+            reply.error = reply.pid == -1 ? errno : 0;
+        }
+        
+        while (send(fd, &reply, sizeof(reply), MSG_NOSIGNAL) == -1 && errno == EINTR) {
+        }
+    }
+}
+
+}
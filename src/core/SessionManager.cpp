@@ -7,6 +7,7 @@
  */
 
 #include "pointblank/core/SessionManager.hpp"
+#include "pointblank/utils/Spawn.hpp"
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -269,26 +270,15 @@ bool SessionManager::setEnvIfUnset(const char* name, const char* value,
 }
 
 bool SessionManager::runCommand(const std::string& cmd, bool background) {
-    
-    std::string full_cmd;
+    // The shell backgrounds the command and exits at once, so it is reaped
+    // here and the command itself is reparented to init.
+    int result = runShell(background ? "(" + cmd + ") &" : cmd);
     
     if (background) {
-        
-        full_cmd = "(" + cmd + ") > /dev/null 2>&1 &";
-    } else {
-        
-        full_cmd = cmd + " > /dev/null 2>&1";
-    }
-    
-    int result = system(full_cmd.c_str());
-    
-    
-    
-    if (background) {
-        return true;
+        return result != -1;
     }
     
-    return WIFEXITED(result) && WEXITSTATUS(result) == 0;
+    return result != -1 && WIFEXITED(result) && WEXITSTATUS(result) == 0;
 }
 
 bool SessionManager::ensureRuntimeDir() {
@@ -346,7 +336,7 @@ bool SessionManager::launchPortalBackend() {
         
         
         std::string check_cmd = "which " + executable + " > /dev/null 2>&1";
-        if (system(check_cmd.c_str()) == 0) {
+        if (runShell(check_cmd) == 0) {
             
             std::string launch_cmd = executable + " &";
             if (runCommand(launch_cmd, true)) {
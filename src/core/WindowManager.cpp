@@ -4,12 +4,17 @@
 #include "pointblank/config/LayoutConfigParser.hpp"
 #include "pointblank/core/Toaster.hpp"
 #include "pointblank/window/KeybindManager.hpp"
+#include "pointblank/window/WindowRuleMatcher.hpp"
 #include "pointblank/config/ConfigWatcher.hpp"
+#include "pointblank/config/StartupApps.hpp"
 #include "pointblank/display/EWMHManager.hpp"
 #include "pointblank/display/MonitorManager.hpp"
 #include "pointblank/core/SessionManager.hpp"
+#include "pointblank/core/Launcher.hpp"
+#include "pointblank/utils/Spawn.hpp"
 #include <X11/Xatom.h>
 #include <X11/cursorfont.h>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 #include <algorithm>
@@ -19,9 +24,148 @@
 #include <cerrno>
 #include <sys/wait.h>
 #include <unordered_set>
+#include <utility>
 
 namespace pblank {
 
+namespace {
+
+const char* layoutModeDisplayName(LayoutMode mode) {
+    switch (mode) {
+        case LayoutMode::BSP:            return "BSP";
+        case LayoutMode::Monocle:        return "Monocle";
+        case LayoutMode::MasterStack:    return "MasterStack";
+        case LayoutMode::CenteredMaster: return "Centered";
+        case LayoutMode::DynamicGrid:    return "Grid";
+        case LayoutMode::DwindleSpiral:  return "Dwindle";
+        case LayoutMode::TabbedStacked:  return "Tabbed";
+        default:                         return "Unknown";
+    }
+}
+
+// Work deferred while an IPC transaction is open
+constexpr uint32_t DEFER_LAYOUT          = 1u << 0;
+constexpr uint32_t DEFER_CURRENT_DESKTOP = 1u << 1;
+constexpr uint32_t DEFER_ACTIVE_WINDOW   = 1u << 2;
+constexpr uint32_t DEFER_BAR_WORKSPACE   = 1u << 3;
+constexpr uint32_t DEFER_BAR_ACTIVE      = 1u << 4;
+constexpr uint32_t DEFER_BAR_LAYOUT      = 1u << 5;
+constexpr uint32_t DEFER_FLUSH           = 1u << 6;
+constexpr uint32_t DEFER_SYNC            = 1u << 7;
+
+template<size_t N>
+void copyTruncated(char (&dest)[N], const std::string& src) {
+    size_t len = std::min(src.size(), N - 1);
+    if (len < src.size()) {
+        // Never cut inside a UTF-8 sequence: back up over continuation bytes
+        while (len > 0 && (static_cast<unsigned char>(src[len]) & 0xC0) == 0x80) {
+            --len;
+        }
+    }
+    std::memcpy(dest, src.data(), len);
+    dest[len] = '\0';
+}
+
+// IPC records are zero-initialized plain data, so bytewise equality is exact
+template<typename T>
+bool sameRecords(const std::vector<T>& a, const std::vector<T>& b) {
+    return a.size() == b.size() &&
+           (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+bool sameRecord(const IPCWindowRecord* a, const IPCWindowRecord* b) {
+    if (!a || !b) return a == b;
+    return std::memcmp(a, b, sizeof(IPCWindowRecord)) == 0;
+}
+
+// Reply body for the IPC `config` query
+void writeConfigJSON(JSONWriter& out, const Config& config, uint64_t generation) {
+    out.beginObject()
+       .key("generation").value(generation)
+       .key("focus_follows_mouse").value(config.focus_follows_mouse)
+       .key("monitor_focus_follows_mouse").value(config.monitor_focus_follows_mouse);
+    
+    out.key("borders").beginObject()
+       .key("focused_color").value(config.borders.focused_color)
+       .key("unfocused_color").value(config.borders.unfocused_color)
+       .key("urgent_color").value(config.borders.urgent_color)
+       .key("width").value(config.borders.width)
+       .endObject();
+    
+    out.key("gaps").beginObject()
+       .key("inner_gap").value(config.layout_gaps.inner_gap)
+       .key("outer_gap").value(config.layout_gaps.outer_gap)
+       .key("top_gap").value(config.layout_gaps.top_gap)
+       .key("bottom_gap").value(config.layout_gaps.bottom_gap)
+       .key("left_gap").value(config.layout_gaps.left_gap)
+       .key("right_gap").value(config.layout_gaps.right_gap)
+       .endObject();
+    
+    out.key("workspaces").beginObject()
+       .key("infinite").value(config.workspaces.infinite)
+       .key("max_workspaces").value(config.workspaces.max_workspaces)
+       .key("dynamic_creation").value(config.workspaces.dynamic_creation)
+       .key("auto_remove").value(config.workspaces.auto_remove)
+       .key("per_monitor").value(config.workspaces.per_monitor)
+       .endObject();
+    
+    out.key("layout").beginObject()
+       .key("cycle_direction").value(config.layout.cycle_direction)
+       .key("wrap_cycle").value(config.layout.wrap_cycle)
+       .endObject();
+    
+    out.key("status_bar").beginObject()
+       .key("enabled").value(config.status_bar.enabled)
+       .key("height").value(config.status_bar.height)
+       .key("position").value(config.status_bar.position)
+       .key("font_family").value(config.status_bar.font_family)
+       .key("font_size").value(config.status_bar.font_size)
+       .key("shared_state").value(config.status_bar.shared_state)
+       .endObject();
+    
+    out.key("keybinds").beginArray();
+    for (const auto& bind : config.keybinds) {
+        out.beginObject()
+           .key("modifiers").value(bind.modifiers)
+           .key("key").value(bind.key);
+        if (bind.exec_command) {
+            out.key("exec").value(*bind.exec_command);
+        } else {
+            out.key("action").value(bind.action);
+        }
+        out.endObject();
+    }
+    out.endArray();
+    
+    out.key("autostart").beginArray();
+    for (const auto& command : config.autostart.commands) {
+        out.value(command);
+    }
+    out.endArray();
+    out.key("autostart_xdg").value(config.autostart.xdg);
+    
+    out.endObject();
+}
+
+// Split "Line N[, Col M]: message" as reported by the config lexer/parser
+bool parseErrorLocation(const std::string& error, ValidationResult::ErrorLocation& loc) {
+    int consumed = 0;
+    if (std::sscanf(error.c_str(), "Line %d, Col %d: %n", &loc.line, &loc.column, &consumed) == 2 &&
+        consumed > 0) {
+        loc.message = error.substr(consumed);
+        return true;
+    }
+    consumed = 0;
+    if (std::sscanf(error.c_str(), "Line %d: %n", &loc.line, &consumed) == 1 && consumed > 0) {
+        loc.column = 0;
+        loc.message = error.substr(consumed);
+        return true;
+    }
+    return false;
+}
+
+}
+
 bool WindowManager::wm_detected_ = false;
 
 WindowManager::WindowManager() = default;
@@ -96,7 +240,13 @@ bool WindowManager::initialize() {
     layout_engine_->setRenderPipeline(render_pipeline_.get());
     
     layout_config_parser_ = std::make_unique<LayoutConfigParser>(layout_engine_.get());
+    if (std::filesystem::exists(LayoutConfigParser::getDefaultLayoutPath())) {
+        // Workspace layout rules, resolved by LayoutEngine as workspaces are created
+        layout_config_parser_->load();
+        layout_engine_->setWorkspaceLayouts(&layout_config_parser_->getConfig().workspace_layouts);
+    }
     keybind_manager_ = std::make_unique<KeybindManager>();
+    window_rule_matcher_ = std::make_unique<WindowRuleMatcher>();
     monitor_manager_ = std::make_unique<MonitorManager>();
     
     
@@ -105,6 +255,7 @@ bool WindowManager::initialize() {
     if (!monitor_manager_->initialize(display_.get())) {
         std::cerr << "Failed to initialize MonitorManager - running without multi-monitor support" << std::endl;
     }
+    updateScreenGeometry();
     
     
     auto config_path = ConfigParser::getDefaultConfigPath();
@@ -144,33 +295,34 @@ bool WindowManager::initialize() {
         keybind_manager_->grabKeys(display_.get(), root_);
         
         
+        // Launched from run() once the first frame is out; see StartupApps
+        startup_apps_ = std::make_unique<StartupApps>();
+        startup_apps_->setLauncher([this](const std::string& cmd, int workspace) {
+            std::cerr << "[AUTOSTART] Executing: " << cmd << std::endl;
+            
+            // Autostart output stays on the WM's terminal for debugging
+            SpawnOptions options;
+            options.null_stdio = false;
+            pid_t pid = execCommand(cmd, options, workspace);
+            if (pid == -1) {
+                int err = errno;
+                std::cerr << "[AUTOSTART]   ERROR: spawn failed with errno " << err << ": " << strerror(err) << std::endl;
+            }
+            return pid;
+        });
+        
         if (!config.autostart.commands.empty()) {
             std::cerr << "[AUTOSTART] Found " << config.autostart.commands.size() << " commands to execute" << std::endl;
             for (const auto& cmd : config.autostart.commands) {
-                std::cerr << "[AUTOSTART] Executing: " << cmd << std::endl;
-                
-                int result = fork();
-                if (result == 0) {
-                    
-                    
-                    dup2(STDOUT_FILENO, STDERR_FILENO);
-                    
-                    
-                    execlp("/bin/sh", "sh", "-c", cmd.c_str(), (char*)nullptr);
-                    
-                    
-                    int err = errno;
-                    std::cerr << "[AUTOSTART]   ERROR: execlp failed with errno " << err << ": " << strerror(err) << std::endl;
-                    _exit(1);
-                } else if (result > 0) {
-                    
-                } else {
-                    std::cerr << "[AUTOSTART]   ERROR: fork() failed for: " << cmd << std::endl;
-                }
+                startup_apps_->addApp(cmd);
             }
         } else {
             std::cerr << "[AUTOSTART] No commands configured" << std::endl;
         }
+        if (config.autostart.xdg) {
+            startup_apps_->loadXDGAutostart();
+        }
+        startup_apps_->scheduleAll();
         
         
         setupConfigWatcher();
@@ -195,9 +347,6 @@ bool WindowManager::initialize() {
     scanExistingWindows();
     
     
-    updateEWMHClientList();
-    
-    
     updateExternalBarLayoutMode();
     
     return true;
@@ -251,6 +400,13 @@ void WindowManager::setupScratchpadManager() {
 
 void WindowManager::setupIPCServer() {
     ipc_server_ = std::make_unique<IPCServer>(display_.get(), root_);
+    ipc_server_->acceptTransactions(true);
+    
+    // Runs on the reactor thread: read the published snapshot, not config_parser_ state
+    ipc_server_->setConfigWriter([parser = config_parser_.get()](JSONWriter& out) {
+        uint64_t generation = parser->getGeneration();
+        writeConfigJSON(out, *parser->snapshot(), generation);
+    });
     ipc_server_->start();
 }
 
@@ -264,6 +420,10 @@ void WindowManager::scanExistingWindows() {
         return;
     }
     
+    if (ewmh_manager_) {
+        ewmh_manager_->setStackingOrder(top_level_windows, num_windows);
+    }
+    
     for (unsigned int i = 0; i < num_windows; ++i) {
         XWindowAttributes attrs;
         if (XGetWindowAttributes(display_.get(), top_level_windows[i], &attrs) &&
@@ -319,6 +479,9 @@ void WindowManager::scanExistingWindows() {
             }
             
             clients_[top_level_windows[i]] = std::move(managed);
+            if (ewmh_manager_) {
+                ewmh_manager_->addClient(top_level_windows[i]);
+            }
             
             
             if (render_pipeline_) {
@@ -364,9 +527,22 @@ void WindowManager::run() {
         toaster_->update();
         
         
+        if (reload_pending_.load(std::memory_order_acquire)) {
+            processPendingReload();
+        }
+        
+        
+        if (ipc_server_ && ipc_server_->hasTransactions()) {
+            processIPCTransactions();
+        }
+        
+        
         if (XPending(display_.get()) > 0) {
             XNextEvent(display_.get(), &event);
             
+            if (ewmh_manager_) {
+                ewmh_manager_->handleStackingEvent(event);
+            }
             
             if (event.xany.window == toaster_->getWindow()) {
                 continue;
@@ -381,10 +557,22 @@ void WindowManager::run() {
                     handleConfigureRequest(event.xconfigurerequest);
                     break;
                     
+                case ConfigureNotify:
+                    handleConfigureNotify(event.xconfigure);
+                    break;
+                    
                 case KeyPress:
                     handleKeyPress(event.xkey);
                     break;
                     
+                case KeyRelease:
+                    handleKeyRelease(event.xkey);
+                    break;
+                    
+                case MappingNotify:
+                    handleMappingNotify(event.xmapping);
+                    break;
+                    
                 case ButtonPress:
                     handleButtonPress(event.xbutton);
                     break;
@@ -467,17 +655,40 @@ void WindowManager::run() {
                         }
                     }
                     break;
+                    
+                default:
+                    if (monitor_manager_ && monitor_manager_->handleEvent(event)) {
+                        updateScreenGeometry();
+                        applyLayout();
+                        publishMonitorEvent();
+                    }
+                    break;
+            }
+            
+            // Anything an event handler touched is visible to IPC queries
+            // once per event rather than once per property change.
+            if (ipc_state_dirty_) {
+                publishIPCState();
             }
         } else {
             
             usleep(1000); 
         }
         
-        
-        render_pipeline_->endFrame();
+        // Property writes from this iteration go out once; XPending flushes them
+        if (ewmh_manager_) {
+            ewmh_manager_->flush();
+        }
         
         
+        render_pipeline_->endFrame();
         performance_tuner_->endFrame(frame_start);
+        
+        // Autostart launches start after the first frame, never before it,
+        // and stay out of the frame time the tuner measures
+        if (startup_apps_ && startup_apps_->hasPending()) {
+            startup_apps_->poll();
+        }
     }
 }
 
@@ -499,10 +710,8 @@ void WindowManager::manageWindow(Window window) {
             win_type == ewmh::WindowType::Desktop) {
             
             
-            if (win_type == ewmh::WindowType::Dock) {
-                ewmh_manager_->registerDockWindow(window);
-                
-                
+            if (win_type == ewmh::WindowType::Dock &&
+                ewmh_manager_->registerDockWindow(window)) {
                 applyLayout();
             }
             
@@ -541,14 +750,42 @@ void WindowManager::manageWindow(Window window) {
     }
     
     auto managed = std::make_unique<ManagedWindow>(window, display_.get());
-    managed->setWorkspace(current_workspace_);
+    managed->refreshProperties();
+    
+    
+    bytecode::WindowProperties properties{managed->getCachedClass(), managed->getCachedInstance(),
+                                          managed->getCachedTitle(), current_workspace_ + 1};
+    WindowRuleDecision decision = window_rule_matcher_->match(properties);
+    
+    int workspace = current_workspace_;
+    if (decision.workspace &&
+        (infinite_workspaces_ || *decision.workspace <= max_workspaces_)) {
+        workspace = *decision.workspace - 1;
+    } else if (!launch_origins_.empty() && ewmh_manager_) {
+        // Rules win; otherwise a window we launched opens where it was launched
+        auto origin = launch_origins_.find(ewmh_manager_->getWindowPID(window));
+        if (origin != launch_origins_.end()) {
+            if (std::chrono::steady_clock::now() - origin->second.when <= LAUNCH_ORIGIN_TTL) {
+                workspace = origin->second.workspace;
+            }
+            launch_origins_.erase(origin);
+        }
+    }
+    managed->setWorkspace(workspace);
     
     
     const auto& rules = config_parser_->getConfig().window_rules;
-    if (rules.opacity) {
+    if (decision.opacity) {
+        managed->setOpacity(*decision.opacity);
+    } else if (rules.opacity) {
         managed->setOpacity(*rules.opacity);
     }
     
+    if (decision.border_width) {
+        layout_engine_->setWindowBorderWidth(window, *decision.border_width);
+        XSetWindowBorderWidth(display_.get(), window, *decision.border_width);
+    }
+    
     
     bool should_float = false;
     if (ewmh_manager_) {
@@ -562,16 +799,21 @@ void WindowManager::manageWindow(Window window) {
         }
         
         
-        ewmh_manager_->setWindowDesktop(window, current_workspace_);
+        ewmh_manager_->setWindowDesktop(window, workspace);
         ewmh_manager_->setWindowPID(window, getpid());
     }
     
+    if (decision.floating) {
+        should_float = *decision.floating;
+        managed->setFloating(should_float);
+    }
+    
     
     XGrabButton(display_.get(), AnyButton, AnyModifier, window,
                 False, ButtonPressMask, GrabModeSync, GrabModeAsync, None, None);
     
     
-    XSelectInput(display_.get(), window, EnterWindowMask | LeaveWindowMask | FocusChangeMask);
+    XSelectInput(display_.get(), window, EnterWindowMask | LeaveWindowMask | FocusChangeMask | PropertyChangeMask);
 
     
     if (!should_float) {
@@ -585,8 +827,13 @@ void WindowManager::manageWindow(Window window) {
             }
         }
         
-        if (!should_float) {
+        if (!should_float && workspace == current_workspace_) {
             layout_engine_->addWindow(window);
+        } else if (!should_float) {
+            
+            layout_engine_->setCurrentWorkspace(workspace);
+            layout_engine_->addWindow(window);
+            layout_engine_->setCurrentWorkspace(current_workspace_);
         } else {
             
             
@@ -615,6 +862,25 @@ void WindowManager::manageWindow(Window window) {
     }
     
     
+    if (workspace != current_workspace_) {
+        
+        if (workspace >= static_cast<int>(workspace_last_focus_.size())) {
+            workspace_last_focus_.resize(workspace + 10, None);
+        }
+        workspace_last_focus_[workspace] = window;
+        if (workspace > highest_used_workspace_) {
+            highest_used_workspace_ = workspace;
+        }
+        
+        managed->setHidden(true);
+        clients_.emplace(window, std::move(managed));
+        if (ewmh_manager_) {
+            ewmh_manager_->addClient(window);
+        }
+        publishWindowEvent("new", window, workspace);
+        return;
+    }
+    
     XMapWindow(display_.get(), window);
     
     
@@ -622,6 +888,9 @@ void WindowManager::manageWindow(Window window) {
     
     
     clients_.emplace(window, std::move(managed));
+    if (ewmh_manager_) {
+        ewmh_manager_->addClient(window);
+    }
     
     
     if (render_pipeline_) {
@@ -658,10 +927,9 @@ void WindowManager::manageWindow(Window window) {
     layout_engine_->updateBorderColors();
     
     
-    updateEWMHClientList();
-    
-    
     updateEWMHActiveWindow(window);
+    
+    publishWindowEvent("new", window, current_workspace_);
 }
 
 void WindowManager::handleConfigureRequest(const XConfigureRequestEvent& event) {
@@ -711,6 +979,17 @@ void WindowManager::handleKeyPress(const XKeyEvent& event) {
     keybind_manager_->handleKeyPress(event, this);
 }
 
+void WindowManager::handleKeyRelease(const XKeyEvent& event) {
+    keybind_manager_->handleKeyRelease(event);
+}
+
+void WindowManager::handleMappingNotify(XMappingEvent& event) {
+    XRefreshKeyboardMapping(&event);
+    if (event.request == MappingKeyboard || event.request == MappingModifier) {
+        keybind_manager_->refreshKeymap(display_.get(), root_);
+    }
+}
+
 void WindowManager::handleButtonPress(const XButtonEvent& event) {
     
     
@@ -1340,11 +1619,15 @@ void WindowManager::handleDestroyNotify(const XDestroyWindowEvent& event) {
 void WindowManager::unmanageWindow(Window window) {
     auto it = clients_.find(window);
     if (it == clients_.end()) {
+        if (ewmh_manager_ && ewmh_manager_->unregisterDockWindow(window)) {
+            applyLayout();
+        }
         return;
     }
     
     
     pending_unmaps_.erase(window);
+    layout_engine_->clearWindowBorderWidth(window);
     
     int ws = it->second->getWorkspace();
     
@@ -1357,6 +1640,12 @@ void WindowManager::unmanageWindow(Window window) {
     }
     
     clients_.erase(it);
+    if (ewmh_manager_) {
+        ewmh_manager_->removeClient(window);
+        ewmh_manager_->forgetWindow(window);
+    }
+    
+    publishWindowEvent("close", window, ws);
     
     
     if (next_focus != None) {
@@ -1372,9 +1661,6 @@ void WindowManager::unmanageWindow(Window window) {
     
     applyLayout();
     layout_engine_->updateBorderColors();
-    
-    
-    updateEWMHClientList();
 }
 
 void WindowManager::handleUnmapNotify(const XUnmapEvent& event) {
@@ -1467,6 +1753,8 @@ void WindowManager::handleEnterNotify(const XCrossingEvent& event) {
         
         workspace_last_focus_[current_workspace_] = event.window;
         
+        publishFocusEvent(event.window);
+        
         
         XFlush(display_.get());
     }
@@ -1501,6 +1789,7 @@ void WindowManager::handleFocusIn(const XFocusChangeEvent& event) {
             
             
             applyLayout();
+            publishWorkspaceEvent();
             
             
             XFlush(display_.get());
@@ -1510,43 +1799,85 @@ void WindowManager::handleFocusIn(const XFocusChangeEvent& event) {
         layout_engine_->focusWindow(event.window);
         layout_engine_->updateBorderColors();
         workspace_last_focus_[current_workspace_] = event.window;
+        publishFocusEvent(event.window);
     }
 }
 
 void WindowManager::handlePropertyNotify(const XPropertyEvent& event) {
     auto it = clients_.find(event.window);
-    if (it != clients_.end()) {
-        
+    if (it == clients_.end()) {
+        if (ewmh_manager_ && ewmh_manager_->handleDockPropertyNotify(event)) {
+            applyLayout();
+        }
+        return;
     }
-}
-
-void WindowManager::applyLayout() {
     
-    int screen_width = DisplayWidth(display_.get(), screen_);
-    int screen_height = DisplayHeight(display_.get(), screen_);
+    static Atom net_wm_name = XInternAtom(display_.get(), "_NET_WM_NAME", False);
+    if (event.atom != XA_WM_NAME && event.atom != net_wm_name) {
+        return;
+    }
     
+    it->second->refreshProperties();
+    ipc_state_dirty_ = true;
     
-    unsigned long left_strut = 0, right_strut = 0, top_strut = 0, bottom_strut = 0;
+    if (ipc_server_ && ipc_server_->hasSubscribers(IPCEventTopic::Title)) {
+        ipc_json_.clear();
+        ipc_json_.beginObject()
+                 .key("window").value(event.window)
+                 .key("title").value(it->second->getCachedTitle())
+                 .endObject();
+        ipc_server_->publish(IPCEventTopic::Title, ipc_json_.view(), event.window);
+    }
     
-    if (ewmh_manager_) {
-        auto struts = ewmh_manager_->getCombinedStruts(screen_width, screen_height);
-        left_strut = struts.left;
-        right_strut = struts.right;
-        top_strut = struts.top;
-        bottom_strut = struts.bottom;
-        
-        
-        ewmh_manager_->updateWorkarea(screen_width, screen_height,
-                                      left_strut, right_strut, top_strut, bottom_strut);
+    if (event.window == layout_engine_->getFocusedWindow()) {
+        updateExternalBarActiveWindow();
+    }
+}
+
+void WindowManager::handleConfigureNotify(const XConfigureEvent& event) {
+    if (ManagedWindow* managed = findClient(event.window)) {
+        managed->cacheGeometry(event.x, event.y, event.width, event.height);
+        ipc_state_dirty_ = true;
+    }
+}
+
+void WindowManager::updateScreenGeometry() {
+    if (!ewmh_manager_) return;
+    
+    std::vector<Rect> monitors;
+    if (monitor_manager_) {
+        for (const auto& monitor : monitor_manager_->getMonitors()) {
+            monitors.push_back(monitor.getBounds());
+        }
     }
+    ewmh_manager_->setScreenGeometry(DisplayWidth(display_.get(), screen_),
+                                     DisplayHeight(display_.get(), screen_), monitors);
+}
+
+void WindowManager::applyLayout() {
+    ipc_state_dirty_ = true;
+    if (deferUpdate(DEFER_LAYOUT)) return;
     
+    // Struts are resolved ahead of time; a workspace pinned to a monitor
+    // lays out in that monitor's usable area, otherwise across the screen.
+    Rect screen_bounds{0, 0,
+                       static_cast<unsigned int>(DisplayWidth(display_.get(), screen_)),
+                       static_cast<unsigned int>(DisplayHeight(display_.get(), screen_))};
     
-    Rect screen_bounds{
-        static_cast<int>(left_strut), 
-        static_cast<int>(top_strut),
-        static_cast<unsigned int>(screen_width - left_strut - right_strut),
-        static_cast<unsigned int>(screen_height - top_strut - bottom_strut)
-    };
+    if (ewmh_manager_) {
+        int monitor = -1;
+        int monitor_id = getWorkspaceMonitor(current_workspace_ + 1);
+        if (monitor_id >= 0 && monitor_manager_) {
+            const auto& monitors = monitor_manager_->getMonitors();
+            for (size_t i = 0; i < monitors.size(); ++i) {
+                if (monitors[i].id == monitor_id) {
+                    monitor = static_cast<int>(i);
+                    break;
+                }
+            }
+        }
+        screen_bounds = ewmh_manager_->getUsableArea(monitor);
+    }
     
     
     
@@ -1578,8 +1909,8 @@ bool WindowManager::loadConfigSafe() {
 void WindowManager::fallbackToDefaultConfig() {
     
     
-    if (!config_parser_->loadFromString(ConfigParser::getEmbeddedConfig())) {
-        std::cerr << "[ERROR] Failed to parse embedded config!" << std::endl;
+    if (!config_parser_->loadEmbeddedConfig()) {
+        std::cerr << "[ERROR] Failed to load embedded config!" << std::endl;
         return;
     }
     
@@ -1622,8 +1953,62 @@ void WindowManager::fallbackToDefaultConfig() {
 void WindowManager::applyConfigToLayout() {
     const auto& config = config_parser_->getConfig();
     
+    applyFocusConfig(config);
+    applyWorkspaceConfig(config);
+    applyWindowConfig(config);
+    applyStatusBarConfig(config);
+    applyGapConfig(config);
+    applyBorderConfig(config);
+    applyWindowRules(config);
+}
+
+void WindowManager::applyConfigChanges(const Config& previous) {
+    const auto& config = config_parser_->getConfig();
+    bool relayout = false;
+    
+    if (config.focus_follows_mouse != previous.focus_follows_mouse ||
+        config.monitor_focus_follows_mouse != previous.monitor_focus_follows_mouse) {
+        applyFocusConfig(config);
+    }
+    
+    if (config.workspaces != previous.workspaces) {
+        applyWorkspaceConfig(config);
+        relayout = true;
+    }
+    
+    if (config.windows != previous.windows) {
+        applyWindowConfig(config);
+        relayout = true;
+    }
+    
+    if (config.status_bar.shared_state != previous.status_bar.shared_state) {
+        applyStatusBarConfig(config);
+    }
+    
+    if (config.layout_gaps != previous.layout_gaps) {
+        applyGapConfig(config);
+        relayout = true;
+    }
+    
+    if (config.borders != previous.borders) {
+        applyBorderConfig(config);
+        layout_engine_->updateBorderColors();
+    }
     
+    if (config.keybinds != previous.keybinds) {
+        applyKeybinds(config);
+    }
     
+    if (config.per_window_rules != previous.per_window_rules) {
+        applyWindowRules(config);
+    }
+    
+    if (relayout) {
+        applyLayout();
+    }
+}
+
+void WindowManager::applyFocusConfig(const Config& config) {
     focus_follows_mouse_ = config.focus_follows_mouse;
     
     
@@ -1644,8 +2029,9 @@ void WindowManager::applyConfigToLayout() {
             }
         }
     }
+}
 
-    
+void WindowManager::applyWorkspaceConfig(const Config& config) {
     infinite_workspaces_ = config.workspaces.infinite;
     max_workspaces_ = config.workspaces.max_workspaces;
     dynamic_workspace_creation_ = config.workspaces.dynamic_creation;
@@ -1658,12 +2044,6 @@ void WindowManager::applyConfigToLayout() {
     workspace_to_monitor_ = config.workspaces.workspace_to_monitor;
     
     
-    if (!workspace_to_monitor_.empty()) {
-        for ([[maybe_unused]] const auto& [ws, mon] : workspace_to_monitor_) {
-        }
-    }
-    
-    
     if (per_monitor_workspaces_ && monitor_manager_) {
         size_t monitor_count = monitor_manager_->getMonitorCount();
         per_monitor_last_focus_.resize(monitor_count);
@@ -1676,19 +2056,28 @@ void WindowManager::applyConfigToLayout() {
     if (!infinite_workspaces_ && workspace_last_focus_.size() < static_cast<size_t>(max_workspaces_)) {
         workspace_last_focus_.resize(max_workspaces_, None);
     }
+}
 
-    
-    
-    
+void WindowManager::applyWindowConfig(const Config& config) {
     auto_resize_non_docks_ = config.windows.auto_resize_non_docks;
     floating_resize_enabled_ = config.windows.floating_resize_enabled;
     floating_resize_edge_size_ = config.windows.floating_resize_edge_size;
-    
+}
 
-    
-    
-    
-    
+void WindowManager::applyStatusBarConfig(const Config& config) {
+    if (config.status_bar.shared_state && !shared_state_) {
+        auto region = std::make_unique<SharedStateRegion>();
+        if (region->open()) {
+            std::cout << "Bar state shared at /dev/shm" << region->getName() << std::endl;
+            shared_state_ = std::move(region);
+            ipc_state_dirty_ = true;
+        }
+    } else if (!config.status_bar.shared_state && shared_state_) {
+        shared_state_.reset();
+    }
+}
+
+void WindowManager::applyGapConfig(const Config& config) {
     int top_gap = config.layout_gaps.top_gap == 0 ? -1 : config.layout_gaps.top_gap;
     int bottom_gap = config.layout_gaps.bottom_gap == 0 ? -1 : config.layout_gaps.bottom_gap;
     int left_gap = config.layout_gaps.left_gap == 0 ? -1 : config.layout_gaps.left_gap;
@@ -1703,9 +2092,9 @@ void WindowManager::applyConfigToLayout() {
         right_gap
     );
     layout_engine_->setBorderWidth(2);  
-    
-    
-    
+}
+
+void WindowManager::applyBorderConfig(const Config& config) {
     unsigned long focused_color = 0x89B4FA;    
     unsigned long unfocused_color = 0x45475A;  
     
@@ -1738,6 +2127,29 @@ void WindowManager::applyConfigToLayout() {
     layout_engine_->setBorderColors(focused_color, unfocused_color);
 }
 
+void WindowManager::applyKeybinds(const Config& config) {
+    std::vector<std::pair<std::string, std::string>> binds;
+    binds.reserve(config.keybinds.size());
+    for (const auto& bind : config.keybinds) {
+        std::string keybind_str = bind.modifiers.empty() ? bind.key : bind.modifiers + ", " + bind.key;
+        std::string action = bind.exec_command.has_value() ? 
+            "exec: " + *bind.exec_command : bind.action;
+        binds.emplace_back(std::move(keybind_str), std::move(action));
+    }
+    
+    auto stats = keybind_manager_->syncKeybinds(binds, display_.get(), root_);
+    std::cerr << "[KEYBIND] Reload: " << stats.added << " added, " << stats.removed
+              << " removed, " << stats.rebound << " rebound" << std::endl;
+}
+
+void WindowManager::applyWindowRules(const Config& config) {
+    window_rule_matcher_->compile(config.per_window_rules);
+    if (!config.per_window_rules.empty()) {
+        std::cerr << "[WindowManager] Compiled " << window_rule_matcher_->size()
+                  << " window rules" << std::endl;
+    }
+}
+
 void WindowManager::setupConfigWatcher() {
     config_watcher_ = std::make_unique<ConfigWatcher>();
     
@@ -1746,113 +2158,93 @@ void WindowManager::setupConfigWatcher() {
     auto config_dir = config_path.parent_path();
     
     
-    config_watcher_->setValidationCallback([this](const std::filesystem::path& path) {
+    config_watcher_->setValidationCallback([this](const std::filesystem::path&) {
         ValidationResult result;
         
-        
-        std::ifstream file(path);
-        if (!file.is_open()) {
-            result.success = false;
-            result.errors.push_back("Cannot open file");
-            return result;
+        // Full lex/parse/interpret on the watcher thread into a private
+        // parser; the live config is untouched until the main loop swaps
+        // the result in.
+        auto main_path = custom_config_path_.value_or(ConfigParser::getDefaultConfigPath());
+        ConfigParser parser(nullptr);
+        bool loaded = false;
+        try {
+            loaded = parser.load(main_path);
+        } catch (const std::exception& e) {
+            result.errors.push_back(std::string("Config loading exception: ") + e.what());
         }
         
-        std::string line;
-        int line_num = 0;
-        int brace_count = 0;
-        int bracket_count = 0;
-        
-        while (std::getline(file, line)) {
-            line_num++;
-            for (char c : line) {
-                if (c == '{') brace_count++;
-                else if (c == '}') brace_count--;
-                else if (c == '[') bracket_count++;
-                else if (c == ']') bracket_count--;
+        std::vector<std::string> source_lines;
+        if (!parser.getErrors().empty()) {
+            std::ifstream file(main_path);
+            for (std::string line; std::getline(file, line); ) {
+                source_lines.push_back(std::move(line));
             }
         }
         
-        if (brace_count != 0) {
-            result.success = false;
-            ValidationResult::ErrorLocation loc;
-            loc.line = line_num;
-            loc.message = "Unmatched braces";
-            result.error_locations.push_back(loc);
-            return result;
-        }
-        if (bracket_count != 0) {
-            result.success = false;
+        for (const auto& error : parser.getErrors()) {
             ValidationResult::ErrorLocation loc;
-            loc.line = line_num;
-            loc.message = "Unmatched brackets";
-            result.error_locations.push_back(loc);
-            return result;
+            if (!loaded && parseErrorLocation(error, loc)) {
+                if (loc.line > 0 && static_cast<size_t>(loc.line) <= source_lines.size()) {
+                    loc.context = source_lines[loc.line - 1];
+                }
+                result.error_locations.push_back(std::move(loc));
+            } else if (!loaded) {
+                result.errors.push_back(error);
+            } else {
+                result.warnings.push_back(error);
+            }
         }
         
-        result.success = true;
+        if (loaded) {
+            result.config = parser.snapshot();
+        } else if (result.errors.empty() && result.error_locations.empty()) {
+            result.errors.push_back("Failed to load " + main_path.string());
+        }
+        result.success = loaded;
         return result;
     });
     
     
-    config_watcher_->setApplyCallback([this](const std::filesystem::path& path) {
-        
-        
-        if (loadConfigSafe()) {
-            
-            toaster_->clearConfigErrors();
-            
-            applyConfigToLayout();
-            applyLayout();
-            layout_engine_->updateBorderColors();
-            
-            
-            keybind_manager_->clearKeybinds();
-            const auto& config = config_parser_->getConfig();
-            for (const auto& bind : config.keybinds) {
-                std::string keybind_str;
-                if (!bind.modifiers.empty()) {
-                    keybind_str = bind.modifiers + ", " + bind.key;
-                } else {
-                    keybind_str = bind.key;
-                }
-                
-                std::string action = bind.exec_command.has_value() ? 
-                    "exec: " + *bind.exec_command : bind.action;
-                
-                keybind_manager_->registerKeybind(keybind_str, action);
-            }
-            keybind_manager_->grabKeys(display_.get(), root_);
-            
-            toaster_->success("Config reloaded");
-            return true;
+    config_watcher_->setApplyCallback([this](const std::filesystem::path&,
+                                             std::shared_ptr<const Config> config) {
+        if (!config) {
+            return false;
         }
         
-        toaster_->error("Config reload failed");
-        return false;
+        std::lock_guard<std::mutex> lock(reload_mutex_);
+        pending_config_ = std::move(config);
+        reload_pending_.store(true, std::memory_order_release);
+        return true;
     });
     
     
     config_watcher_->setErrorCallback([this](const ValidationResult& result) {
-        
-        toaster_->clearConfigErrors();
-        
+        std::lock_guard<std::mutex> lock(reload_mutex_);
+        pending_config_errors_.clear();
         for (const auto& err : result.errors) {
-            toaster_->configError("Config error: " + err);
+            pending_config_errors_.push_back("Config error: " + err);
         }
+        // A toast is one line, so the offending source line gets its own
         for (const auto& loc : result.error_locations) {
-            toaster_->configError("Line " + std::to_string(loc.line) + ": " + loc.message);
+            std::string where = "Config error: Line " + std::to_string(loc.line);
+            if (loc.column > 0) {
+                where += ", Col " + std::to_string(loc.column);
+            }
+            pending_config_errors_.push_back(where + ": " + loc.message);
+            
+            size_t start = loc.context.find_first_not_of(" \t");
+            if (start != std::string::npos) {
+                pending_config_errors_.push_back("  > " + loc.context.substr(start));
+            }
         }
+        reload_pending_.store(true, std::memory_order_release);
     });
     
     
     config_watcher_->setNotifyCallback([this](const std::string& message, const std::string& level) {
-        if (level == "info") {
-            toaster_->info(message);
-        } else if (level == "success") {
-            toaster_->success(message);
-        } else if (level == "error") {
-            toaster_->error(message);
-        }
+        std::lock_guard<std::mutex> lock(reload_mutex_);
+        pending_config_notices_.emplace_back(message, level);
+        reload_pending_.store(true, std::memory_order_release);
     });
     
     
@@ -1870,16 +2262,60 @@ void WindowManager::setupConfigWatcher() {
 void WindowManager::reloadConfig() {
     toaster_->info("Reloading configuration...");
     
+    // Parse on the watcher thread; the result arrives via processPendingReload()
+    if (config_watcher_ && config_watcher_->isRunning()) {
+        config_watcher_->requestReload(custom_config_path_.value_or(ConfigParser::getDefaultConfigPath()));
+        return;
+    }
+    
+    auto previous = config_parser_->snapshot();
+    
     if (loadConfigSafe()) {
         toaster_->success("Configuration reloaded");
-        applyConfigToLayout();
-        applyLayout();
-        layout_engine_->updateBorderColors();
+        applyConfigChanges(*previous);
     } else {
         toaster_->error("Configuration reload failed");
     }
 }
 
+void WindowManager::processPendingReload() {
+    std::shared_ptr<const Config> config;
+    std::vector<std::string> errors;
+    std::vector<std::pair<std::string, std::string>> notices;
+    {
+        std::lock_guard<std::mutex> lock(reload_mutex_);
+        reload_pending_.store(false, std::memory_order_relaxed);
+        config = std::move(pending_config_);
+        errors.swap(pending_config_errors_);
+        notices.swap(pending_config_notices_);
+    }
+    
+    if (config) {
+        toaster_->clearConfigErrors();
+        
+        auto previous = config_parser_->snapshot();
+        config_parser_->setConfig(std::move(config));
+        applyConfigChanges(*previous);
+    }
+    
+    if (!errors.empty()) {
+        toaster_->clearConfigErrors();
+        for (const auto& err : errors) {
+            toaster_->configError(err);
+        }
+    }
+    
+    for (const auto& [message, level] : notices) {
+        if (level == "info") {
+            toaster_->info(message);
+        } else if (level == "success") {
+            toaster_->success(message);
+        } else if (level == "error") {
+            toaster_->error(message);
+        }
+    }
+}
+
 
 
 
@@ -1946,7 +2382,7 @@ void WindowManager::switchWorkspace(int workspace) {
     updateExternalBarWorkspace();
     
     
-    XSync(display_.get(), False);
+    flushDisplay(true);
 }
 
 void WindowManager::moveWindowToWorkspace(int workspace, bool follow) {
@@ -2026,6 +2462,8 @@ void WindowManager::moveWindowToWorkspace(int workspace, bool follow) {
     
     workspace_last_focus_[target_ws] = focused;
     
+    publishWindowEvent("move", focused, target_ws);
+    
     
     applyLayout();
     layout_engine_->updateBorderColors();
@@ -2045,7 +2483,7 @@ void WindowManager::hideWorkspaceWindows(int workspace) {
         }
     }
 
-    XFlush(display_.get());
+    flushDisplay();
 }
 
 void WindowManager::showWorkspaceWindows(int workspace) {
@@ -2072,7 +2510,7 @@ void WindowManager::showWorkspaceWindows(int workspace) {
     
     
     
-    XSync(display_.get(), False);
+    flushDisplay(true);
 }
 
 void WindowManager::updateFocusAfterSwitch() {
@@ -2105,7 +2543,7 @@ void WindowManager::updateAllBorders() {
             XSetWindowBorder(display_.get(), window, color);
         }
     }
-    XFlush(display_.get());
+    flushDisplay();
 }
 
 Window WindowManager::findWindowToFocus(int workspace) {
@@ -2253,6 +2691,7 @@ void WindowManager::focusWindow(Window window) {
         
         
         updateExternalBarActiveWindow();
+        publishFocusEvent(window);
     }
 }
 
@@ -2260,8 +2699,10 @@ void WindowManager::focusWindow(Window window) {
 
 
 
-void WindowManager::swapFocusedWindow(const std::string& direction) {
-    layout_engine_->swapFocused(direction);
+void WindowManager::swapFocusedWindow(const std::string& direction, int count) {
+    for (int i = 0; i < count; ++i) {
+        layout_engine_->swapFocused(direction);
+    }
     applyLayout();
     layout_engine_->updateBorderColors();
 }
@@ -2270,7 +2711,7 @@ void WindowManager::swapFocusedWindow(const std::string& direction) {
 
 
 
-void WindowManager::resizeFocusedWindow(const std::string& direction) {
+void WindowManager::resizeFocusedWindow(const std::string& direction, int count) {
     double delta = 0.0;
     
     if (direction == "left") {
@@ -2284,7 +2725,7 @@ void WindowManager::resizeFocusedWindow(const std::string& direction) {
     }
     
     if (delta != 0.0) {
-        resizeFocusedWindow(delta);
+        resizeFocusedWindow(delta * count);
     }
 }
 
@@ -2382,12 +2823,9 @@ void WindowManager::setFullscreen(Window window, bool fullscreen) {
         XRaiseWindow(display_.get(), window);
         
         
-        Atom wm_state = XInternAtom(display_.get(), "_NET_WM_STATE", False);
-        Atom fullscreen_atom = XInternAtom(display_.get(), "_NET_WM_STATE_FULLSCREEN", False);
-        
-        XChangeProperty(display_.get(), window, wm_state, XA_ATOM, 32,
-                       PropModeReplace, 
-                       reinterpret_cast<unsigned char*>(&fullscreen_atom), 1);
+        if (ewmh_manager_) {
+            ewmh_manager_->setWindowState(window, {ewmh_manager_->getAtoms().NET_WM_STATE_FULLSCREEN});
+        }
         
         toaster_->info("Fullscreen");
     } else {
@@ -2402,14 +2840,15 @@ void WindowManager::setFullscreen(Window window, bool fullscreen) {
         XConfigureWindow(display_.get(), window, CWBorderWidth, &changes);
         
         
-        Atom wm_state = XInternAtom(display_.get(), "_NET_WM_STATE", False);
-        XDeleteProperty(display_.get(), window, wm_state);
+        if (ewmh_manager_) {
+            ewmh_manager_->setWindowState(window, {});
+        }
         
         
         applyLayout();
     }
     
-    XFlush(display_.get());
+    flushDisplay();
 }
 
 
@@ -2583,20 +3022,19 @@ void WindowManager::toggleSplitDirection() {
 
 
 
-void WindowManager::execCommand(const std::string& command) {
-    
-    pid_t pid = fork();
-    if (pid == 0) {
-        
-        setsid();
-        
-        
-        std::string cmd = command;
-        execl("/bin/sh", "/bin/sh", "-c", cmd.c_str(), nullptr);
-        
-        
-        _exit(1);
+pid_t WindowManager::execCommand(const std::string& command, const SpawnOptions& options,
+                                 int workspace) {
+    pid_t pid = Launcher::spawn(command, options);
+    if (pid == -1) {
+        return -1;
     }
+    
+    auto now = std::chrono::steady_clock::now();
+    std::erase_if(launch_origins_, [now](const auto& entry) {
+        return now - entry.second.when > LAUNCH_ORIGIN_TTL;
+    });
+    launch_origins_[pid] = LaunchOrigin{workspace >= 0 ? workspace : current_workspace_, now};
+    return pid;
 }
 
 void WindowManager::killActiveWindow() {
@@ -2674,23 +3112,15 @@ int WindowManager::onWMDetected(Display* display, XErrorEvent* error) {
 
 
 
-void WindowManager::updateEWMHClientList() {
-    if (!ewmh_manager_) return;
-    
-    std::vector<Window> windows;
-    windows.reserve(clients_.size());
-    
-    for (const auto& pair : clients_) {
-        windows.push_back(pair.first);
-    }
-    
-    ewmh_manager_->setClientList(windows);
-}
-
 void WindowManager::updateEWMHActiveWindow(Window window) {
     if (!ewmh_manager_) return;
+    if (deferUpdate(DEFER_ACTIVE_WINDOW)) {
+        deferred_active_window_ = window;
+        return;
+    }
     
     ewmh_manager_->setActiveWindow(window);
+    publishFocusEvent(window);
 }
 
 void WindowManager::updateEWMHWorkspaceCount() {
@@ -2704,6 +3134,10 @@ void WindowManager::updateEWMHWorkspaceCount() {
     } else {
         count = max_workspaces_;
     }
+    if (count == ewmh_manager_->getNumberOfDesktops() &&
+        ewmh_manager_->getDesktopNames().size() == static_cast<size_t>(count)) {
+        return;
+    }
     ewmh_manager_->setNumberOfDesktops(count);
     
     
@@ -2717,8 +3151,10 @@ void WindowManager::updateEWMHWorkspaceCount() {
 
 void WindowManager::updateEWMHCurrentWorkspace() {
     if (!ewmh_manager_) return;
+    if (deferUpdate(DEFER_CURRENT_DESKTOP)) return;
     
     ewmh_manager_->setCurrentDesktop(current_workspace_);
+    publishWorkspaceEvent();
 }
 
 void WindowManager::updateEWMHWindowDesktop(Window window, int desktop) {
@@ -2757,6 +3193,7 @@ void WindowManager::updateExternalBarProperties() {
 
 void WindowManager::updateExternalBarWorkspace() {
     if (!ewmh_manager_) return;
+    if (deferUpdate(DEFER_BAR_WORKSPACE)) return;
     
     
     ewmh_manager_->setCurrentWorkspacePB(current_workspace_);
@@ -2787,6 +3224,7 @@ void WindowManager::updateExternalBarWorkspace() {
 
 void WindowManager::updateExternalBarActiveWindow() {
     if (!ewmh_manager_) return;
+    if (deferUpdate(DEFER_BAR_ACTIVE)) return;
     
     Window focused = layout_engine_->getFocusedWindow();
     if (focused == None) {
@@ -2797,48 +3235,31 @@ void WindowManager::updateExternalBarActiveWindow() {
     
     auto it = clients_.find(focused);
     if (it != clients_.end()) {
-        ewmh_manager_->setActiveWindowTitlePB(it->second->getTitle());
-        ewmh_manager_->setActiveWindowClassPB(it->second->getClass());
+        ewmh_manager_->setActiveWindowTitlePB(it->second->getCachedTitle());
+        ewmh_manager_->setActiveWindowClassPB(it->second->getCachedClass());
     }
 }
 
 void WindowManager::updateExternalBarLayoutMode() {
     if (!ewmh_manager_) return;
+    if (deferUpdate(DEFER_BAR_LAYOUT)) return;
     
     
     auto layout_mode = layout_engine_->getCurrentLayoutMode(current_workspace_);
     
-    std::string layout_name;
-    if (layout_mode) {
-        switch (*layout_mode) {
-            case LayoutMode::BSP:
-                layout_name = "BSP";
-                break;
-            case LayoutMode::Monocle:
-                layout_name = "Monocle";
-                break;
-            case LayoutMode::MasterStack:
-                layout_name = "MasterStack";
-                break;
-            case LayoutMode::CenteredMaster:
-                layout_name = "Centered";
-                break;
-            case LayoutMode::DynamicGrid:
-                layout_name = "Grid";
-                break;
-            case LayoutMode::DwindleSpiral:
-                layout_name = "Dwindle";
-                break;
-            case LayoutMode::TabbedStacked:
-                layout_name = "Tabbed";
-                break;
-            default:
-                layout_name = "Unknown";
-                break;
-        }
-    }
+    std::string layout_name = layout_mode ? layoutModeDisplayName(*layout_mode) : "";
     
     ewmh_manager_->setLayoutModePB(layout_name);
+    ipc_state_dirty_ = true;
+    
+    if (ipc_server_ && ipc_server_->hasSubscribers(IPCEventTopic::Layout)) {
+        ipc_json_.clear();
+        ipc_json_.beginObject()
+                 .key("layout").value(layout_name)
+                 .key("workspace").value(current_workspace_ + 1)
+                 .endObject();
+        ipc_server_->publish(IPCEventTopic::Layout, ipc_json_.view());
+    }
     
     
     std::filesystem::create_directories("/tmp/pointblank");
@@ -2849,7 +3270,285 @@ void WindowManager::updateExternalBarLayoutMode() {
     }
 }
 
+void WindowManager::publishWorkspaceEvent() {
+    ipc_state_dirty_ = true;
+    if (current_workspace_ == ipc_last_workspace_) return;
+    ipc_last_workspace_ = current_workspace_;
+    
+    if (!ipc_server_ || !ipc_server_->hasSubscribers(IPCEventTopic::Workspace)) return;
+    
+    ipc_json_.clear();
+    ipc_json_.beginObject()
+             .key("workspace").value(current_workspace_ + 1)
+             .key("monitor").value(current_monitor_)
+             .endObject();
+    ipc_server_->publish(IPCEventTopic::Workspace, ipc_json_.view());
+}
+
+void WindowManager::publishFocusEvent(Window window) {
+    ipc_state_dirty_ = true;
+    if (window == ipc_last_focus_) return;
+    ipc_last_focus_ = window;
+    
+    if (!ipc_server_ || !ipc_server_->hasSubscribers(IPCEventTopic::Focus)) return;
+    
+    const ManagedWindow* managed = findClient(window);
+    
+    ipc_json_.clear();
+    ipc_json_.beginObject()
+             .key("window").value(window)
+             .key("class").value(managed ? std::string_view(managed->getCachedClass()) : "")
+             .key("title").value(managed ? std::string_view(managed->getCachedTitle()) : "")
+             .endObject();
+    ipc_server_->publish(IPCEventTopic::Focus, ipc_json_.view());
+}
+
+void WindowManager::publishWindowEvent(const char* change, Window window, int workspace) {
+    ipc_state_dirty_ = true;
+    if (!ipc_server_ || !ipc_server_->hasSubscribers(IPCEventTopic::Window)) return;
+    
+    ipc_json_.clear();
+    ipc_json_.beginObject()
+             .key("change").value(change)
+             .key("window").value(window)
+             .key("workspace").value(workspace + 1)
+             .endObject();
+    ipc_server_->publish(IPCEventTopic::Window, ipc_json_.view(), window);
+}
+
+void WindowManager::publishMonitorEvent() {
+    ipc_state_dirty_ = true;
+    if (!ipc_server_ || !ipc_server_->hasSubscribers(IPCEventTopic::Monitor)) return;
+    
+    size_t count = monitor_manager_ ? monitor_manager_->getMonitorCount() : 1;
+    ipc_json_.clear();
+    ipc_json_.beginObject().key("monitors").value(count).endObject();
+    ipc_server_->publish(IPCEventTopic::Monitor, ipc_json_.view());
+}
+
+void WindowManager::publishIPCState() {
+    ipc_state_dirty_ = false;
+    if (!ipc_server_ && !shared_state_) return;
+    
+    auto state = std::make_shared<IPCStateSnapshot>();
+    state->focused = layout_engine_->getFocusedWindow();
+    state->current_workspace = current_workspace_;
+    if (auto mode = layout_engine_->getCurrentLayoutMode(current_workspace_)) {
+        state->layout = layoutModeDisplayName(*mode);
+    }
+    
+    int total_workspaces = infinite_workspaces_ ?
+        std::max({highest_used_workspace_ + 1, current_workspace_ + 1, max_workspaces_}) :
+        max_workspaces_;
+    std::vector<uint32_t> counts(total_workspaces, 0);
+    
+    state->windows.reserve(clients_.size());
+    for (const auto& [window, managed] : clients_) {
+        IPCWindowRecord record{};
+        record.window = window;
+        int x, y;
+        unsigned int w, h;
+        managed->getGeometry(x, y, w, h);
+        record.x = x;
+        record.y = y;
+        record.width = w;
+        record.height = h;
+        record.workspace = managed->getWorkspace() + 1;
+        record.flags = (managed->isFloating() ? IPC_WINDOW_FLOATING : 0) |
+                       (managed->isFullscreen() ? IPC_WINDOW_FULLSCREEN : 0) |
+                       (managed->isHidden() ? IPC_WINDOW_HIDDEN : 0) |
+                       (window == state->focused ? IPC_WINDOW_FOCUSED : 0);
+        copyTruncated(record.wm_class, managed->getCachedClass());
+        copyTruncated(record.title, managed->getCachedTitle());
+        state->windows.push_back(record);
+        
+        int ws = managed->getWorkspace();
+        if (ws >= 0 && ws < total_workspaces) {
+            counts[ws]++;
+        }
+    }
+    std::sort(state->windows.begin(), state->windows.end(),
+              [](const IPCWindowRecord& a, const IPCWindowRecord& b) { return a.window < b.window; });
+    
+    state->workspaces.reserve(total_workspaces);
+    for (int ws = 0; ws < total_workspaces; ++ws) {
+        IPCWorkspaceRecord record{};
+        record.workspace = ws + 1;
+        record.window_count = counts[ws];
+        record.monitor = getWorkspaceMonitor(ws + 1);
+        record.flags = (ws == current_workspace_ ? IPC_WORKSPACE_CURRENT : 0) |
+                       (counts[ws] > 0 ? IPC_WORKSPACE_OCCUPIED : 0);
+        auto mode = layout_engine_->getCurrentLayoutMode(ws);
+        copyTruncated(record.layout, mode ? std::string(layoutModeDisplayName(*mode)) : std::string());
+        state->workspaces.push_back(record);
+    }
+    
+    if (monitor_manager_) {
+        for (const auto& monitor : monitor_manager_->getMonitors()) {
+            IPCMonitorRecord record{};
+            record.monitor = monitor.id;
+            record.x = monitor.x;
+            record.y = monitor.y;
+            record.width = monitor.width;
+            record.height = monitor.height;
+            record.flags = monitor.primary ? IPC_MONITOR_PRIMARY : 0;
+            copyTruncated(record.name, monitor.name);
+            state->monitors.push_back(record);
+        }
+    }
+    
+    // A facet keeps its generation until its content actually differs, so
+    // pollers holding the current generation get "unchanged" replies.
+    const IPCStateSnapshot* prev = ipc_last_state_.get();
+    bool changed[IPC_FACET_COUNT] = {
+        !prev || !sameRecords(prev->workspaces, state->workspaces),
+        !prev || !sameRecords(prev->windows, state->windows),
+        !prev || prev->focused != state->focused ||
+            !sameRecord(prev->findWindow(prev->focused), state->findWindow(state->focused)),
+        !prev || prev->layout != state->layout,
+        !prev || !sameRecords(prev->monitors, state->monitors)
+    };
+    
+    bool any_changed = false;
+    for (size_t facet = 0; facet < IPC_FACET_COUNT; ++facet) {
+        state->generations[facet] = changed[facet] ? ++ipc_generation_ : prev->generations[facet];
+        any_changed |= changed[facet];
+    }
+    
+    // The region drops identical updates itself, and a freshly opened one
+    // needs filling even when no facet changed.
+    if (shared_state_) {
+        publishSharedState(*state);
+    }
+    if (!any_changed) {
+        return;
+    }
+    
+    ipc_last_state_ = state;
+    if (ipc_server_) {
+        ipc_server_->publishState(std::move(state));
+    }
+}
+
+void WindowManager::publishSharedState(const IPCStateSnapshot& state) {
+    pb_state_data data{};
+    data.current_workspace = state.current_workspace;
+    data.workspace_count = static_cast<uint32_t>(
+        std::min<size_t>(state.workspaces.size(), PB_STATE_MAX_WORKSPACES));
+    for (uint32_t ws = 0; ws < data.workspace_count; ++ws) {
+        data.window_counts[ws] = state.workspaces[ws].window_count;
+        if (state.workspaces[ws].window_count > 0) {
+            data.occupied |= uint64_t{1} << ws;
+        }
+    }
+    
+    data.active_window = state.focused;
+    copyTruncated(data.layout, state.layout);
+    
+    // The snapshot's records truncate titles harder than bars want
+    if (const ManagedWindow* focused = findClient(state.focused)) {
+        copyTruncated(data.active_class, focused->getCachedClass());
+        copyTruncated(data.active_title, focused->getCachedTitle());
+    }
+    
+    shared_state_->publish(data);
+}
+
+void WindowManager::processIPCTransactions() {
+    while (auto transaction = ipc_server_->takeTransaction()) {
+        beginTransaction();
+        transaction->results.reserve(transaction->commands.size());
+        for (const auto& command : transaction->commands) {
+            transaction->results.push_back(executeIPCCommand(command));
+        }
+        commitTransaction();
+        
+        // Queries answered after the reply must already see the new state
+        if (ipc_state_dirty_) {
+            publishIPCState();
+        }
+        ipc_server_->completeTransaction(std::move(transaction));
+    }
+}
+
+IPCResponse WindowManager::executeIPCCommand(const std::vector<std::string>& args) {
+    if (args.empty() || !keybind_manager_) {
+        return IPCResponse::error("Empty command", IPC_ERROR_INVALID_REQUEST);
+    }
+    
+    std::string action = args[0];
+    if (action == "quit") {
+        action = "exit";
+    } else if (action == "restart") {
+        action = "reload";
+    }
+    for (size_t i = 1; i < args.size(); ++i) {
+        action.append(" ").append(args[i]);
+    }
+    
+    try {
+        if (!keybind_manager_->executeAction(action, this)) {
+            return IPCResponse::error("Unknown command: " + args[0], IPC_ERROR_METHOD_NOT_FOUND);
+        }
+    } catch (const std::exception& e) {
+        return IPCResponse::error(std::string("Error: ") + e.what(), IPC_ERROR_INTERNAL);
+    }
+    return IPCResponse::ok("Command executed");
+}
+
+void WindowManager::beginTransaction() {
+    in_transaction_ = true;
+    deferred_updates_ = 0;
+}
+
+void WindowManager::commitTransaction() {
+    in_transaction_ = false;
+    uint32_t pending = std::exchange(deferred_updates_, 0);
+    
+    if (pending & DEFER_LAYOUT) {
+        applyLayout();
+        layout_engine_->updateBorderColors();
+    }
+    if (pending & DEFER_CURRENT_DESKTOP) {
+        updateEWMHCurrentWorkspace();
+    }
+    if (pending & DEFER_ACTIVE_WINDOW) {
+        updateEWMHActiveWindow(deferred_active_window_);
+    }
+    if (pending & DEFER_BAR_WORKSPACE) {
+        updateExternalBarWorkspace();
+    }
+    if (pending & DEFER_BAR_ACTIVE) {
+        updateExternalBarActiveWindow();
+    }
+    if (pending & DEFER_BAR_LAYOUT) {
+        updateExternalBarLayoutMode();
+    }
+    
+    flushDisplay((pending & DEFER_SYNC) != 0);
+}
+
+bool WindowManager::deferUpdate(uint32_t update) {
+    if (!in_transaction_) {
+        return false;
+    }
+    deferred_updates_ |= update;
+    return true;
+}
 
+void WindowManager::flushDisplay(bool sync) {
+    if (deferUpdate(sync ? DEFER_SYNC : DEFER_FLUSH)) {
+        return;
+    }
+    if (ewmh_manager_) {
+        ewmh_manager_->flush();
+    }
+    if (sync) {
+        XSync(display_.get(), False);
+    } else {
+        XFlush(display_.get());
+    }
+}
 
 
 
@@ -2879,6 +3578,20 @@ std::string ManagedWindow::getClass() const {
     return "";
 }
 
+void ManagedWindow::refreshProperties() {
+    XClassHint class_hint;
+    if (XGetClassHint(display_, window_, &class_hint)) {
+        cached_class_ = class_hint.res_class ? class_hint.res_class : "";
+        cached_instance_ = class_hint.res_name ? class_hint.res_name : "";
+        if (class_hint.res_name) XFree(class_hint.res_name);
+        if (class_hint.res_class) XFree(class_hint.res_class);
+    } else {
+        cached_class_.clear();
+        cached_instance_.clear();
+    }
+    cached_title_ = getTitle();
+}
+
 std::string ManagedWindow::getTitle() const {
     char* name = nullptr;
     XFetchName(display_, window_, &name);
@@ -10,11 +10,55 @@
 #include <X11/Xutil.h>
 #include <cstring>
 #include <algorithm>
+#include <string_view>
 #include <iostream>
 
 namespace pblank {
 namespace ewmh {
 
+namespace {
+
+// A strut reserves a band along one screen edge, optionally limited to a
+// span of the other axis (0/0 means the whole edge). The band shrinks every
+// area it overlaps.
+Rect applyStruts(Rect area, const std::vector<EWMHManager::StrutPartial>& struts,
+                 int screen_width, int screen_height) {
+    int left = area.left(), right = area.right();
+    int top = area.top(), bottom = area.bottom();
+    const int x0 = left, x1 = right, y0 = top, y1 = bottom;
+    
+    auto spans = [](unsigned long start, unsigned long end, int lo, int hi) {
+        if (start == 0 && end == 0) return true;
+        return static_cast<long>(start) < hi && static_cast<long>(end) >= lo;
+    };
+    
+    for (const auto& s : struts) {
+        if (s.left > 0 && spans(s.left_start_y, s.left_end_y, y0, y1) &&
+            static_cast<long>(s.left) > left) {
+            left = static_cast<int>(s.left);
+        }
+        if (s.right > 0 && spans(s.right_start_y, s.right_end_y, y0, y1) &&
+            screen_width - static_cast<long>(s.right) < right) {
+            right = screen_width - static_cast<int>(s.right);
+        }
+        if (s.top > 0 && spans(s.top_start_x, s.top_end_x, x0, x1) &&
+            static_cast<long>(s.top) > top) {
+            top = static_cast<int>(s.top);
+        }
+        if (s.bottom > 0 && spans(s.bottom_start_x, s.bottom_end_x, x0, x1) &&
+            screen_height - static_cast<long>(s.bottom) < bottom) {
+            bottom = screen_height - static_cast<int>(s.bottom);
+        }
+    }
+    
+    right = std::max(right, left);
+    bottom = std::max(bottom, top);
+    return Rect{left, top, static_cast<unsigned int>(right - left),
+                static_cast<unsigned int>(bottom - top)};
+}
+
+}
+
 
 
 
@@ -28,6 +72,8 @@ EWMHManager::EWMHManager(Display* display, Window root)
     , showing_desktop_(false)
 {
     initAtoms();
+    client_list_prop_.atom = atoms_.NET_CLIENT_LIST;
+    client_stacking_prop_.atom = atoms_.NET_CLIENT_LIST_STACKING;
 }
 
 EWMHManager::~EWMHManager() {
@@ -72,6 +118,11 @@ bool EWMHManager::initialize(const char* wm_name) {
     
     setShowingDesktop(false);
     
+    // Replace whatever a previous window manager left behind
+    client_list_prop_.dirty = true;
+    stacking_dirty_ = true;
+    flush();
+    
     std::cout << "[EWMH] Initialized with WM name: " << wm_name << std::endl;
     return true;
 }
@@ -294,23 +345,21 @@ void EWMHManager::setSupportedHints() {
 
 void EWMHManager::setNumberOfDesktops(int count) {
     num_desktops_ = count;
+    writeWorkarea();
     
-    unsigned long value = static_cast<unsigned long>(count);
-    XChangeProperty(display_, root_, atoms_.NET_NUMBER_OF_DESKTOPS,
-                   XA_CARDINAL, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(&value), 1);
+    setCardinalProperty(root_, atoms_.NET_NUMBER_OF_DESKTOPS, static_cast<unsigned long>(count));
 }
 
 void EWMHManager::setCurrentDesktop(int index) {
     current_desktop_ = index;
     
-    unsigned long value = static_cast<unsigned long>(index);
-    XChangeProperty(display_, root_, atoms_.NET_CURRENT_DESKTOP,
-                   XA_CARDINAL, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(&value), 1);
+    setCardinalProperty(root_, atoms_.NET_CURRENT_DESKTOP, static_cast<unsigned long>(index));
 }
 
 void EWMHManager::setDesktopNames(const std::vector<std::string>& names) {
+    if (names == desktop_names_ && findShadow(root_, atoms_.NET_DESKTOP_NAMES)) {
+        return;
+    }
     desktop_names_ = names;
     
     
@@ -320,80 +369,156 @@ void EWMHManager::setDesktopNames(const std::vector<std::string>& names) {
         combined += '\0';
     }
     
-    XChangeProperty(display_, root_, atoms_.NET_DESKTOP_NAMES,
-                   atoms_.UTF8_STRING, 8, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(const_cast<char*>(combined.c_str())),
-                   static_cast<int>(combined.size()));
+    writeProperty(root_, atoms_.NET_DESKTOP_NAMES, atoms_.UTF8_STRING, 8,
+                  combined.data(), static_cast<int>(combined.size()));
 }
 
-void EWMHManager::updateWorkarea(int screen_width, int screen_height,
-                                  unsigned long left, unsigned long right,
-                                  unsigned long top, unsigned long bottom) {
+void EWMHManager::writeWorkarea() {
+    if (screen_width_ <= 0 || screen_height_ <= 0) {
+        return;
+    }
     
     std::vector<unsigned long> workarea;
     workarea.reserve(num_desktops_ * 4);
     
     for (int i = 0; i < num_desktops_; ++i) {
-        workarea.push_back(left);                              
-        workarea.push_back(top);                               
-        workarea.push_back(screen_width - left - right);       
-        workarea.push_back(screen_height - top - bottom);      
+        workarea.push_back(static_cast<unsigned long>(screen_area_.x));
+        workarea.push_back(static_cast<unsigned long>(screen_area_.y));
+        workarea.push_back(screen_area_.width);
+        workarea.push_back(screen_area_.height);
     }
     
-    XChangeProperty(display_, root_, atoms_.NET_WORKAREA,
-                   XA_CARDINAL, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(workarea.data()),
-                   static_cast<int>(workarea.size()));
+    writeProperty(root_, atoms_.NET_WORKAREA, XA_CARDINAL, 32,
+                  workarea.data(), static_cast<int>(workarea.size()));
 }
 
 void EWMHManager::setShowingDesktop(bool showing) {
     showing_desktop_ = showing;
     
-    unsigned long value = showing ? 1 : 0;
-    XChangeProperty(display_, root_, atoms_.NET_SHOWING_DESKTOP,
-                   XA_CARDINAL, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(&value), 1);
+    setCardinalProperty(root_, atoms_.NET_SHOWING_DESKTOP, showing ? 1 : 0);
 }
 
 
 
 
 
-void EWMHManager::setClientList(const std::vector<Window>& windows) {
-    client_list_ = windows;
+void EWMHManager::addClient(Window window) {
+    if (!client_set_.insert(window).second) {
+        return;
+    }
+    client_list_.push_back(window);
+    client_list_prop_.dirty = true;
     
-    if (windows.empty()) {
-        XDeleteProperty(display_, root_, atoms_.NET_CLIENT_LIST);
+    if (std::find(root_stack_.begin(), root_stack_.end(), window) == root_stack_.end()) {
+        root_stack_.push_back(window);
+    }
+    stacking_dirty_ = true;
+}
+
+void EWMHManager::removeClient(Window window) {
+    if (client_set_.erase(window) == 0) {
         return;
     }
+    client_list_.erase(std::find(client_list_.begin(), client_list_.end(), window));
+    client_list_prop_.dirty = true;
+    stacking_dirty_ = true;
+}
+
+void EWMHManager::setStackingOrder(const Window* children, unsigned int count) {
+    root_stack_.assign(children, children + count);
+    stacking_dirty_ = true;
+}
+
+void EWMHManager::handleStackingEvent(const XEvent& event) {
+    Window window = None;
+    
+    switch (event.type) {
+        case CreateNotify:
+            if (event.xcreatewindow.parent != root_) return;
+            root_stack_.push_back(event.xcreatewindow.window);
+            return;
+            
+        case DestroyNotify:
+            if (event.xdestroywindow.event != root_) return;
+            std::erase(root_stack_, event.xdestroywindow.window);
+            return;
+            
+        case ReparentNotify:
+            if (event.xreparent.event != root_) return;
+            window = event.xreparent.window;
+            std::erase(root_stack_, window);
+            if (event.xreparent.parent == root_) {
+                root_stack_.push_back(window);
+            }
+            break;
+            
+        case ConfigureNotify: {
+            if (event.xconfigure.event != root_) return;
+            window = event.xconfigure.window;
+            std::erase(root_stack_, window);
+            auto pos = root_stack_.begin();
+            if (event.xconfigure.above != None) {
+                auto sibling = std::find(root_stack_.begin(), root_stack_.end(), event.xconfigure.above);
+                pos = sibling != root_stack_.end() ? sibling + 1 : root_stack_.end();
+            }
+            root_stack_.insert(pos, window);
+            break;
+        }
+            
+        case CirculateNotify:
+            if (event.xcirculate.event != root_) return;
+            window = event.xcirculate.window;
+            std::erase(root_stack_, window);
+            if (event.xcirculate.place == PlaceOnTop) {
+                root_stack_.push_back(window);
+            } else {
+                root_stack_.insert(root_stack_.begin(), window);
+            }
+            break;
+            
+        default:
+            return;
+    }
     
-    XChangeProperty(display_, root_, atoms_.NET_CLIENT_LIST,
-                   XA_WINDOW, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(const_cast<Window*>(windows.data())),
-                   static_cast<int>(windows.size()));
+    // Moving an unmanaged sibling never changes the clients' relative order
+    if (client_set_.count(window)) {
+        stacking_dirty_ = true;
+    }
 }
 
-void EWMHManager::setClientListStacking(const std::vector<Window>& windows) {
-    if (windows.empty()) {
-        XDeleteProperty(display_, root_, atoms_.NET_CLIENT_LIST_STACKING);
+void EWMHManager::syncClientList(ClientListProperty& prop, const std::vector<Window>& windows) {
+    prop.dirty = false;
+    if (prop.known && windows == prop.synced) {
         return;
     }
     
-    XChangeProperty(display_, root_, atoms_.NET_CLIENT_LIST_STACKING,
-                   XA_WINDOW, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(const_cast<Window*>(windows.data())),
-                   static_cast<int>(windows.size()));
+    bool append = prop.known && windows.size() > prop.synced.size() &&
+                  std::equal(prop.synced.begin(), prop.synced.end(), windows.begin());
+    
+    if (windows.empty()) {
+        XDeleteProperty(display_, root_, prop.atom);
+    } else if (append) {
+        const Window* tail = windows.data() + prop.synced.size();
+        XChangeProperty(display_, root_, prop.atom, XA_WINDOW, 32, PropModeAppend,
+                       reinterpret_cast<const unsigned char*>(tail),
+                       static_cast<int>(windows.size() - prop.synced.size()));
+    } else {
+        XChangeProperty(display_, root_, prop.atom, XA_WINDOW, 32, PropModeReplace,
+                       reinterpret_cast<const unsigned char*>(windows.data()),
+                       static_cast<int>(windows.size()));
+    }
+    
+    prop.synced = windows;
+    prop.known = true;
 }
 
 void EWMHManager::setActiveWindow(Window window) {
     if (window == None) {
-        XDeleteProperty(display_, root_, atoms_.NET_ACTIVE_WINDOW);
+        deleteProperty(root_, atoms_.NET_ACTIVE_WINDOW);
         return;
     }
     
-    XChangeProperty(display_, root_, atoms_.NET_ACTIVE_WINDOW,
-                   XA_WINDOW, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(&window), 1);
+    writeProperty(root_, atoms_.NET_ACTIVE_WINDOW, XA_WINDOW, 32, &window, 1);
 }
 
 
@@ -401,9 +526,7 @@ void EWMHManager::setActiveWindow(Window window) {
 
 
 void EWMHManager::setWindowDesktop(Window window, unsigned long desktop) {
-    XChangeProperty(display_, window, atoms_.NET_WM_DESKTOP,
-                   XA_CARDINAL, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(&desktop), 1);
+    setCardinalProperty(window, atoms_.NET_WM_DESKTOP, desktop);
 }
 
 unsigned long EWMHManager::getWindowDesktop(Window window) {
@@ -411,15 +534,7 @@ unsigned long EWMHManager::getWindowDesktop(Window window) {
 }
 
 void EWMHManager::setWindowState(Window window, const std::vector<Atom>& states) {
-    if (states.empty()) {
-        XDeleteProperty(display_, window, atoms_.NET_WM_STATE);
-        return;
-    }
-    
-    XChangeProperty(display_, window, atoms_.NET_WM_STATE,
-                   XA_ATOM, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(const_cast<Atom*>(states.data())),
-                   static_cast<int>(states.size()));
+    setAtomVectorProperty(window, atoms_.NET_WM_STATE, states);
 }
 
 void EWMHManager::addWindowState(Window window, Atom state) {
@@ -454,9 +569,7 @@ bool EWMHManager::hasWindowState(Window window, Atom state) {
 }
 
 void EWMHManager::setWindowType(Window window, Atom type) {
-    XChangeProperty(display_, window, atoms_.NET_WM_WINDOW_TYPE,
-                   XA_ATOM, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(&type), 1);
+    writeProperty(window, atoms_.NET_WM_WINDOW_TYPE, XA_ATOM, 32, &type, 1);
 }
 
 WindowType EWMHManager::getWindowType(Window window) {
@@ -485,22 +598,11 @@ WindowType EWMHManager::getWindowType(Window window) {
 }
 
 void EWMHManager::setWindowAllowedActions(Window window, const std::vector<Atom>& actions) {
-    if (actions.empty()) {
-        XDeleteProperty(display_, window, atoms_.NET_WM_ALLOWED_ACTIONS);
-        return;
-    }
-    
-    XChangeProperty(display_, window, atoms_.NET_WM_ALLOWED_ACTIONS,
-                   XA_ATOM, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(const_cast<Atom*>(actions.data())),
-                   static_cast<int>(actions.size()));
+    setAtomVectorProperty(window, atoms_.NET_WM_ALLOWED_ACTIONS, actions);
 }
 
 void EWMHManager::setWindowPID(Window window, pid_t pid) {
-    unsigned long value = static_cast<unsigned long>(pid);
-    XChangeProperty(display_, window, atoms_.NET_WM_PID,
-                   XA_CARDINAL, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(&value), 1);
+    setCardinalProperty(window, atoms_.NET_WM_PID, static_cast<unsigned long>(pid));
 }
 
 pid_t EWMHManager::getWindowPID(Window window) {
@@ -797,13 +899,19 @@ std::string EWMHManager::getTextProperty(Window window, Atom property) {
 
 void EWMHManager::setTextProperty(Window window, Atom property, 
                                    const std::string& value) {
-    XChangeProperty(display_, window, property,
-                   atoms_.UTF8_STRING, 8, PropModeReplace,
-                   reinterpret_cast<const unsigned char*>(value.c_str()),
-                   static_cast<int>(value.size()));
+    writeProperty(window, property, atoms_.UTF8_STRING, 8,
+                  value.data(), static_cast<int>(value.size()));
 }
 
 unsigned long EWMHManager::getCardinalProperty(Window window, Atom property) {
+    if (const PropertyShadow* shadow = findShadow(window, property)) {
+        unsigned long value = 0;
+        if (shadow->format == 32 && shadow->count > 0) {
+            std::memcpy(&value, shadow->data.data(), sizeof(value));
+        }
+        return value;
+    }
+    
     Atom actual_type;
     int actual_format;
     unsigned long nitems, bytes_after;
@@ -826,9 +934,7 @@ unsigned long EWMHManager::getCardinalProperty(Window window, Atom property) {
 
 void EWMHManager::setCardinalProperty(Window window, Atom property, 
                                        unsigned long value) {
-    XChangeProperty(display_, window, property,
-                   XA_CARDINAL, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(&value), 1);
+    writeProperty(window, property, XA_CARDINAL, 32, &value, 1);
 }
 
 std::vector<Atom> EWMHManager::getAtomVectorProperty(Window window, Atom property) {
@@ -839,6 +945,14 @@ std::vector<Atom> EWMHManager::getAtomVectorProperty(Window window, Atom propert
     
     std::vector<Atom> result;
     
+    if (const PropertyShadow* shadow = findShadow(window, property)) {
+        if (shadow->format == 32) {
+            result.resize(static_cast<size_t>(shadow->count));
+            std::memcpy(result.data(), shadow->data.data(), shadow->data.size());
+        }
+        return result;
+    }
+    
     if (XGetWindowProperty(display_, window, property, 0, 1024, False,
                           XA_ATOM, &actual_type, &actual_format,
                           &nitems, &bytes_after, &prop) != Success) {
@@ -857,14 +971,102 @@ std::vector<Atom> EWMHManager::getAtomVectorProperty(Window window, Atom propert
 void EWMHManager::setAtomVectorProperty(Window window, Atom property,
                                          const std::vector<Atom>& values) {
     if (values.empty()) {
-        XDeleteProperty(display_, window, property);
+        deleteProperty(window, property);
         return;
     }
     
-    XChangeProperty(display_, window, property,
-                   XA_ATOM, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(const_cast<Atom*>(values.data())),
-                   static_cast<int>(values.size()));
+    writeProperty(window, property, XA_ATOM, 32,
+                  values.data(), static_cast<int>(values.size()));
+}
+
+const EWMHManager::PropertyShadow* EWMHManager::findShadow(Window window, Atom property) const {
+    auto it = shadow_.find(propertyKey(window, property));
+    return it != shadow_.end() ? &it->second : nullptr;
+}
+
+void EWMHManager::writeProperty(Window window, Atom property, Atom type, int format,
+                                const void* data, int count) {
+    // Xlib takes format-32 data as an array of long
+    size_t bytes = static_cast<size_t>(count) *
+        (format == 32 ? sizeof(long) : format == 16 ? sizeof(short) : 1);
+    std::string_view value(static_cast<const char*>(data), bytes);
+    
+    auto [it, inserted] = shadow_.try_emplace(propertyKey(window, property));
+    PropertyShadow& shadow = it->second;
+    if (!inserted && shadow.type == type && shadow.format == format && shadow.data == value) {
+        return;
+    }
+    
+    shadow.type = type;
+    shadow.format = format;
+    shadow.count = count;
+    shadow.data.assign(value);
+    if (!shadow.pending) {
+        shadow.pending = true;
+        pending_.push_back(it->first);
+    }
+}
+
+void EWMHManager::deleteProperty(Window window, Atom property) {
+    auto [it, inserted] = shadow_.try_emplace(propertyKey(window, property));
+    PropertyShadow& shadow = it->second;
+    if (!inserted && shadow.format == 0) {
+        return;
+    }
+    
+    shadow.type = None;
+    shadow.format = 0;
+    shadow.count = 0;
+    shadow.data.clear();
+    if (!shadow.pending) {
+        shadow.pending = true;
+        pending_.push_back(it->first);
+    }
+}
+
+void EWMHManager::flush() {
+    if (client_list_prop_.dirty) {
+        syncClientList(client_list_prop_, client_list_);
+    }
+    
+    if (stacking_dirty_) {
+        stacking_dirty_ = false;
+        client_stacking_.clear();
+        for (Window window : root_stack_) {
+            if (client_set_.count(window)) {
+                client_stacking_.push_back(window);
+            }
+        }
+        syncClientList(client_stacking_prop_, client_stacking_);
+    }
+    
+    for (uint64_t key : pending_) {
+        auto it = shadow_.find(key);
+        if (it == shadow_.end() || !it->second.pending) {
+            continue;
+        }
+        
+        PropertyShadow& shadow = it->second;
+        shadow.pending = false;
+        Window window = static_cast<Window>(key >> 32);
+        Atom property = static_cast<Atom>(key & 0xFFFFFFFFu);
+        
+        if (shadow.format == 0) {
+            XDeleteProperty(display_, window, property);
+        } else {
+            XChangeProperty(display_, window, property, shadow.type, shadow.format,
+                           PropModeReplace,
+                           reinterpret_cast<const unsigned char*>(shadow.data.data()),
+                           shadow.count);
+        }
+    }
+    pending_.clear();
+}
+
+void EWMHManager::forgetWindow(Window window) {
+    std::erase_if(shadow_, [window](const auto& entry) {
+        return static_cast<Window>(entry.first >> 32) == window;
+    });
 }
 
 
@@ -901,6 +1103,7 @@ EWMHManager::StrutPartial EWMHManager::getStrutPartial(Window window) {
     }
     
     if (prop) XFree(prop);
+    prop = nullptr;
     
     
     if (XGetWindowProperty(display_, window, atoms_.NET_WM_STRUT, 0, 4, False,
@@ -912,6 +1115,7 @@ EWMHManager::StrutPartial EWMHManager::getStrutPartial(Window window) {
         strut.top = values[2];
         strut.bottom = values[3];
         XFree(prop);
+        prop = nullptr;
     }
     
     if (prop) XFree(prop);
@@ -919,79 +1123,87 @@ EWMHManager::StrutPartial EWMHManager::getStrutPartial(Window window) {
     return strut;
 }
 
-EWMHManager::StrutPartial EWMHManager::getCombinedStruts(int screen_width, int screen_height) {
-    StrutPartial combined;
+void EWMHManager::setScreenGeometry(int screen_width, int screen_height,
+                                    const std::vector<Rect>& monitors) {
+    screen_width_ = screen_width;
+    screen_height_ = screen_height;
+    monitors_ = monitors;
+    recomputeUsableAreas();
+}
+
+const Rect& EWMHManager::getUsableArea(int monitor) const {
+    if (monitor >= 0 && monitor < static_cast<int>(usable_areas_.size())) {
+        return usable_areas_[monitor];
+    }
+    return screen_area_;
+}
+
+void EWMHManager::recomputeUsableAreas() {
+    std::vector<StrutPartial> struts;
+    struts.reserve(dock_struts_.size());
+    for (const auto& [dock, strut] : dock_struts_) {
+        struts.push_back(strut);
+    }
     
+    screen_area_ = applyStruts(Rect{0, 0, static_cast<unsigned int>(screen_width_),
+                                    static_cast<unsigned int>(screen_height_)},
+                               struts, screen_width_, screen_height_);
     
-    for (Window dock : dock_windows_) {
-        StrutPartial strut = getStrutPartial(dock);
-        
-        
-        
-        
-        
-        if (strut.left > 0) {
-            if (strut.left_start_y == 0 && strut.left_end_y >= static_cast<unsigned long>(screen_height - 1)) {
-                combined.left = std::max(combined.left, strut.left);
-            } else if (strut.left_start_y == 0 && strut.left_end_y == 0) {
-                
-                combined.left = std::max(combined.left, strut.left);
-            }
-        }
-        
-        
-        if (strut.right > 0) {
-            if (strut.right_start_y == 0 && strut.right_end_y >= static_cast<unsigned long>(screen_height - 1)) {
-                combined.right = std::max(combined.right, strut.right);
-            } else if (strut.right_start_y == 0 && strut.right_end_y == 0) {
-                combined.right = std::max(combined.right, strut.right);
-            }
-        }
-        
-        
-        if (strut.top > 0) {
-            if (strut.top_start_x == 0 && strut.top_end_x >= static_cast<unsigned long>(screen_width - 1)) {
-                combined.top = std::max(combined.top, strut.top);
-            } else if (strut.top_start_x == 0 && strut.top_end_x == 0) {
-                
-                combined.top = std::max(combined.top, strut.top);
-            }
-        }
-        
-        
-        if (strut.bottom > 0) {
-            if (strut.bottom_start_x == 0 && strut.bottom_end_x >= static_cast<unsigned long>(screen_width - 1)) {
-                combined.bottom = std::max(combined.bottom, strut.bottom);
-            } else if (strut.bottom_start_x == 0 && strut.bottom_end_x == 0) {
-                combined.bottom = std::max(combined.bottom, strut.bottom);
-            }
-        }
+    usable_areas_.clear();
+    for (const Rect& monitor : monitors_) {
+        usable_areas_.push_back(applyStruts(monitor, struts, screen_width_, screen_height_));
     }
     
-    std::cout << "[EWMH] Combined struts: left=" << combined.left 
-              << " right=" << combined.right 
-              << " top=" << combined.top 
-              << " bottom=" << combined.bottom << std::endl;
-    
-    return combined;
+    writeWorkarea();
 }
 
-void EWMHManager::registerDockWindow(Window window) {
+bool EWMHManager::registerDockWindow(Window window) {
     
     if (std::find(dock_windows_.begin(), dock_windows_.end(), window) != dock_windows_.end()) {
-        return;
+        return false;
     }
     
+    // Strut changes arrive as PropertyNotify; that is the only re-read
+    XSelectInput(display_, window, PropertyChangeMask);
     dock_windows_.push_back(window);
+    dock_struts_[window] = getStrutPartial(window);
+    recomputeUsableAreas();
+    
     std::cout << "[EWMH] Registered dock window: " << window << std::endl;
+    return true;
 }
 
-void EWMHManager::unregisterDockWindow(Window window) {
+bool EWMHManager::unregisterDockWindow(Window window) {
     auto it = std::find(dock_windows_.begin(), dock_windows_.end(), window);
-    if (it != dock_windows_.end()) {
-        dock_windows_.erase(it);
-        std::cout << "[EWMH] Unregistered dock window: " << window << std::endl;
+    if (it == dock_windows_.end()) {
+        return false;
+    }
+    
+    dock_windows_.erase(it);
+    dock_struts_.erase(window);
+    recomputeUsableAreas();
+    std::cout << "[EWMH] Unregistered dock window: " << window << std::endl;
+    return true;
+}
+
+bool EWMHManager::handleDockPropertyNotify(const XPropertyEvent& event) {
+    if (event.atom != atoms_.NET_WM_STRUT_PARTIAL && event.atom != atoms_.NET_WM_STRUT) {
+        return false;
+    }
+    
+    auto it = dock_struts_.find(event.window);
+    if (it == dock_struts_.end()) {
+        return false;
+    }
+    
+    StrutPartial strut = getStrutPartial(event.window);
+    if (std::memcmp(&strut, &it->second, sizeof(strut)) == 0) {
+        return false;
     }
+    
+    it->second = strut;
+    recomputeUsableAreas();
+    return true;
 }
 
 
@@ -999,9 +1211,7 @@ void EWMHManager::unregisterDockWindow(Window window) {
 
 
 void EWMHManager::setCurrentWorkspacePB(int workspace) {
-    XChangeProperty(display_, root_, atoms_.PB_CURRENT_WORKSPACE,
-                   XA_CARDINAL, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(&workspace), 1);
+    setCardinalProperty(root_, atoms_.PB_CURRENT_WORKSPACE, static_cast<unsigned long>(workspace));
 }
 
 void EWMHManager::setWorkspaceNamesPB(const std::vector<std::string>& names) {
@@ -1012,15 +1222,12 @@ void EWMHManager::setWorkspaceNamesPB(const std::vector<std::string>& names) {
         data += names[i];
     }
     
-    XChangeProperty(display_, root_, atoms_.PB_WORKSPACE_NAMES,
-                   atoms_.UTF8_STRING, 8, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(const_cast<char*>(data.c_str())),
-                   static_cast<int>(data.size()));
+    setTextProperty(root_, atoms_.PB_WORKSPACE_NAMES, data);
 }
 
 void EWMHManager::setOccupiedWorkspacesPB(const std::vector<int>& workspaces) {
     if (workspaces.empty()) {
-        XDeleteProperty(display_, root_, atoms_.PB_OCCUPIED_WORKSPACES);
+        deleteProperty(root_, atoms_.PB_OCCUPIED_WORKSPACES);
         return;
     }
     
@@ -1029,36 +1236,25 @@ void EWMHManager::setOccupiedWorkspacesPB(const std::vector<int>& workspaces) {
         data[i] = static_cast<unsigned long>(workspaces[i]);
     }
     
-    XChangeProperty(display_, root_, atoms_.PB_OCCUPIED_WORKSPACES,
-                   XA_CARDINAL, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(data.data()),
-                   static_cast<int>(data.size()));
+    writeProperty(root_, atoms_.PB_OCCUPIED_WORKSPACES, XA_CARDINAL, 32,
+                  data.data(), static_cast<int>(data.size()));
 }
 
 void EWMHManager::setActiveWindowTitlePB(const std::string& title) {
-    XChangeProperty(display_, root_, atoms_.PB_ACTIVE_WINDOW_TITLE,
-                   atoms_.UTF8_STRING, 8, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(const_cast<char*>(title.c_str())),
-                   static_cast<int>(title.size()));
+    setTextProperty(root_, atoms_.PB_ACTIVE_WINDOW_TITLE, title);
 }
 
 void EWMHManager::setActiveWindowClassPB(const std::string& window_class) {
-    XChangeProperty(display_, root_, atoms_.PB_ACTIVE_WINDOW_CLASS,
-                   atoms_.UTF8_STRING, 8, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(const_cast<char*>(window_class.c_str())),
-                   static_cast<int>(window_class.size()));
+    setTextProperty(root_, atoms_.PB_ACTIVE_WINDOW_CLASS, window_class);
 }
 
 void EWMHManager::setLayoutModePB(const std::string& mode) {
-    XChangeProperty(display_, root_, atoms_.PB_LAYOUT_MODE,
-                   atoms_.UTF8_STRING, 8, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(const_cast<char*>(mode.c_str())),
-                   static_cast<int>(mode.size()));
+    setTextProperty(root_, atoms_.PB_LAYOUT_MODE, mode);
 }
 
 void EWMHManager::setWorkspaceWindowCountsPB(const std::vector<int>& counts) {
     if (counts.empty()) {
-        XDeleteProperty(display_, root_, atoms_.PB_WORKSPACE_WINDOW_COUNTS);
+        deleteProperty(root_, atoms_.PB_WORKSPACE_WINDOW_COUNTS);
         return;
     }
     
@@ -1067,10 +1263,8 @@ void EWMHManager::setWorkspaceWindowCountsPB(const std::vector<int>& counts) {
         data[i] = static_cast<unsigned long>(counts[i]);
     }
     
-    XChangeProperty(display_, root_, atoms_.PB_WORKSPACE_WINDOW_COUNTS,
-                   XA_CARDINAL, 32, PropModeReplace,
-                   reinterpret_cast<unsigned char*>(data.data()),
-                   static_cast<int>(data.size()));
+    writeProperty(root_, atoms_.PB_WORKSPACE_WINDOW_COUNTS, XA_CARDINAL, 32,
+                  data.data(), static_cast<int>(data.size()));
 }
 
 } 
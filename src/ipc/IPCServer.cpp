@@ -1,19 +1,157 @@
 #include "pointblank/ipc/IPCServer.hpp"
-#include "pointblank/core/WindowManager.hpp"
-#include "pointblank/layout/LayoutEngine.hpp"
-#include "pointblank/window/FloatingWindowManager.hpp"
 
 #include <iostream>
 #include <sstream>
+#include <charconv>
 #include <cstring>
 #include <algorithm>
+#include <cstdio>
 #include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <errno.h>
 
 namespace pblank {
 
+namespace {
+
+constexpr int MAX_EPOLL_EVENTS = 256;
+constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+constexpr int MAX_WRITE_IOVECS = 64;
+
+struct TopicName {
+    IPCEventTopic topic;
+    const char* name;
+};
+
+constexpr TopicName TOPIC_NAMES[] = {
+    {IPCEventTopic::Workspace, "workspace"},
+    {IPCEventTopic::Focus,     "focus"},
+    {IPCEventTopic::Title,     "title"},
+    {IPCEventTopic::Layout,    "layout"},
+    {IPCEventTopic::Window,    "window"},
+    {IPCEventTopic::Monitor,   "monitor"},
+};
+
+void writeTopicList(JSONWriter& out, uint32_t mask) {
+    out.beginArray();
+    for (const auto& entry : TOPIC_NAMES) {
+        if (mask & static_cast<uint32_t>(entry.topic)) {
+            out.value(entry.name);
+        }
+    }
+    out.endArray();
+}
+
+bool isGenerationArg(const std::string& arg) {
+    return arg.starts_with("if_generation=");
+}
+
+// `if_generation=N` matching the facet's current generation
+bool isUnchanged(const std::vector<std::string>& args, const IPCStateSnapshot* state, IPCFacet facet) {
+    if (!state) {
+        return false;
+    }
+    for (const auto& arg : args) {
+        if (!isGenerationArg(arg)) {
+            continue;
+        }
+        uint64_t generation = 0;
+        const char* first = arg.data() + arg.find('=') + 1;
+        const char* last = arg.data() + arg.size();
+        auto res = std::from_chars(first, last, generation);
+        return res.ec == std::errc() && res.ptr == last && generation == state->generation(facet);
+    }
+    return false;
+}
+
+IPCResponse unchangedResponse(JSONWriter& out, uint64_t generation) {
+    out.clear();
+    out.beginObject().key("unchanged").value(true).key("generation").value(generation).endObject();
+    return IPCResponse::ok("Unchanged", out.str());
+}
+
+bool parseWindowId(const std::string& text, Window& window) {
+    unsigned long long value = 0;
+    const char* first = text.data();
+    const char* last = first + text.size();
+    int base = 10;
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        first += 2;
+        base = 16;
+    }
+    auto res = std::from_chars(first, last, value, base);
+    if (res.ec != std::errc() || res.ptr != last) {
+        return false;
+    }
+    window = static_cast<Window>(value);
+    return true;
+}
+
+}
+
+const char* ipcEventTopicName(IPCEventTopic topic) {
+    for (const auto& entry : TOPIC_NAMES) {
+        if (entry.topic == topic) {
+            return entry.name;
+        }
+    }
+    return "event";
+}
+
+std::optional<IPCEventTopic> ipcEventTopicFromString(std::string_view name) {
+    if (name == "all" || name == "*") {
+        return IPCEventTopic::All;
+    }
+    for (const auto& entry : TOPIC_NAMES) {
+        if (name == entry.name) {
+            return entry.topic;
+        }
+    }
+    return std::nullopt;
+}
+
+void IPCEventQueue::push(std::shared_ptr<const IPCEvent> event) {
+    if (event->coalesce) {
+        for (size_t i = 0; i < count_; ++i) {
+            auto& slot = slots_[(head_ + i) % IPC_EVENT_QUEUE_DEPTH];
+            if (slot->coalesce && slot->topic == event->topic && slot->window == event->window) {
+                slot = std::move(event);
+                return;
+            }
+        }
+    }
+    
+    if (count_ == IPC_EVENT_QUEUE_DEPTH) {
+        slots_[head_].reset();
+        head_ = (head_ + 1) % IPC_EVENT_QUEUE_DEPTH;
+        --count_;
+        ++dropped_;
+    }
+    
+    slots_[(head_ + count_) % IPC_EVENT_QUEUE_DEPTH] = std::move(event);
+    ++count_;
+}
+
+const IPCWindowRecord* IPCStateSnapshot::findWindow(Window window) const {
+    auto it = std::lower_bound(windows.begin(), windows.end(), window,
+        [](const IPCWindowRecord& record, Window w) { return record.window < w; });
+    return (it != windows.end() && it->window == window) ? &*it : nullptr;
+}
+
+std::shared_ptr<const IPCEvent> IPCEventQueue::pop() {
+    if (count_ == 0) {
+        return nullptr;
+    }
+    auto event = std::move(slots_[head_]);
+    head_ = (head_ + 1) % IPC_EVENT_QUEUE_DEPTH;
+    --count_;
+    return event;
+}
+
 bool IPCServer::start() {
     if (running_.load()) {
         return true;
@@ -30,17 +168,13 @@ bool IPCServer::start() {
     unlink(socket_path_.c_str());
     
     
-    server_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    server_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (server_fd_ < 0) {
         std::cerr << "IPC: Failed to create socket: " << strerror(errno) << std::endl;
         return false;
     }
     
     
-    int opt = 1;
-    setsockopt(server_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-    
-    
     sockaddr_un addr;
     memset(&addr, 0, sizeof(addr));
     addr.sun_family = AF_UNIX;
@@ -57,7 +191,7 @@ bool IPCServer::start() {
     chmod(socket_path_.c_str(), 0600);
     
     
-    if (listen(server_fd_, 10) < 0) {
+    if (listen(server_fd_, SOMAXCONN) < 0) {
         std::cerr << "IPC: Failed to listen: " << strerror(errno) << std::endl;
         close(server_fd_);
         server_fd_ = -1;
@@ -65,14 +199,30 @@ bool IPCServer::start() {
         return false;
     }
     
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        std::cerr << "IPC: Failed to create reactor: " << strerror(errno) << std::endl;
+        if (epoll_fd_ >= 0) close(epoll_fd_);
+        if (wake_fd_ >= 0) close(wake_fd_);
+        epoll_fd_ = wake_fd_ = -1;
+        close(server_fd_);
+        server_fd_ = -1;
+        unlink(socket_path_.c_str());
+        return false;
+    }
     
-    int flags = fcntl(server_fd_, F_GETFL, 0);
-    fcntl(server_fd_, F_SETFL, flags | O_NONBLOCK);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = server_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, server_fd_, &ev);
+    ev.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
     
     running_.store(true);
     
     
-    accept_thread_ = std::thread(&IPCServer::acceptLoop, this);
+    reactor_thread_ = std::thread(&IPCServer::reactorLoop, this);
     
     std::cout << "IPC: Server started at " << socket_path_ << std::endl;
     return true;
@@ -86,27 +236,36 @@ void IPCServer::stop() {
     running_.store(false);
     
     
-    if (server_fd_ >= 0) {
-        close(server_fd_);
-        server_fd_ = -1;
+    uint64_t one = 1;
+    ssize_t ignored = write(wake_fd_, &one, sizeof(one));
+    (void)ignored;
+    
+    if (reactor_thread_.joinable()) {
+        reactor_thread_.join();
     }
     
     
-    unlink(socket_path_.c_str());
+    for (auto& [fd, client] : clients_) {
+        close(fd);
+    }
+    clients_.clear();
+    subscribers_.clear();
+    subscribed_topics_.store(0);
+    while (event_queue_.pop()) {}
+    while (transactions_.pop()) {}
+    while (completions_.pop()) {}
     
+    close(epoll_fd_);
+    close(wake_fd_);
+    epoll_fd_ = wake_fd_ = -1;
     
-    {
-        std::lock_guard<std::mutex> lock(client_mutex_);
-        for (int fd : client_fds_) {
-            close(fd);
-        }
-        client_fds_.clear();
+    if (server_fd_ >= 0) {
+        close(server_fd_);
+        server_fd_ = -1;
     }
     
     
-    if (accept_thread_.joinable()) {
-        accept_thread_.join();
-    }
+    unlink(socket_path_.c_str());
     
     std::cout << "IPC: Server stopped" << std::endl;
 }
@@ -115,289 +274,1186 @@ void IPCServer::setCommandCallback(IPCCallback callback) {
     command_callback_ = std::move(callback);
 }
 
+std::unique_ptr<IPCTransaction> IPCServer::takeTransaction() {
+    auto transaction = transactions_.pop();
+    return transaction ? std::move(*transaction) : nullptr;
+}
+
+void IPCServer::completeTransaction(std::unique_ptr<IPCTransaction> transaction) {
+    if (!running_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    completions_.push(std::move(transaction));
+    wakeReactor();
+}
+
 void IPCServer::broadcast(const std::string& message) {
-    std::lock_guard<std::mutex> lock(subscriber_mutex_);
+    auto event = std::make_shared<IPCEvent>();
+    event->topic = IPCEventTopic::All;
+    event->line = message;
+    enqueueEvent(std::move(event));
+}
+
+void IPCServer::publish(IPCEventTopic topic, std::string_view payload, Window window) {
+    if (!hasSubscribers(topic)) {
+        return;
+    }
     
-    for (int fd : subscribers_) {
-        send(fd, message.c_str(), message.length(), 0);
+    auto event = std::make_shared<IPCEvent>();
+    event->topic = topic;
+    event->window = window;
+    event->coalesce = topic != IPCEventTopic::Window;
+    event->line.reserve(payload.size() + 24);
+    event->line.append("EVENT|").append(ipcEventTopicName(topic)).append("|").append(payload).append("\n");
+    enqueueEvent(std::move(event));
+}
+
+void IPCServer::enqueueEvent(std::shared_ptr<const IPCEvent> event) {
+    if (!running_.load(std::memory_order_relaxed)) {
+        return;
     }
+    
+    event_queue_.push(std::move(event));
+    wakeReactor();
 }
 
-void IPCServer::acceptLoop() {
+void IPCServer::wakeReactor() {
+    // Only the first event since the reactor last drained needs a wakeup;
+    // bursts published within one frame cost a single eventfd write.
+    if (!wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+        uint64_t one = 1;
+        ssize_t ignored = write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void IPCServer::reactorLoop() {
+    epoll_event events[MAX_EPOLL_EVENTS];
+    
     while (running_.load()) {
-        sockaddr_un client_addr;
-        socklen_t client_len = sizeof(client_addr);
+        int n = epoll_wait(epoll_fd_, events, MAX_EPOLL_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "IPC: epoll_wait failed: " << strerror(errno) << std::endl;
+            break;
+        }
         
-        int client_fd = accept(server_fd_, (sockaddr*)&client_addr, &client_len);
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            uint32_t ev = events[i].events;
+            
+            if (fd == server_fd_) {
+                acceptClients();
+                continue;
+            }
+            
+            if (fd == wake_fd_) {
+                uint64_t count;
+                while (read(wake_fd_, &count, sizeof(count)) > 0) {}
+                wake_pending_.store(false, std::memory_order_release);
+                drainEvents();
+                drainCompletions();
+                continue;
+            }
+            
+            auto it = clients_.find(fd);
+            if (it == clients_.end()) {
+                continue;
+            }
+            IPCClient& client = *it->second;
+            
+            // A hangup often arrives together with the peer's last request
+            // (`echo cmd | socat ...`), so read before closing and let
+            // recv() returning 0 decide. Only a bare error closes at once.
+            if ((ev & EPOLLERR) && !(ev & EPOLLIN)) {
+                closeClient(fd);
+                continue;
+            }
+            
+            if ((ev & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) && !readClient(client)) {
+                continue;
+            }
+            
+            if (ev & EPOLLOUT) {
+                settleClient(client, deliver(client));
+            }
+        }
+    }
+}
+
+void IPCServer::acceptClients() {
+    while (true) {
+        int client_fd = accept4(server_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
         
         if (client_fd < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            if (errno == EINTR || errno == ECONNABORTED) {
                 continue;
             }
-            break;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "IPC: accept failed: " << strerror(errno) << std::endl;
+            }
+            return;
         }
         
+        auto client = std::make_unique<IPCClient>();
+        client->fd = client_fd;
+        client->serial = next_serial_++;
+        client->events = EPOLLIN | EPOLLRDHUP;
         
-        int flags = fcntl(client_fd, F_GETFL, 0);
-        fcntl(client_fd, F_SETFL, flags | O_NONBLOCK);
+        epoll_event ev{};
+        ev.events = client->events;
+        ev.data.fd = client_fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &ev) < 0) {
+            std::cerr << "IPC: Failed to register client: " << strerror(errno) << std::endl;
+            close(client_fd);
+            continue;
+        }
         
+        clients_[client_fd] = std::move(client);
+    }
+}
+
+bool IPCServer::readClient(IPCClient& client) {
+    static thread_local char buffer[READ_CHUNK_SIZE];
+    
+    // One read per wakeup keeps a chatty client from starving the others;
+    // the level-triggered registration brings us back for the rest.
+    if (!client.eof) {
+        ssize_t n;
+        do {
+            n = recv(client.fd, buffer, sizeof(buffer), 0);
+        } while (n < 0 && errno == EINTR);
         
-        {
-            std::lock_guard<std::mutex> lock(client_mutex_);
-            if (client_fds_.size() >= MAX_IPC_CLIENTS) {
-                std::cerr << "IPC: Max clients reached (" << MAX_IPC_CLIENTS << "), rejecting connection" << std::endl;
-                close(client_fd);
+        if (n > 0) {
+            client.in.append(buffer, static_cast<size_t>(n));
+        } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            client.eof = true;
+        }
+    }
+    
+    processInput(client);
+    return settleClient(client, flushClient(client));
+}
+
+bool IPCServer::settleClient(IPCClient& client, bool flushed) {
+    if (!flushed) {
+        if (!client.eof || client.closing) {
+            closeClient(client.fd);
+            return false;
+        }
+        // The peer is gone for good: its replies have nowhere to go, but
+        // the requests it already sent still run
+        client.out.clear();
+        client.out_offset = 0;
+        client.out_bytes = 0;
+    }
+    
+    if (client.eof && !client.awaiting_commit && client.out_bytes == 0) {
+        closeClient(client.fd);
+        return false;
+    }
+    updateInterest(client);
+    return true;
+}
+
+void IPCServer::processInput(IPCClient& client) {
+    // A text line can switch the connection to binary framing midway
+    // through the buffer, so hand the remainder to the other decoder.
+    size_t start = 0;
+    while (!client.closing && !client.awaiting_commit) {
+        bool was_binary = client.binary;
+        start = was_binary ? processFrames(client, start) : processLines(client, start);
+        if (client.binary == was_binary) {
+            break;
+        }
+    }
+    client.in.erase(0, start);
+    
+    if (client.in.size() > IPC_MAX_REQUEST_SIZE) {
+        queueResponse(client, IPCResponse::error("Request too large"));
+        client.in.clear();
+        client.closing = true;
+    }
+}
+
+bool IPCServer::flushClient(IPCClient& client) {
+    iovec iov[MAX_WRITE_IOVECS];
+    
+    while (client.out_bytes > 0) {
+        int count = 0;
+        for (auto it = client.out.begin(); it != client.out.end() && count < MAX_WRITE_IOVECS; ++it, ++count) {
+            size_t skip = (count == 0) ? client.out_offset : 0;
+            iov[count].iov_base = const_cast<char*>(it->data() + skip);
+            iov[count].iov_len = it->size() - skip;
+        }
+        
+        // Gather write; sendmsg rather than writev so a vanished peer yields
+        // EPIPE instead of raising SIGPIPE in the window manager.
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = static_cast<size_t>(count);
+        ssize_t sent = sendmsg(client.fd, &msg, MSG_NOSIGNAL);
+        
+        if (sent < 0) {
+            if (errno == EINTR) {
                 continue;
             }
-            client_fds_.push_back(client_fd);
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return false;
         }
         
-        
-        std::thread([this, client_fd]() {
-            handleClient(client_fd);
-        }).detach();
+        size_t remaining = static_cast<size_t>(sent);
+        client.out_bytes -= remaining;
+        while (remaining > 0) {
+            size_t head = client.out.front().size() - client.out_offset;
+            if (remaining < head) {
+                client.out_offset += remaining;
+                break;
+            }
+            remaining -= head;
+            client.out.pop_front();
+            client.out_offset = 0;
+        }
     }
+    
+    return !(client.closing && client.out_bytes == 0);
 }
 
-void IPCServer::handleClient(int client_fd) {
+void IPCServer::updateInterest(IPCClient& client) {
+    // Backpressure: wait for EPOLLOUT while output is pending, and stop
+    // reading requests from a client that is not consuming its replies.
+    uint32_t wanted = 0;
+    if (!client.closing && !client.eof && !client.awaiting_commit) {
+        wanted |= EPOLLRDHUP;
+        if (client.out_bytes < IPC_OUTPUT_HIGH_WATER) {
+            wanted |= EPOLLIN;
+        }
+    }
+    if (client.out_bytes > 0) {
+        wanted |= EPOLLOUT;
+    }
+    // EPOLLHUP cannot be masked; edge-trigger it while a finished peer
+    // waits on the window manager so the reactor does not spin
+    if (client.eof) {
+        wanted |= EPOLLET;
+    }
     
-    thread_local char buffer[4096];
-    std::string command_buffer;
+    if (wanted == client.events) {
+        return;
+    }
     
-    while (running_.load()) {
-        ssize_t n = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
+    epoll_event ev{};
+    ev.events = wanted;
+    ev.data.fd = client.fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, client.fd, &ev) == 0) {
+        client.events = wanted;
+    }
+}
+
+void IPCServer::closeClient(int fd) {
+    auto it = clients_.find(fd);
+    if (it != clients_.end() && it->second->topics != 0) {
+        setTopics(*it->second, 0);
+    }
+    
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    clients_.erase(fd);
+}
+
+void IPCServer::drainEvents() {
+    std::vector<std::shared_ptr<const IPCEvent>> batch;
+    while (auto event = event_queue_.pop()) {
+        batch.push_back(std::move(*event));
+    }
+    
+    if (batch.empty() || subscribers_.empty()) {
+        return;
+    }
+    
+    std::vector<int> dead;
+    for (IPCClient* client : subscribers_) {
+        if (client->closing || client->eof) {
+            continue;
+        }
         
-        if (n <= 0) {
-            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                continue;
+        bool queued = false;
+        for (const auto& event : batch) {
+            if (client->topics & static_cast<uint32_t>(event->topic)) {
+                client->pending_events->push(event);
+                queued = true;
             }
-            break;
         }
         
-        buffer[n] = '\0';
-        command_buffer += buffer;
+        if (!queued) {
+            continue;
+        }
+        if (!deliver(*client)) {
+            dead.push_back(client->fd);
+            continue;
+        }
+        updateInterest(*client);
+    }
+    
+    for (int fd : dead) {
+        closeClient(fd);
+    }
+}
+
+void IPCServer::drainCompletions() {
+    while (auto completed = completions_.pop()) {
+        std::unique_ptr<IPCTransaction> transaction = std::move(*completed);
         
+        auto it = clients_.find(transaction->client_fd);
+        if (it == clients_.end() || it->second->serial != transaction->client_serial) {
+            continue;
+        }
+        IPCClient& client = *it->second;
         
-        size_t pos;
-        while ((pos = command_buffer.find('\n')) != std::string::npos) {
-            std::string command = command_buffer.substr(0, pos);
-            command_buffer = command_buffer.substr(pos + 1);
-            
-            if (!command.empty()) {
-                IPCResponse response = processCommand(command);
-                sendResponse(client_fd, response);
-            }
+        // Answer the parked request by running it again, with the window
+        // manager's results standing in for its state-changing commands.
+        std::string request = std::move(client.deferred_request);
+        client.awaiting_commit = false;
+        replaying_ = transaction.get();
+        replay_index_ = 0;
+        if (client.deferred_frame) {
+            processFrame(client, client.deferred_header, request);
+        } else {
+            processLine(client, request);
         }
+        replaying_ = nullptr;
+        
+        processInput(client);
+        settleClient(client, flushClient(client));
+    }
+}
+
+void IPCServer::pumpEvents(IPCClient& client) {
+    if (!client.pending_events) {
+        return;
     }
     
+    // Events stay in the bounded ring until the socket has room, which is
+    // where coalescing and dropping happen for slow consumers.
+    auto emit = [&](std::string_view line) {
+        if (client.binary) {
+            line.remove_suffix(line.ends_with('\n') ? 1 : 0);
+            queueFrame(client, 0, IPCOpcode::Event, IPCStatus::Ok, line.data(), line.size());
+        } else {
+            queueOutput(client, std::string(line));
+        }
+    };
     
-    {
-        std::lock_guard<std::mutex> lock(client_mutex_);
-        client_fds_.erase(
-            std::remove(client_fds_.begin(), client_fds_.end(), client_fd),
-            client_fds_.end()
-        );
+    while (!client.pending_events->empty() && client.out_bytes < IPC_EVENT_LOW_WATER) {
+        if (size_t dropped = client.pending_events->takeDropped()) {
+            json_.clear();
+            json_.append("EVENT|overflow|");
+            json_.beginObject().key("dropped").value(dropped).endObject();
+            json_.append("\n");
+            emit(json_.view());
+        }
+        emit(client.pending_events->pop()->line);
     }
+}
+
+bool IPCServer::deliver(IPCClient& client) {
+    if (!flushClient(client)) {
+        return false;
+    }
+    if (!client.pending_events || client.pending_events->empty() ||
+        client.out_bytes >= IPC_EVENT_LOW_WATER) {
+        return true;
+    }
+    pumpEvents(client);
+    return flushClient(client);
+}
+
+void IPCServer::setTopics(IPCClient& client, uint32_t topics) {
+    const bool was_subscribed = client.topics != 0;
+    client.topics = topics;
     
-    
-    {
-        std::lock_guard<std::mutex> lock(subscriber_mutex_);
-        subscribers_.erase(
-            std::remove(subscribers_.begin(), subscribers_.end(), client_fd),
-            subscribers_.end()
-        );
+    if (topics != 0 && !was_subscribed) {
+        if (!client.pending_events) {
+            client.pending_events = std::make_unique<IPCEventQueue>();
+        }
+        subscribers_.push_back(&client);
+    } else if (topics == 0 && was_subscribed) {
+        subscribers_.erase(std::remove(subscribers_.begin(), subscribers_.end(), &client),
+                           subscribers_.end());
+        client.pending_events.reset();
     }
     
-    close(client_fd);
+    uint32_t mask = 0;
+    for (const IPCClient* sub : subscribers_) {
+        mask |= sub->topics;
+    }
+    subscribed_topics_.store(mask, std::memory_order_relaxed);
 }
 
-IPCResponse IPCServer::processCommand(const std::string& command) {
+size_t IPCServer::processLines(IPCClient& client, size_t start) {
+    size_t pos;
+    while (!client.closing && !client.awaiting_commit &&
+           (pos = client.in.find('\n', start)) != std::string::npos) {
+        std::string_view line(client.in.data() + start, pos - start);
+        start = pos + 1;
+        
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.empty()) {
+            continue;
+        }
+        
+        if (line == "protocol binary") {
+            json_.clear();
+            json_.beginObject()
+                 .key("version").value(IPC_BINARY_PROTOCOL_VERSION)
+                 .key("header_size").value(sizeof(IPCFrameHeader))
+                 .endObject();
+            queueResponse(client, IPCResponse::ok("Binary protocol", json_.str()));
+            client.binary = true;
+            break;
+        }
+        
+        processLine(client, line);
+    }
+    return start;
+}
+
+void IPCServer::processLine(IPCClient& client, std::string_view line) {
+    if (line.front() == '{' || line.front() == '[') {
+        bool respond = processJSONRPC(client, line, rpc_json_);
+        if (deferRequest(client, line, nullptr)) {
+            return;
+        }
+        if (respond) {
+            rpc_json_.append("\n");
+            queueOutput(client, rpc_json_.str());
+        }
+        return;
+    }
     
-    if (command.find("{") == 0) {
-        return processJSONRPC(command);
+    IPCResponse response = processCommand(client, line);
+    if (!deferRequest(client, line, nullptr)) {
+        queueResponse(client, response);
     }
+}
+
+size_t IPCServer::processFrames(IPCClient& client, size_t start) {
+    while (!client.closing && !client.awaiting_commit &&
+           client.in.size() - start >= sizeof(IPCFrameHeader)) {
+        IPCFrameHeader header;
+        std::memcpy(&header, client.in.data() + start, sizeof(header));
+        
+        if (header.length > IPC_MAX_REQUEST_SIZE) {
+            static constexpr std::string_view msg = "Frame too large";
+            queueFrame(client, header.request_id, static_cast<IPCOpcode>(header.opcode),
+                       IPCStatus::Error, msg.data(), msg.size());
+            client.closing = true;
+            return client.in.size();
+        }
+        
+        if (client.in.size() - start - sizeof(header) < header.length) {
+            break;
+        }
+        
+        processFrame(client, header,
+                     std::string_view(client.in.data() + start + sizeof(header), header.length));
+        start += sizeof(header) + header.length;
+    }
+    return start;
+}
+
+void IPCServer::processFrame(IPCClient& client, const IPCFrameHeader& header, std::string_view payload) {
+    const auto opcode = static_cast<IPCOpcode>(header.opcode);
+    const uint32_t id = header.request_id;
+    auto state = currentState();
     
+    auto reply = [&](const void* data, size_t length) {
+        queueFrame(client, id, opcode, IPCStatus::Ok, data, length);
+    };
+    auto fail = [&](std::string_view message) {
+        queueFrame(client, id, opcode, IPCStatus::Error, message.data(), message.size());
+    };
     
+    switch (opcode) {
+        case IPCOpcode::Ping:
+            reply(payload.data(), payload.size());
+            return;
+            
+        case IPCOpcode::GetWorkspaces:
+            if (!state) return reply(nullptr, 0);
+            reply(state->workspaces.data(), state->workspaces.size() * sizeof(IPCWorkspaceRecord));
+            return;
+            
+        case IPCOpcode::GetWindows:
+            if (!state) return reply(nullptr, 0);
+            reply(state->windows.data(), state->windows.size() * sizeof(IPCWindowRecord));
+            return;
+            
+        case IPCOpcode::GetWindow: {
+            uint64_t window = 0;
+            if (payload.size() != sizeof(window)) {
+                return fail("GetWindow expects a 64-bit window id");
+            }
+            std::memcpy(&window, payload.data(), sizeof(window));
+            const IPCWindowRecord* record = state ? state->findWindow(static_cast<Window>(window)) : nullptr;
+            if (!record) {
+                return fail("No such window");
+            }
+            reply(record, sizeof(*record));
+            return;
+        }
+            
+        case IPCOpcode::GetFocused: {
+            const IPCWindowRecord* record = state ? state->findWindow(state->focused) : nullptr;
+            reply(record, record ? sizeof(*record) : 0);
+            return;
+        }
+            
+        case IPCOpcode::GetMonitors:
+            if (!state) return reply(nullptr, 0);
+            reply(state->monitors.data(), state->monitors.size() * sizeof(IPCMonitorRecord));
+            return;
+            
+        case IPCOpcode::GetLayout:
+            if (!state) return reply(nullptr, 0);
+            reply(state->layout.data(), state->layout.size());
+            return;
+            
+        case IPCOpcode::Command: {
+            if (payload.empty()) {
+                return fail("Empty command");
+            }
+            if (payload.front() == '{' || payload.front() == '[') {
+                bool respond = processJSONRPC(client, payload, rpc_json_);
+                if (!deferRequest(client, payload, &header)) {
+                    reply(rpc_json_.str().data(), respond ? rpc_json_.str().size() : 0);
+                }
+                return;
+            }
+            IPCResponse response = processCommand(client, payload);
+            if (deferRequest(client, payload, &header)) {
+                return;
+            }
+            if (!response.success) {
+                return fail(response.message);
+            }
+            const std::string& text = response.data.empty() ? response.message : response.data;
+            reply(text.data(), text.size());
+            return;
+        }
+            
+        case IPCOpcode::Event:
+            break;
+    }
+    
+    fail("Unknown opcode");
+}
+
+IPCResponse IPCServer::processCommand(IPCClient& client, std::string_view command) {
     auto args = parseCommand(command);
     
     if (args.empty()) {
-        return IPCResponse::error("Empty command");
+        return IPCResponse::error("Empty command", IPC_ERROR_INVALID_REQUEST);
     }
     
     const std::string& cmd = args[0];
-    return processLegacyCommand(cmd, args);
+    return runCommand(client, cmd, args);
 }
 
+bool IPCServer::isReactorCommand(const std::string& cmd, const std::vector<std::string>& args) const {
+    if (cmd == "workspaces" || cmd == "windows" || cmd == "focused" || cmd == "window" ||
+        cmd == "monitors" || cmd == "config" || cmd == "subscribe" || cmd == "unsubscribe" ||
+        cmd == "help" || cmd == "batch") {
+        return true;
+    }
+    // Bare `workspace`, `focus` and `layout` are queries; with arguments
+    // they are window manager actions.
+    if (cmd == "workspace" || cmd == "focus" || cmd == "layout") {
+        return std::all_of(args.begin() + 1, args.end(), isGenerationArg);
+    }
+    return false;
+}
 
+IPCResponse IPCServer::runCommand(IPCClient& client, const std::string& cmd, const std::vector<std::string>& args) {
+    if (isReactorCommand(cmd, args)) {
+        return processLegacyCommand(client, cmd, args);
+    }
+    
+    if (replaying_) {
+        if (replay_index_ < replaying_->results.size()) {
+            return replaying_->results[replay_index_++];
+        }
+        return IPCResponse::error("Missing transaction result", IPC_ERROR_INTERNAL);
+    }
+    
+    if (accept_transactions_.load(std::memory_order_acquire)) {
+        // The reply written for this pass is discarded; deferRequest() parks
+        // the request and it is answered again once the commit is done.
+        if (!staged_) {
+            staged_ = std::make_unique<IPCTransaction>();
+        }
+        staged_->commands.push_back(args);
+        return IPCResponse::ok("Queued");
+    }
+    
+    if (command_callback_) {
+        command_callback_(cmd, std::vector<std::string>(args.begin() + 1, args.end()));
+        return IPCResponse::ok("Command executed");
+    }
+    return IPCResponse::error("Unknown command: " + cmd, IPC_ERROR_METHOD_NOT_FOUND);
+}
 
+IPCResponse IPCServer::processBatch(IPCClient& client, const std::vector<std::string>& args) {
+    std::string joined;
+    for (size_t i = 1; i < args.size(); ++i) {
+        joined.append(args[i]).append(" ");
+    }
+    
+    JSONWriter out;
+    out.beginObject().key("results").beginArray();
+    size_t count = 0;
+    size_t failed = 0;
+    
+    size_t start = 0;
+    while (start < joined.size()) {
+        size_t end = joined.find(';', start);
+        if (end == std::string::npos) {
+            end = joined.size();
+        }
+        auto command = parseCommand(std::string_view(joined).substr(start, end - start));
+        start = end + 1;
+        if (command.empty()) {
+            continue;
+        }
+        
+        IPCResponse result = command[0] == "batch"
+            ? IPCResponse::error("Nested batch", IPC_ERROR_INVALID_PARAMS)
+            : runCommand(client, command[0], command);
+        ++count;
+        failed += result.success ? 0 : 1;
+        
+        out.beginObject().key("success").value(result.success).key("message").value(result.message);
+        if (!result.success) {
+            out.key("code").value(result.code);
+        } else if (!result.data.empty()) {
+            out.key("data").raw(result.data);
+        }
+        out.endObject();
+    }
+    out.endArray().endObject();
+    
+    if (count == 0) {
+        return IPCResponse::error("Usage: batch <command> [; <command>...]", IPC_ERROR_INVALID_PARAMS);
+    }
+    return IPCResponse::ok(failed ? "Batch applied with errors" : "Batch applied", out.str());
+}
 
+bool IPCServer::deferRequest(IPCClient& client, std::string_view request, const IPCFrameHeader* header) {
+    if (!staged_ || staged_->commands.empty()) {
+        return false;
+    }
+    
+    staged_->client_fd = client.fd;
+    staged_->client_serial = client.serial;
+    client.awaiting_commit = true;
+    client.deferred_frame = header != nullptr;
+    if (header) {
+        client.deferred_header = *header;
+    }
+    client.deferred_request.assign(request);
+    transactions_.push(std::move(staged_));
+    return true;
+}
 
-IPCResponse IPCServer::processJSONRPC(const std::string& json) {
+bool IPCServer::processJSONRPC(IPCClient& client, std::string_view json, JSONWriter& out) {
+    using Token = JSONReader::Token;
+    out.clear();
     
+    // Validate the whole document first so a malformed batch is rejected
+    // before any of its commands run.
+    {
+        JSONReader validator(json);
+        Token t;
+        while ((t = validator.next()) != Token::End) {
+            if (t == Token::Error) {
+                writeRPCError(out, {}, IPC_ERROR_PARSE, "Parse error");
+                return true;
+            }
+        }
+    }
     
+    JSONReader reader(json);
+    Token first = reader.next();
     
+    if (first == Token::BeginObject) {
+        return processRPCRequest(client, reader, out);
+    }
     
-    size_t method_start = json.find("\"method\"");
-    if (method_start == std::string::npos) {
-        return IPCResponse::error("Invalid JSON-RPC: missing method");
+    if (first != Token::BeginArray) {
+        writeRPCError(out, {}, IPC_ERROR_INVALID_REQUEST, "Invalid Request");
+        return true;
     }
     
-    size_t method_colon = json.find(":", method_start);
-    if (method_colon == std::string::npos) {
-        return IPCResponse::error("Invalid JSON-RPC: malformed method");
+    out.beginArray();
+    size_t requests = 0;
+    size_t responses = 0;
+    for (Token t = reader.next(); t != Token::EndArray; t = reader.next()) {
+        ++requests;
+        if (t != Token::BeginObject) {
+            reader.skipValue(t);
+            writeRPCError(out, {}, IPC_ERROR_INVALID_REQUEST, "Invalid Request");
+            ++responses;
+            continue;
+        }
+        if (processRPCRequest(client, reader, out)) {
+            ++responses;
+        }
     }
+    out.endArray();
     
-    size_t method_quote_start = json.find("\"", method_colon + 1);
-    size_t method_quote_end = json.find("\"", method_quote_start + 1);
-    if (method_quote_start == std::string::npos || method_quote_end == std::string::npos) {
-        return IPCResponse::error("Invalid JSON-RPC: method must be string");
+    if (requests == 0) {
+        out.clear();
+        writeRPCError(out, {}, IPC_ERROR_INVALID_REQUEST, "Invalid Request");
+        return true;
+    }
+    if (responses == 0) {
+        out.clear();
+        return false;
     }
+    return true;
+}
+
+bool IPCServer::processRPCRequest(IPCClient& client, JSONReader& reader, JSONWriter& out) {
+    using Token = JSONReader::Token;
     
-    std::string method = json.substr(method_quote_start + 1, method_quote_end - method_quote_start - 1);
+    std::string_view id;
+    bool has_id = false;
+    bool valid = true;
+    bool params_ok = true;
+    bool has_method = false;
     
+    rpc_args_.clear();
+    rpc_args_.emplace_back();
     
-    std::vector<std::string> params;
-    size_t params_start = json.find("\"params\"");
-    if (params_start != std::string::npos) {
-        size_t params_bracket = json.find("[", params_start);
-        size_t params_end = json.find("]", params_bracket);
-        if (params_bracket != std::string::npos && params_end != std::string::npos) {
-            std::string params_str = json.substr(params_bracket + 1, params_end - params_bracket - 1);
-            size_t pos = 0;
-            while (pos < params_str.size()) {
-                size_t next_comma = params_str.find(",", pos);
-                std::string param = params_str.substr(pos, next_comma - pos);
-                param.erase(remove_if(param.begin(), param.end(), ::isspace), param.end());
-                if (param.front() == '"' && param.back() == '"') {
-                    param = param.substr(1, param.size() - 2);
-                }
-                if (!param.empty()) {
-                    params.push_back(param);
-                }
-                if (next_comma == std::string::npos) break;
-                pos = next_comma + 1;
+    for (Token t = reader.next(); t != Token::EndObject; t = reader.next()) {
+        std::string_view key = reader.text();
+        bool plain_key = !reader.hasEscapes();
+        Token value = reader.next();
+        
+        if (plain_key && key == "jsonrpc") {
+            valid &= value == Token::String && reader.textEquals("2.0");
+            reader.skipValue(value);
+        } else if (plain_key && (key == "method" || key == "command")) {
+            if (value == Token::String) {
+                rpc_method_.clear();
+                JSONReader::unescape(reader.text(), rpc_method_);
+                has_method = true;
+            } else {
+                valid = false;
+                reader.skipValue(value);
+            }
+        } else if (plain_key && (key == "params" || key == "args")) {
+            params_ok = collectRPCParams(reader, value);
+        } else if (plain_key && key == "id") {
+            has_id = true;
+            id = reader.skipValue(value);
+            if (value != Token::String && value != Token::Number && value != Token::Null) {
+                valid = false;
+                id = {};
+            }
+        } else {
+            reader.skipValue(value);
+        }
+    }
+    
+    if (!valid || !has_method) {
+        writeRPCError(out, id, IPC_ERROR_INVALID_REQUEST, "Invalid Request");
+        return true;
+    }
+    if (!params_ok) {
+        if (!has_id) return false;
+        writeRPCError(out, id, IPC_ERROR_INVALID_PARAMS, "Invalid params");
+        return true;
+    }
+    
+    rpc_args_[0] = rpc_method_;
+    IPCResponse response = runCommand(client, rpc_method_, rpc_args_);
+    
+    // No id: a notification, which gets no reply even on failure
+    if (!has_id) {
+        return false;
+    }
+    
+    if (!response.success) {
+        writeRPCError(out, id, response.code ? response.code : IPC_ERROR_SERVER, response.message);
+        return true;
+    }
+    
+    out.beginObject().key("jsonrpc").value("2.0").key("result");
+    if (!response.data.empty()) {
+        out.raw(response.data);
+    } else {
+        out.beginObject().key("message").value(response.message).endObject();
+    }
+    out.key("id").raw(id);
+    out.endObject();
+    return true;
+}
+
+bool IPCServer::collectRPCParams(JSONReader& reader, JSONReader::Token first) {
+    using Token = JSONReader::Token;
+    
+    if (first == Token::BeginArray) {
+        for (Token t = reader.next(); t != Token::EndArray; t = reader.next()) {
+            appendRPCParam(reader, t, true);
+        }
+        return true;
+    }
+    
+    if (first == Token::BeginObject) {
+        // Named params are passed positionally in document order, except
+        // if_generation which keeps its name
+        for (Token t = reader.next(); t != Token::EndObject; t = reader.next()) {
+            bool generation = reader.textEquals("if_generation");
+            Token value = reader.next();
+            if (generation && value == Token::Number) {
+                rpc_args_.emplace_back("if_generation=").append(reader.text());
+                continue;
             }
+            appendRPCParam(reader, value, true);
         }
+        return true;
     }
     
+    reader.skipValue(first);
+    return first == Token::Null;
+}
+
+void IPCServer::appendRPCParam(JSONReader& reader, JSONReader::Token token, bool flatten) {
+    using Token = JSONReader::Token;
     
-    return processLegacyCommand(method, params);
+    switch (token) {
+        case Token::String:
+            rpc_args_.emplace_back();
+            JSONReader::unescape(reader.text(), rpc_args_.back());
+            return;
+            
+        case Token::Number:
+        case Token::Boolean:
+        case Token::Null:
+            rpc_args_.emplace_back(reader.text());
+            return;
+            
+        case Token::BeginArray:
+            if (flatten) {
+                // ["workspace", "focus"] as a single param expands to two args
+                for (Token t = reader.next(); t != Token::EndArray; t = reader.next()) {
+                    appendRPCParam(reader, t, false);
+                }
+                return;
+            }
+            [[fallthrough]];
+            
+        default:
+            // Deeper structure is handed on verbatim as JSON text
+            rpc_args_.emplace_back(reader.skipValue(token));
+            return;
+    }
+}
+
+void IPCServer::writeRPCError(JSONWriter& out, std::string_view id, int code, std::string_view message) {
+    out.beginObject()
+       .key("jsonrpc").value("2.0")
+       .key("error").beginObject()
+           .key("code").value(code)
+           .key("message").value(message)
+       .endObject()
+       .key("id");
+    if (id.empty()) {
+        out.null();
+    } else {
+        out.raw(id);
+    }
+    out.endObject();
 }
 
-IPCResponse IPCServer::processLegacyCommand(const std::string& cmd, const std::vector<std::string>& args) {
+IPCResponse IPCServer::processLegacyCommand(IPCClient& client, const std::string& cmd, const std::vector<std::string>& args) {
     try {
+        json_.clear();
+        
         if (cmd == "workspaces" || cmd == "workspace") {
-            return IPCResponse::ok("Workspaces retrieved", getWorkspacesJSON());
+            return queryFacet(IPCFacet::Workspaces, "Workspaces retrieved", args);
         }
-        else if (cmd == "focused" || cmd == "focus") {
-            return IPCResponse::ok("Focused window", 
-                "{ \"window_id\": " + std::to_string(0) + " }");
+        else if (cmd == "windows") {
+            return queryFacet(IPCFacet::Clients, "Windows retrieved", args);
         }
-        else if (cmd == "window") {
-            if (args.size() < 2) {
-                return IPCResponse::error("Usage: window <window_id>");
-            }
-            Window w = static_cast<Window>(std::stoll(args[1]));
-            return IPCResponse::ok("Window info", getWindowInfoJSON(w));
+        else if (cmd == "focused" || cmd == "focus") {
+            return queryFacet(IPCFacet::Focus, "Focused window", args);
         }
         else if (cmd == "layout") {
-            return IPCResponse::ok("Layout mode", getLayoutModeJSON());
+            return queryFacet(IPCFacet::Layout, "Layout mode", args);
         }
-        else if (cmd == "subscribe") {
-            return IPCResponse::ok("Subscribed", "{ \"subscribed\": true }");
+        else if (cmd == "monitors") {
+            return queryFacet(IPCFacet::Monitors, "Monitors retrieved", args);
         }
-        else if (cmd == "unsubscribe") {
-            return IPCResponse::ok("Unsubscribed", "{ \"subscribed\": false }");
+        else if (cmd == "config") {
+            if (!config_writer_) {
+                return IPCResponse::error("Configuration not available");
+            }
+            config_writer_(json_);
+            return IPCResponse::ok("Config retrieved", json_.str());
         }
-        else if (cmd == "reload" || cmd == "restart") {
-            return IPCResponse::ok("Command sent", "{ \"action\": \"reload\" }");
+        else if (cmd == "window") {
+            Window w = None;
+            auto id = std::find_if(args.begin() + 1, args.end(),
+                                   [](const std::string& arg) { return !isGenerationArg(arg); });
+            if (id == args.end() || !parseWindowId(*id, w)) {
+                return IPCResponse::error("Usage: window <window_id>", IPC_ERROR_INVALID_PARAMS);
+            }
+            auto state = currentState();
+            if (isUnchanged(args, state.get(), IPCFacet::Clients)) {
+                return unchangedResponse(json_, state->generation(IPCFacet::Clients));
+            }
+            writeWindowInfoJSON(json_, state.get(), w, state ? state->generation(IPCFacet::Clients) : 0);
+            return IPCResponse::ok("Window info", json_.str());
         }
-        else if (cmd == "quit" || cmd == "exit") {
-            return IPCResponse::ok("Command sent", "{ \"action\": \"quit\" }");
+        else if (cmd == "subscribe" || cmd == "unsubscribe") {
+            uint32_t requested = 0;
+            for (size_t i = 1; i < args.size(); ++i) {
+                auto topic = ipcEventTopicFromString(args[i]);
+                if (!topic) {
+                    return IPCResponse::error("Unknown event topic: " + args[i], IPC_ERROR_INVALID_PARAMS);
+                }
+                requested |= static_cast<uint32_t>(*topic);
+            }
+            if (args.size() <= 1) {
+                requested = static_cast<uint32_t>(IPCEventTopic::All);
+            }
+            
+            bool subscribe = cmd == "subscribe";
+            setTopics(client, subscribe ? (client.topics | requested) : (client.topics & ~requested));
+            json_.beginObject().key("subscribed");
+            writeTopicList(json_, client.topics);
+            json_.endObject();
+            return IPCResponse::ok(subscribe ? "Subscribed" : "Unsubscribed", json_.str());
+        }
+        else if (cmd == "batch") {
+            return processBatch(client, args);
         }
         else if (cmd == "help") {
-            std::string help = R"({
-                "jsonrpc": "2.0",
-                "commands": [
-                    {"name": "workspace", "desc": "Get workspace list", "params": []},
-                    {"name": "focused", "desc": "Get focused window", "params": []},
-                    {"name": "window", "desc": "Get window info", "params": ["window_id"]},
-                    {"name": "layout", "desc": "Get current layout", "params": []},
-                    {"name": "subscribe", "desc": "Subscribe to events", "params": []},
-                    {"name": "reload", "desc": "Reload configuration", "params": []},
-                    {"name": "quit", "desc": "Exit window manager", "params": []},
-                    {"name": "help", "desc": "Show this help", "params": []}
-                ]
-            })";
-            return IPCResponse::ok("Help", help);
+            struct HelpEntry { const char* name; const char* desc; const char* param; };
+            static constexpr HelpEntry HELP[] = {
+                {"workspace",   "Get workspace list", nullptr},
+                {"windows",     "Get all managed windows", nullptr},
+                {"focused",     "Get focused window", nullptr},
+                {"window",      "Get window info", "window_id"},
+                {"layout",      "Get current layout", nullptr},
+                {"monitors",    "Get monitor list", nullptr},
+                {"config",      "Get active configuration", nullptr},
+                {"subscribe",   "Subscribe to events: workspace, focus, title, layout, window, monitor, all", "topic..."},
+                {"unsubscribe", "Unsubscribe from events, all when no topic is given", "topic..."},
+                {"batch",       "Apply ;-separated commands in one commit, with per-command results", "command..."},
+                {"reload",      "Reload configuration", nullptr},
+                {"quit",        "Exit window manager", nullptr},
+                {"protocol",    "Switch this connection to binary framing", "binary"},
+                {"help",        "Show this help", nullptr}
+            };
+            
+            // Single line: replies are newline-delimited
+            json_.beginObject().key("jsonrpc").value("2.0").key("commands").beginArray();
+            for (const auto& entry : HELP) {
+                json_.beginObject()
+                     .key("name").value(entry.name)
+                     .key("desc").value(entry.desc)
+                     .key("params").beginArray();
+                if (entry.param) json_.value(entry.param);
+                json_.endArray().endObject();
+            }
+            json_.endArray().endObject();
+            return IPCResponse::ok("Help", json_.str());
         }
         else {
-            if (command_callback_) {
-                command_callback_(cmd, std::vector<std::string>(args.begin() + 1, args.end()));
-                return IPCResponse::ok("Command executed");
-            }
-            return IPCResponse::error("Unknown command: " + cmd);
+            return IPCResponse::error("Unknown command: " + cmd, IPC_ERROR_METHOD_NOT_FOUND);
         }
     }
     catch (const std::exception& e) {
-        return IPCResponse::error(std::string("Error: ") + e.what());
+        return IPCResponse::error(std::string("Error: ") + e.what(), IPC_ERROR_INTERNAL);
     }
 }
 
-std::string IPCServer::getWorkspacesJSON() const {
-    return R"({"workspaces": []})";
+IPCResponse IPCServer::queryFacet(IPCFacet facet, const char* message, const std::vector<std::string>& args) {
+    auto state = currentState();
+    if (isUnchanged(args, state.get(), facet)) {
+        return unchangedResponse(json_, state->generation(facet));
+    }
+    return IPCResponse::ok(message, facetJSON(facet, state.get()));
 }
 
-std::string IPCServer::getWindowInfoJSON(Window w) const {
-    std::ostringstream ss;
-    ss << R"({"window_id": )" << w << R"(, "title": "", "class": "", "workspace": 0})";
-    return ss.str();
+const std::string& IPCServer::facetJSON(IPCFacet facet, const IPCStateSnapshot* state) {
+    // Generations only move when content does, so a matching generation
+    // means the cached serialization is still exact.
+    FacetCache& cache = facet_cache_[static_cast<size_t>(facet)];
+    const uint64_t generation = state ? state->generation(facet) : 0;
+    
+    if (!cache.valid || cache.generation != generation) {
+        json_.clear();
+        writeFacetJSON(json_, facet, state);
+        cache.json = json_.str();
+        cache.generation = generation;
+        cache.valid = true;
+    }
+    return cache.json;
 }
 
-std::string IPCServer::getLayoutModeJSON() const {
-    return R"({"layout": "bsp"})";
+void IPCServer::writeFacetJSON(JSONWriter& out, IPCFacet facet, const IPCStateSnapshot* state) const {
+    const uint64_t generation = state ? state->generation(facet) : 0;
+    
+    switch (facet) {
+        case IPCFacet::Workspaces:
+            out.beginObject().key("generation").value(generation).key("workspaces").beginArray();
+            if (state) {
+                for (const auto& ws : state->workspaces) {
+                    out.beginObject()
+                       .key("workspace").value(ws.workspace)
+                       .key("windows").value(ws.window_count)
+                       .key("monitor").value(ws.monitor)
+                       .key("current").value((ws.flags & IPC_WORKSPACE_CURRENT) != 0)
+                       .key("layout").value(ws.layout)
+                       .endObject();
+                }
+            }
+            out.endArray().endObject();
+            return;
+            
+        case IPCFacet::Clients:
+            out.beginObject().key("generation").value(generation).key("windows").beginArray();
+            if (state) {
+                for (const auto& record : state->windows) {
+                    writeWindowInfoJSON(out, state, static_cast<Window>(record.window));
+                }
+            }
+            out.endArray().endObject();
+            return;
+            
+        case IPCFacet::Focus:
+            if (state && state->focused != None) {
+                writeWindowInfoJSON(out, state, state->focused, generation);
+            } else {
+                out.beginObject().key("generation").value(generation).key("window_id").value(0).endObject();
+            }
+            return;
+            
+        case IPCFacet::Layout:
+            out.beginObject()
+               .key("generation").value(generation)
+               .key("layout").value((state && !state->layout.empty()) ? std::string_view(state->layout) : "bsp")
+               .endObject();
+            return;
+            
+        case IPCFacet::Monitors:
+            out.beginObject().key("generation").value(generation).key("monitors").beginArray();
+            if (state) {
+                for (const auto& mon : state->monitors) {
+                    out.beginObject()
+                       .key("monitor").value(mon.monitor)
+                       .key("name").value(mon.name)
+                       .key("x").value(mon.x)
+                       .key("y").value(mon.y)
+                       .key("width").value(mon.width)
+                       .key("height").value(mon.height)
+                       .key("primary").value((mon.flags & IPC_MONITOR_PRIMARY) != 0)
+                       .endObject();
+                }
+            }
+            out.endArray().endObject();
+            return;
+            
+        case IPCFacet::Count:
+            break;
+    }
+    out.null();
+}
+
+void IPCServer::writeWindowInfoJSON(JSONWriter& out, const IPCStateSnapshot* state, Window w,
+                                    uint64_t generation) const {
+    const IPCWindowRecord* record = state ? state->findWindow(w) : nullptr;
+    
+    out.beginObject();
+    if (generation != 0) {
+        out.key("generation").value(generation);
+    }
+    
+    if (!record) {
+        out.key("window_id").value(w)
+           .key("title").value("")
+           .key("class").value("")
+           .key("workspace").value(0)
+           .endObject();
+        return;
+    }
+    
+    out.key("window_id").value(record->window)
+       .key("title").value(record->title)
+       .key("class").value(record->wm_class)
+       .key("workspace").value(record->workspace)
+       .key("x").value(record->x)
+       .key("y").value(record->y)
+       .key("width").value(record->width)
+       .key("height").value(record->height)
+       .key("floating").value((record->flags & IPC_WINDOW_FLOATING) != 0)
+       .key("fullscreen").value((record->flags & IPC_WINDOW_FULLSCREEN) != 0)
+       .key("focused").value((record->flags & IPC_WINDOW_FOCUSED) != 0)
+       .endObject();
 }
 
-bool IPCServer::sendResponse(int fd, const IPCResponse& response) {
+void IPCServer::queueResponse(IPCClient& client, const IPCResponse& response) {
     std::string output;
     
     if (response.success) {
-        output = "OK|" + response.message + "|" + response.data + "\n";
+        output.reserve(response.message.size() + response.data.size() + 5);
+        output.append("OK|").append(response.message).append("|").append(response.data).append("\n");
     } else {
-        output = "ERROR|" + response.message + "\n";
+        output.reserve(response.message.size() + 7);
+        output.append("ERROR|").append(response.message).append("\n");
     }
     
+    queueOutput(client, std::move(output));
+}
+
+void IPCServer::queueFrame(IPCClient& client, uint32_t request_id, IPCOpcode opcode,
+                           IPCStatus status, const void* payload, size_t length) {
+    IPCFrameHeader header;
+    header.length = static_cast<uint32_t>(length);
+    header.request_id = request_id;
+    header.opcode = static_cast<uint16_t>(opcode);
+    header.status = static_cast<uint16_t>(status);
     
-    const char* ptr = output.c_str();
-    size_t remaining = output.size();
-    
-    while (remaining > 0) {
-        ssize_t sent = send(fd, ptr, remaining, 0);
-        
-        if (sent < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
-                continue;
-            }
-            return false;
-        }
-        
-        if (sent == 0) {
-            return false;
-        }
-        
-        ptr += sent;
-        remaining -= sent;
+    std::string frame;
+    frame.resize(sizeof(header) + length);
+    std::memcpy(frame.data(), &header, sizeof(header));
+    if (length > 0) {
+        std::memcpy(frame.data() + sizeof(header), payload, length);
     }
-    
-    return true;
+    queueOutput(client, std::move(frame));
+}
+
+void IPCServer::queueOutput(IPCClient& client, std::string data) {
+    if (data.empty()) {
+        return;
+    }
+    client.out_bytes += data.size();
+    client.out.push_back(std::move(data));
 }
 
-std::vector<std::string> IPCServer::parseCommand(const std::string& input) const {
+std::vector<std::string> IPCServer::parseCommand(std::string_view input) const {
     std::vector<std::string> args;
-    std::istringstream iss(input);
+    std::istringstream iss{std::string(input)};
     std::string arg;
     
     while (iss >> arg) {
@@ -0,0 +1,462 @@
+#include "pointblank/ipc/JSON.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace pblank {
+
+namespace {
+
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+inline int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void appendUTF8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+uint32_t readHex4(std::string_view s, size_t at) {
+    uint32_t v = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        v = (v << 4) | static_cast<uint32_t>(hexValue(s[at + i]));
+    }
+    return v;
+}
+
+}
+
+
+
+
+
+void JSONReader::skipWhitespace() {
+    while (pos_ < in_.size()) {
+        char c = in_[pos_];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        ++pos_;
+    }
+}
+
+bool JSONReader::scanString() {
+    // pos_ is on the opening quote
+    size_t start = ++pos_;
+    has_escapes_ = false;
+
+    while (pos_ < in_.size()) {
+        unsigned char c = static_cast<unsigned char>(in_[pos_]);
+        if (c == '"') {
+            text_ = in_.substr(start, pos_ - start);
+            ++pos_;
+            return true;
+        }
+        if (c < 0x20) {
+            return false;
+        }
+        if (c == '\\') {
+            has_escapes_ = true;
+            if (++pos_ >= in_.size()) {
+                return false;
+            }
+            switch (in_[pos_]) {
+                case '"': case '\\': case '/': case 'b':
+                case 'f': case 'n': case 'r': case 't':
+                    break;
+                case 'u':
+                    if (pos_ + 4 >= in_.size()) {
+                        return false;
+                    }
+                    for (size_t i = 1; i <= 4; ++i) {
+                        if (hexValue(in_[pos_ + i]) < 0) {
+                            return false;
+                        }
+                    }
+                    pos_ += 4;
+                    break;
+                default:
+                    return false;
+            }
+        }
+        ++pos_;
+    }
+    return false;
+}
+
+bool JSONReader::scanNumber() {
+    size_t start = pos_;
+
+    if (in_[pos_] == '-') {
+        ++pos_;
+    }
+    if (pos_ >= in_.size() || !isDigit(in_[pos_])) {
+        return false;
+    }
+    if (in_[pos_] == '0') {
+        ++pos_;
+    } else {
+        while (pos_ < in_.size() && isDigit(in_[pos_])) ++pos_;
+    }
+
+    if (pos_ < in_.size() && in_[pos_] == '.') {
+        ++pos_;
+        if (pos_ >= in_.size() || !isDigit(in_[pos_])) {
+            return false;
+        }
+        while (pos_ < in_.size() && isDigit(in_[pos_])) ++pos_;
+    }
+
+    if (pos_ < in_.size() && (in_[pos_] == 'e' || in_[pos_] == 'E')) {
+        ++pos_;
+        if (pos_ < in_.size() && (in_[pos_] == '+' || in_[pos_] == '-')) {
+            ++pos_;
+        }
+        if (pos_ >= in_.size() || !isDigit(in_[pos_])) {
+            return false;
+        }
+        while (pos_ < in_.size() && isDigit(in_[pos_])) ++pos_;
+    }
+
+    text_ = in_.substr(start, pos_ - start);
+    return true;
+}
+
+bool JSONReader::scanLiteral(std::string_view literal) {
+    if (in_.substr(pos_, literal.size()) != literal) {
+        return false;
+    }
+    text_ = in_.substr(pos_, literal.size());
+    pos_ += literal.size();
+    return true;
+}
+
+JSONReader::Token JSONReader::next() {
+    skipWhitespace();
+    token_start_ = pos_;
+
+    if (state_ == State::Done) {
+        return pos_ == in_.size() ? Token::End : fail();
+    }
+
+    if (state_ == State::AfterValue) {
+        if (depth_ == 0) {
+            state_ = State::Done;
+            return pos_ == in_.size() ? Token::End : fail();
+        }
+        if (pos_ >= in_.size()) {
+            return fail();
+        }
+
+        char c = in_[pos_];
+        bool object = inObject();
+        if (c == ',') {
+            ++pos_;
+            skipWhitespace();
+            token_start_ = pos_;
+            state_ = object ? State::Key : State::Value;
+        } else if (c == (object ? '}' : ']')) {
+            ++pos_;
+            --depth_;
+            return object ? Token::EndObject : Token::EndArray;
+        } else {
+            return fail();
+        }
+    }
+
+    if (pos_ >= in_.size()) {
+        return fail();
+    }
+    char c = in_[pos_];
+
+    if (state_ == State::KeyOrEnd) {
+        if (c == '}') {
+            ++pos_;
+            --depth_;
+            state_ = State::AfterValue;
+            return Token::EndObject;
+        }
+        state_ = State::Key;
+    } else if (state_ == State::ValueOrEnd) {
+        if (c == ']') {
+            ++pos_;
+            --depth_;
+            state_ = State::AfterValue;
+            return Token::EndArray;
+        }
+        state_ = State::Value;
+    }
+
+    if (state_ == State::Key) {
+        if (c != '"' || !scanString()) {
+            return fail();
+        }
+        skipWhitespace();
+        if (pos_ >= in_.size() || in_[pos_] != ':') {
+            return fail();
+        }
+        ++pos_;
+        state_ = State::Value;
+        return Token::Key;
+    }
+
+
+    switch (c) {
+        case '{':
+        case '[':
+            if (depth_ >= MAX_DEPTH) {
+                return fail();
+            }
+            ++pos_;
+            if (c == '{') {
+                object_bits_ |= (uint64_t{1} << depth_);
+            } else {
+                object_bits_ &= ~(uint64_t{1} << depth_);
+            }
+            ++depth_;
+            state_ = (c == '{') ? State::KeyOrEnd : State::ValueOrEnd;
+            return (c == '{') ? Token::BeginObject : Token::BeginArray;
+
+        case '"':
+            if (!scanString()) return fail();
+            state_ = State::AfterValue;
+            return Token::String;
+
+        case 't':
+            if (!scanLiteral("true")) return fail();
+            state_ = State::AfterValue;
+            return Token::Boolean;
+
+        case 'f':
+            if (!scanLiteral("false")) return fail();
+            state_ = State::AfterValue;
+            return Token::Boolean;
+
+        case 'n':
+            if (!scanLiteral("null")) return fail();
+            state_ = State::AfterValue;
+            return Token::Null;
+
+        default:
+            if (c == '-' || isDigit(c)) {
+                if (!scanNumber()) return fail();
+                state_ = State::AfterValue;
+                return Token::Number;
+            }
+            return fail();
+    }
+}
+
+std::string_view JSONReader::skipValue(Token first) {
+    size_t start = token_start_;
+
+    if (first == Token::BeginObject || first == Token::BeginArray) {
+        int target = depth_ - 1;
+        while (depth_ > target) {
+            Token t = next();
+            if (t == Token::Error || t == Token::End) {
+                return {};
+            }
+        }
+    } else if (first == Token::Error || first == Token::End ||
+               first == Token::EndObject || first == Token::EndArray || first == Token::Key) {
+        return {};
+    }
+
+    return in_.substr(start, pos_ - start);
+}
+
+void JSONReader::unescape(std::string_view raw, std::string& out) {
+    size_t i = 0;
+    while (i < raw.size()) {
+        size_t run = raw.find('\\', i);
+        if (run == std::string_view::npos) {
+            out.append(raw.substr(i));
+            return;
+        }
+        out.append(raw.substr(i, run - i));
+        i = run + 1;
+
+        char e = raw[i++];
+        switch (e) {
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t cp = readHex4(raw, i);
+                i += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF && i + 6 <= raw.size() &&
+                    raw[i] == '\\' && raw[i + 1] == 'u') {
+                    uint32_t low = readHex4(raw, i + 2);
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                }
+                appendUTF8(out, cp);
+                break;
+            }
+            default:
+                out += e;
+                break;
+        }
+    }
+}
+
+std::string_view JSONReader::stringValue(std::string& scratch) const {
+    if (!has_escapes_) {
+        return text_;
+    }
+    scratch.clear();
+    unescape(text_, scratch);
+    return scratch;
+}
+
+
+
+
+
+void JSONWriter::separator() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    const uint64_t bit = uint64_t{1} << depth_;
+    if (need_comma_ & bit) {
+        buf_ += ',';
+    }
+    need_comma_ |= bit;
+}
+
+void JSONWriter::open(char c) {
+    // Refused rather than sharing the parent's level, which would corrupt
+    // its comma state; the matching close() is swallowed too
+    if (depth_ >= MAX_DEPTH - 1) {
+        ++overflow_;
+        overflowed_ = true;
+        return;
+    }
+    separator();
+    buf_ += c;
+    ++depth_;
+    need_comma_ &= ~(uint64_t{1} << depth_);
+}
+
+void JSONWriter::close(char c) {
+    if (overflow_ > 0) {
+        --overflow_;
+        return;
+    }
+    buf_ += c;
+    if (depth_ > 0) {
+        --depth_;
+    }
+}
+
+JSONWriter& JSONWriter::key(std::string_view name) {
+    separator();
+    appendEscaped(name);
+    buf_ += ':';
+    after_key_ = true;
+    return *this;
+}
+
+JSONWriter& JSONWriter::value(std::string_view text) {
+    separator();
+    appendEscaped(text);
+    return *this;
+}
+
+JSONWriter& JSONWriter::value(bool b) {
+    separator();
+    buf_.append(b ? "true" : "false");
+    return *this;
+}
+
+JSONWriter& JSONWriter::value(double d) {
+    separator();
+    if (!std::isfinite(d)) {
+        buf_.append("null");
+        return *this;
+    }
+    char tmp[32];
+    auto res = std::to_chars(tmp, tmp + sizeof(tmp), d);
+    buf_.append(tmp, res.ptr);
+    return *this;
+}
+
+JSONWriter& JSONWriter::null() {
+    separator();
+    buf_.append("null");
+    return *this;
+}
+
+JSONWriter& JSONWriter::raw(std::string_view json) {
+    separator();
+    buf_.append(json);
+    return *this;
+}
+
+void JSONWriter::appendEscaped(std::string_view text) {
+    static constexpr char HEX[] = "0123456789abcdef";
+
+    buf_ += '"';
+    size_t run_start = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        buf_.append(text.data() + run_start, i - run_start);
+        run_start = i + 1;
+        switch (c) {
+            case '"':  buf_.append("\\\""); break;
+            case '\\': buf_.append("\\\\"); break;
+            case '\n': buf_.append("\\n"); break;
+            case '\r': buf_.append("\\r"); break;
+            case '\t': buf_.append("\\t"); break;
+            default: {
+                char esc[6] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xF]};
+                buf_.append(esc, sizeof(esc));
+            }
+        }
+    }
+    buf_.append(text.data() + run_start, text.size() - run_start);
+    buf_ += '"';
+}
+
+void JSONWriter::appendInteger(int64_t number) {
+    char tmp[24];
+    auto res = std::to_chars(tmp, tmp + sizeof(tmp), number);
+    buf_.append(tmp, res.ptr);
+}
+
+void JSONWriter::appendUnsigned(uint64_t number) {
+    char tmp[24];
+    auto res = std::to_chars(tmp, tmp + sizeof(tmp), number);
+    buf_.append(tmp, res.ptr);
+}
+
+}
@@ -0,0 +1,111 @@
+#include "pointblank/ipc/SharedState.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/futex.h>
+
+namespace pblank {
+
+SharedStateRegion::~SharedStateRegion() {
+    close();
+}
+
+bool SharedStateRegion::open() {
+    if (state_) {
+        return true;
+    }
+
+    char name[64];
+    std::snprintf(name, sizeof(name), PB_STATE_NAME_FORMAT, static_cast<unsigned>(getuid()));
+    name_ = name;
+
+    // Never adopt an existing object: it may be a stale region from a
+    // previous instance or one planted by someone else. Replace it with a
+    // fresh one that only we can have created.
+    int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        if (shm_unlink(name_.c_str()) < 0 && errno != ENOENT) {
+            std::cerr << "IPC: cannot replace existing " << name_ << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        fd = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    }
+    if (fd < 0) {
+        std::cerr << "IPC: shm_open " << name_ << " failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (ftruncate(fd, sizeof(pb_state)) < 0) {
+        std::cerr << "IPC: ftruncate " << name_ << " failed: " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    void* map = mmap(nullptr, sizeof(pb_state), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "IPC: mmap " << name_ << " failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    state_ = static_cast<pb_state*>(map);
+    std::memset(&state_->data, 0, sizeof(state_->data));
+    state_->version = PB_STATE_VERSION;
+    state_->size = sizeof(pb_state);
+    state_->reserved = 0;
+    __atomic_store_n(&state_->sequence, 0, __ATOMIC_RELAXED);
+    // magic last: readers that map a half-initialized region reject it
+    __atomic_store_n(&state_->magic, PB_STATE_MAGIC, __ATOMIC_RELEASE);
+
+    has_last_ = false;
+    return true;
+}
+
+void SharedStateRegion::close() {
+    if (!state_) {
+        return;
+    }
+
+    // Wake any blocked readers so they notice the region going away
+    __atomic_store_n(&state_->magic, 0u, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&state_->change_count, 1, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &state_->change_count, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+
+    munmap(state_, sizeof(pb_state));
+    shm_unlink(name_.c_str());
+    state_ = nullptr;
+    has_last_ = false;
+}
+
+bool SharedStateRegion::publish(const pb_state_data& data) {
+    if (!state_) {
+        return false;
+    }
+    if (has_last_ && std::memcmp(&last_, &data, sizeof(data)) == 0) {
+        return false;
+    }
+
+    uint32_t seq = __atomic_load_n(&state_->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&state_->sequence, seq + 1, __ATOMIC_RELAXED);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&state_->data, &data, sizeof(data));
+    __atomic_store_n(&state_->sequence, seq + 2, __ATOMIC_RELEASE);
+
+    __atomic_add_fetch(&state_->change_count, 1, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &state_->change_count, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+
+    last_ = data;
+    has_last_ = true;
+    return true;
+}
+
+}
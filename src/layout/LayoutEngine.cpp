@@ -341,12 +341,13 @@ void BSPLayout::visitNode(BSPNode* node, const Rect& bounds, Display* display, B
             if (h < 50) h = 50;
             
             
-            if (config_.border_width > 0) {
-                if (w > static_cast<unsigned int>(2 * config_.border_width)) {
-                    w -= 2 * config_.border_width;
+            int border = borderWidthFor(win, config_.border_width);
+            if (border > 0) {
+                if (w > static_cast<unsigned int>(2 * border)) {
+                    w -= 2 * border;
                 }
-                if (h > static_cast<unsigned int>(2 * config_.border_width)) {
-                    h -= 2 * config_.border_width;
+                if (h > static_cast<unsigned int>(2 * border)) {
+                    h -= 2 * border;
                 }
             }
             
@@ -360,7 +361,7 @@ void BSPLayout::visitNode(BSPNode* node, const Rect& bounds, Display* display, B
             
             
             XWindowChanges changes;
-            changes.border_width = config_.border_width;
+            changes.border_width = border;
             XConfigureWindow(display, win, CWBorderWidth, &changes);
             
             
@@ -369,7 +370,7 @@ void BSPLayout::visitNode(BSPNode* node, const Rect& bounds, Display* display, B
             
             
             if (render_pipeline_) {
-                render_pipeline_->drawBorder(win, border_color, config_.border_width);
+                render_pipeline_->drawBorder(win, border_color, border);
             } else {
                 XSetWindowBorder(display, win, border_color);
             }
@@ -480,13 +481,13 @@ void MasterStackLayout::visit(BSPNode* root, const Rect& bounds, Display* displa
         }
         
         XWindowChanges changes;
-        changes.border_width = config_.border_width;
+        changes.border_width = borderWidthFor(windows[0], config_.border_width);
         XConfigureWindow(display, windows[0], CWBorderWidth, &changes);
         
         unsigned long color = (windows[0] == focused_win) ? 
             config_.focused_border_color : config_.unfocused_border_color;
         if (render_pipeline_) {
-            render_pipeline_->drawBorder(windows[0], color, config_.border_width);
+            render_pipeline_->drawBorder(windows[0], color, changes.border_width);
         } else {
             XSetWindowBorder(display, windows[0], color);
         }
@@ -515,13 +516,13 @@ void MasterStackLayout::visit(BSPNode* root, const Rect& bounds, Display* displa
         }
         
         XWindowChanges changes;
-        changes.border_width = config_.border_width;
+        changes.border_width = borderWidthFor(win, config_.border_width);
         XConfigureWindow(display, win, CWBorderWidth, &changes);
         
         unsigned long color = (win == focused_win) ? 
             config_.focused_border_color : config_.unfocused_border_color;
         if (render_pipeline_) {
-            render_pipeline_->drawBorder(win, color, config_.border_width);
+            render_pipeline_->drawBorder(win, color, changes.border_width);
         } else {
             XSetWindowBorder(display, win, color);
         }
@@ -546,13 +547,13 @@ void MasterStackLayout::visit(BSPNode* root, const Rect& bounds, Display* displa
             }
             
             XWindowChanges changes;
-            changes.border_width = config_.border_width;
+            changes.border_width = borderWidthFor(win, config_.border_width);
             XConfigureWindow(display, win, CWBorderWidth, &changes);
             
             unsigned long color = (win == focused_win) ? 
                 config_.focused_border_color : config_.unfocused_border_color;
             if (render_pipeline_) {
-                render_pipeline_->drawBorder(win, color, config_.border_width);
+                render_pipeline_->drawBorder(win, color, changes.border_width);
             } else {
                 XSetWindowBorder(display, win, color);
             }
@@ -696,14 +697,14 @@ void CenteredMasterLayout::positionWindow(Window win, const Rect& rect,
     
     
     XWindowChanges changes;
-    changes.border_width = config_.border_width;
+    changes.border_width = borderWidthFor(win, config_.border_width);
     XConfigureWindow(display, win, CWBorderWidth, &changes);
     
     unsigned long color = is_focused ? 
         config_.focused_border_color : config_.unfocused_border_color;
     
     if (render_pipeline_) {
-        render_pipeline_->drawBorder(win, color, config_.border_width);
+        render_pipeline_->drawBorder(win, color, changes.border_width);
     } else {
         XSetWindowBorder(display, win, color);
     }
@@ -833,14 +834,14 @@ void DynamicGridLayout::positionWindow(Window win, const Rect& rect,
     }
     
     XWindowChanges changes;
-    changes.border_width = config_.border_width;
+    changes.border_width = borderWidthFor(win, config_.border_width);
     XConfigureWindow(display, win, CWBorderWidth, &changes);
     
     unsigned long color = is_focused ? 
         config_.focused_border_color : config_.unfocused_border_color;
     
     if (render_pipeline_) {
-        render_pipeline_->drawBorder(win, color, config_.border_width);
+        render_pipeline_->drawBorder(win, color, changes.border_width);
     } else {
         XSetWindowBorder(display, win, color);
     }
@@ -999,14 +1000,14 @@ void DwindleSpiralLayout::positionWindow(Window win, const Rect& rect,
     }
     
     XWindowChanges changes;
-    changes.border_width = config_.border_width;
+    changes.border_width = borderWidthFor(win, config_.border_width);
     XConfigureWindow(display, win, CWBorderWidth, &changes);
     
     unsigned long color = is_focused ? 
         config_.focused_border_color : config_.unfocused_border_color;
     
     if (render_pipeline_) {
-        render_pipeline_->drawBorder(win, color, config_.border_width);
+        render_pipeline_->drawBorder(win, color, changes.border_width);
     } else {
         XSetWindowBorder(display, win, color);
     }
@@ -1189,14 +1190,14 @@ void GoldenRatioLayout::positionWindow(Window win, const Rect& rect,
     }
     
     XWindowChanges changes;
-    changes.border_width = config_.border_width;
+    changes.border_width = borderWidthFor(win, config_.border_width);
     XConfigureWindow(display, win, CWBorderWidth, &changes);
     
     unsigned long color = is_focused ? 
         config_.focused_border_color : config_.unfocused_border_color;
     
     if (render_pipeline_) {
-        render_pipeline_->drawBorder(win, color, config_.border_width);
+        render_pipeline_->drawBorder(win, color, changes.border_width);
     } else {
         XSetWindowBorder(display, win, color);
     }
@@ -1430,14 +1431,14 @@ void InfiniteCanvasLayout::positionWindow(Window win, const Rect& rect,
     }
     
     XWindowChanges changes;
-    changes.border_width = config_.border_width;
+    changes.border_width = borderWidthFor(win, config_.border_width);
     XConfigureWindow(display, win, CWBorderWidth, &changes);
     
     unsigned long color = is_focused ? 
         config_.focused_border_color : config_.unfocused_border_color;
     
     if (render_pipeline_) {
-        render_pipeline_->drawBorder(win, color, config_.border_width);
+        render_pipeline_->drawBorder(win, color, changes.border_width);
     } else {
         XSetWindowBorder(display, win, color);
     }
@@ -1457,6 +1458,7 @@ LayoutEngine::LayoutEngine() {
     WorkspaceData ws;
     auto bsp_layout = std::make_unique<BSPLayout>();
     bsp_layout->setGapConfig(&gap_config_);
+    bsp_layout->setBorderOverrides(&border_overrides_);
     ws.layout = std::move(bsp_layout);
     workspaces_.push_back(std::move(ws));
 }
@@ -1472,8 +1474,14 @@ void LayoutEngine::ensureWorkspace(int workspace) {
         
         
         for (size_t i = old_size; i < new_size; ++i) {
+            const auto* rule = workspace_layouts_ ? workspace_layouts_->find(static_cast<int>(i) + 1) : nullptr;
+            if (rule) {
+                workspaces_[i].layout = makeLayout(rule->mode, rule);
+                continue;
+            }
             auto bsp_layout = std::make_unique<BSPLayout>();
             bsp_layout->setGapConfig(&gap_config_);
+            bsp_layout->setBorderOverrides(&border_overrides_);
             workspaces_[i].layout = std::move(bsp_layout);
         }
     }
@@ -2202,7 +2210,9 @@ void LayoutEngine::updateBorderColors() {
         }
         
         if (render_pipeline_) {
-            render_pipeline_->drawBorder(win, color, border_width_);
+            auto border = border_overrides_.find(win);
+            render_pipeline_->drawBorder(win, color,
+                border != border_overrides_.end() ? border->second : border_width_);
         } else {
             XSetWindowBorder(display_, win, color);
         }
@@ -2315,18 +2325,35 @@ void LayoutEngine::setLayoutMode(int workspace, LayoutMode mode) {
         return;
     }
     
+    // Switching back to the mode a layout rule picked restores its parameters
+    const LayoutConfig::WorkspaceLayout* rule = workspace_layouts_ ? workspace_layouts_->find(workspace + 1) : nullptr;
+    workspaces_[workspace].layout = makeLayout(mode, rule && rule->mode == mode ? rule : nullptr);
+}
+
+void LayoutEngine::setWorkspaceLayouts(const LayoutConfig::WorkspaceLayouts* layouts) {
+    workspace_layouts_ = layouts && !layouts->empty() ? layouts : nullptr;
+    if (!workspace_layouts_) return;
+    
+    for (size_t i = 0; i < workspaces_.size(); ++i) {
+        if (workspaces_[i].tree) continue;
+        if (const auto* rule = workspace_layouts_->find(static_cast<int>(i) + 1)) {
+            workspaces_[i].layout = makeLayout(rule->mode, rule);
+        }
+    }
+}
+
+std::unique_ptr<LayoutVisitor> LayoutEngine::makeLayout(LayoutMode mode, const LayoutConfig::WorkspaceLayout* rule) const {
     std::unique_ptr<LayoutVisitor> layout;
     
     switch (mode) {
         case LayoutMode::BSP: {
             BSPLayout::Config config;
-            config.gap_size = gap_size_;
-            config.border_width = border_width_;
+            config.gap_size = rule ? rule->bsp.gap_size : gap_size_;
+            config.border_width = rule ? rule->bsp.border_width : border_width_;
+            if (rule) config.padding = rule->bsp.padding;
             config.focused_border_color = focused_border_color_;
             config.unfocused_border_color = unfocused_border_color_;
-            auto bsp_layout = std::make_unique<BSPLayout>(config);
-            bsp_layout->setGapConfig(&gap_config_);
-            layout = std::move(bsp_layout);
+            layout = std::make_unique<BSPLayout>(config);
             break;
         }
         case LayoutMode::Monocle:
@@ -2334,7 +2361,11 @@ void LayoutEngine::setLayoutMode(int workspace, LayoutMode mode) {
             break;
         case LayoutMode::MasterStack: {
             MasterStackLayout::Config config;
-            config.gap_size = gap_size_;
+            config.gap_size = rule ? rule->master_stack.gap_size : gap_size_;
+            if (rule) {
+                config.master_ratio = rule->master_stack.master_ratio;
+                config.max_master = rule->master_stack.max_master;
+            }
             config.border_width = border_width_;
             config.focused_border_color = focused_border_color_;
             config.unfocused_border_color = unfocused_border_color_;
@@ -2343,7 +2374,12 @@ void LayoutEngine::setLayoutMode(int workspace, LayoutMode mode) {
         }
         case LayoutMode::CenteredMaster: {
             CenteredMasterLayout::Config config;
-            config.gap_size = gap_size_;
+            config.gap_size = rule ? rule->centered_master.gap_size : gap_size_;
+            if (rule) {
+                config.center_ratio = rule->centered_master.center_ratio;
+                config.max_center = rule->centered_master.max_center;
+                config.center_on_focus = rule->centered_master.center_on_focus;
+            }
             config.border_width = border_width_;
             config.focused_border_color = focused_border_color_;
             config.unfocused_border_color = unfocused_border_color_;
@@ -2352,7 +2388,12 @@ void LayoutEngine::setLayoutMode(int workspace, LayoutMode mode) {
         }
         case LayoutMode::DynamicGrid: {
             DynamicGridLayout::Config config;
-            config.gap_size = gap_size_;
+            config.gap_size = rule ? rule->dynamic_grid.gap_size : gap_size_;
+            if (rule) {
+                config.prefer_horizontal = rule->dynamic_grid.prefer_horizontal;
+                config.min_cell_width = rule->dynamic_grid.min_cell_width;
+                config.min_cell_height = rule->dynamic_grid.min_cell_height;
+            }
             config.border_width = border_width_;
             config.focused_border_color = focused_border_color_;
             config.unfocused_border_color = unfocused_border_color_;
@@ -2361,7 +2402,12 @@ void LayoutEngine::setLayoutMode(int workspace, LayoutMode mode) {
         }
         case LayoutMode::DwindleSpiral: {
             DwindleSpiralLayout::Config config;
-            config.gap_size = gap_size_;
+            config.gap_size = rule ? rule->dwindle_spiral.gap_size : gap_size_;
+            if (rule) {
+                config.initial_ratio = rule->dwindle_spiral.initial_ratio;
+                config.ratio_increment = rule->dwindle_spiral.ratio_increment;
+                config.shift_by_focus = rule->dwindle_spiral.shift_by_focus;
+            }
             config.border_width = border_width_;
             config.focused_border_color = focused_border_color_;
             config.unfocused_border_color = unfocused_border_color_;
@@ -2379,6 +2425,14 @@ void LayoutEngine::setLayoutMode(int workspace, LayoutMode mode) {
         }
         case LayoutMode::TabbedStacked: {
             TabbedStackedLayout::Config config;
+            if (rule) {
+                config.tab_height = rule->tabbed_stacked.tab_height;
+                config.tab_min_width = rule->tabbed_stacked.tab_min_width;
+                config.gap_size = rule->tabbed_stacked.gap_size;
+                config.show_focused_only = rule->tabbed_stacked.show_focused_only;
+                config.tab_position = rule->tabbed_stacked.tab_at_top
+                    ? TabbedStackedLayout::TabPosition::Top : TabbedStackedLayout::TabPosition::Bottom;
+            }
             config.border_width = border_width_;
             config.focused_border_color = focused_border_color_;
             config.unfocused_border_color = unfocused_border_color_;
@@ -2397,8 +2451,9 @@ void LayoutEngine::setLayoutMode(int workspace, LayoutMode mode) {
     
     if (layout) {
         layout->setGapConfig(&gap_config_);  
-        workspaces_[workspace].layout = std::move(layout);
+        layout->setBorderOverrides(&border_overrides_);
     }
+    return layout;
 }
 
 
@@ -1,6 +1,7 @@
 #include "pointblank/core/WindowManager.hpp"
 #include "pointblank/core/SessionManager.hpp"
 #include "pointblank/core/XServerManager.hpp"
+#include "pointblank/core/Launcher.hpp"
 #include <iostream>
 #include <csignal>
 #include <cstdlib>
@@ -38,6 +39,7 @@ void printUsage(const char* program_name) {
               << "  -c, --config   Specify config file path\n"
               << "  -d, --display  Specify X display (e.g., :0, :1)\n"
               << "  --no-startx    Don't attempt to start X server\n"
+              << "  --no-launcher  Spawn commands from the WM instead of a helper\n"
               << std::endl;
 }
 
@@ -98,6 +100,7 @@ void ensureConfigDirectories() {
 
 int main(int argc, char* argv[]) {
     bool auto_start_x = true;
+    bool use_launcher = true;
     std::optional<std::string> custom_display;
     
     
@@ -135,6 +138,10 @@ int main(int argc, char* argv[]) {
         if (arg == "--no-startx") {
             auto_start_x = false;
         }
+        
+        if (arg == "--no-launcher") {
+            use_launcher = false;
+        }
     }
     
     
@@ -185,6 +192,12 @@ Point:Blank Window Manager v0.1.0.0
         
     }
     
+    // Forked while the process is still small: after the session
+    // environment is set up, before Cairo, GLib and extensions load
+    if (use_launcher && !Launcher::start()) {
+        std::cerr << "Warning: Launch helper unavailable, spawning inline" << std::endl;
+    }
+    
     try {
         
         WindowManager wm;
@@ -0,0 +1,119 @@
+#include "pointblank/utils/Spawn.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace pblank {
+
+namespace {
+
+#if !(defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34)))
+// Without posix_spawn_file_actions_addclosefrom_np the child cannot be
+// told to close fds, so mark them close-on-exec in the WM instead. The WM
+// never execs itself, so nothing it holds needs to survive an exec.
+void markDescriptorsCloexec() {
+#ifdef SYS_close_range
+    if (syscall(SYS_close_range, 3u, ~0u, 4u /* CLOSE_RANGE_CLOEXEC */) == 0) {
+        return;
+    }
+#endif
+    long max_fd = sysconf(_SC_OPEN_MAX);
+    for (int fd = 3; fd < max_fd; ++fd) {
+        int flags = fcntl(fd, F_GETFD);
+        if (flags != -1 && !(flags & FD_CLOEXEC)) {
+            fcntl(fd, F_SETFD, flags | FD_CLOEXEC);
+        }
+    }
+}
+#endif
+
+// posix_spawn* return an error number instead of setting errno
+pid_t fail(int err) {
+    errno = err;
+    return -1;
+}
+
+}
+
+pid_t spawnProcess(char* const argv[], const SpawnOptions& options) {
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_t actions;
+    if (int err = posix_spawnattr_init(&attr)) {
+        return fail(err);
+    }
+    if (int err = posix_spawn_file_actions_init(&actions)) {
+        posix_spawnattr_destroy(&attr);
+        return fail(err);
+    }
+    
+    // The WM installs handlers and may block signals; children start clean
+    sigset_t all, none;
+    sigfillset(&all);
+    sigemptyset(&none);
+    posix_spawnattr_setsigdefault(&attr, &all);
+    posix_spawnattr_setsigmask(&attr, &none);
+    
+    short flags = POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK;
+    if (options.new_session) {
+#ifdef POSIX_SPAWN_SETSID
+        flags |= POSIX_SPAWN_SETSID;
+#else
+        flags |= POSIX_SPAWN_SETPGROUP;
+        posix_spawnattr_setpgroup(&attr, 0);
+#endif
+    }
+    posix_spawnattr_setflags(&attr, flags);
+    
+    if (options.null_stdio) {
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+    }
+    
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+    posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1);
+#else
+    markDescriptorsCloexec();
+#endif
+    
+    pid_t pid = -1;
+    int err = posix_spawnp(&pid, argv[0], &actions, &attr, argv, environ);
+    
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    return err ? fail(err) : pid;
+}
+
+pid_t spawnShell(const std::string& command, const SpawnOptions& options) {
+    char* argv[] = {
+        const_cast<char*>("/bin/sh"),
+        const_cast<char*>("-c"),
+        const_cast<char*>(command.c_str()),
+        nullptr
+    };
+    return spawnProcess(argv, options);
+}
+
+int runShell(const std::string& command, const SpawnOptions& options) {
+    pid_t pid = spawnShell(command, options);
+    if (pid == -1) {
+        return -1;
+    }
+    
+    int status = 0;
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return status;
+}
+
+}
@@ -3,20 +3,82 @@
 #include "pointblank/layout/LayoutEngine.hpp"
 #include <X11/keysym.h>
 #include <X11/XKBlib.h>
+#include <cstdint>
+#include <cerrno>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <charconv>
+#include <string_view>
 #include <unistd.h>
-#include <sys/wait.h>
-#include <fcntl.h>
 
 namespace pblank {
 
+namespace {
+
+// NumLock / CapsLock combinations grabbed alongside every binding
+constexpr unsigned int LOCK_MODIFIERS[] = {
+    0,
+    Mod2Mask,
+    LockMask,
+    Mod2Mask | LockMask
+};
+
+using Op = KeybindManager::Action::Op;
+using Direction = KeybindManager::Action::Direction;
+
+// Indexed by Direction; WindowManager takes direction names
+const std::string DIRECTION_NAMES[] = {"left", "right", "up", "down"};
+
+std::string_view trim(std::string_view text, std::string_view chars = " \t") {
+    size_t first = text.find_first_not_of(chars);
+    if (first == std::string_view::npos) return {};
+    return text.substr(first, text.find_last_not_of(chars) - first + 1);
+}
+
+struct SimpleAction {
+    std::string_view name;
+    Op op;
+    Direction direction;
+};
+
+constexpr SimpleAction SIMPLE_ACTIONS[] = {
+    {"killactive", Op::KillActive, Direction::Left},
+    {"fullscreen", Op::Fullscreen, Direction::Left},
+    {"togglefloating", Op::ToggleFloating, Direction::Left},
+    {"reload", Op::Reload, Direction::Left},
+    {"exit", Op::Exit, Direction::Left},
+    {"workspacenext", Op::WorkspaceNext, Direction::Left},
+    {"workspaceprev", Op::WorkspacePrev, Direction::Left},
+    {"cyclenext", Op::CycleNext, Direction::Left},
+    {"cycleprev", Op::CyclePrev, Direction::Left},
+    {"focusleft", Op::Focus, Direction::Left},
+    {"focusright", Op::Focus, Direction::Right},
+    {"focusup", Op::Focus, Direction::Up},
+    {"focusdown", Op::Focus, Direction::Down},
+    {"swapleft", Op::Swap, Direction::Left},
+    {"swapright", Op::Swap, Direction::Right},
+    {"swapup", Op::Swap, Direction::Up},
+    {"swapdown", Op::Swap, Direction::Down},
+    {"resizeleft", Op::Resize, Direction::Left},
+    {"resizeright", Op::Resize, Direction::Right},
+    {"resizeup", Op::Resize, Direction::Up},
+    {"resizedown", Op::Resize, Direction::Down},
+    {"togglesplit", Op::ToggleSplit, Direction::Left},
+    {"scratchpad_show", Op::ScratchpadShow, Direction::Left},
+    {"scratchpad_show_next", Op::ScratchpadShowNext, Direction::Left},
+    {"scratchpad_show_prev", Op::ScratchpadShowPrev, Direction::Left},
+    {"scratchpad_hide", Op::ScratchpadHide, Direction::Left},
+};
+
+}
+
 KeybindManager::KeybindManager() = default;
 
-void KeybindManager::registerKeybind(const std::string& keybind_string, 
-                                     const std::string& action) {
+KeybindManager::Keybind KeybindManager::makeKeybind(const std::string& keybind_string,
+                                                    const std::string& action) {
     
     std::string modifiers_str;
     std::string key_str;
@@ -42,15 +104,57 @@ void KeybindManager::registerKeybind(const std::string& keybind_string,
     bind.modifiers = parseModifiers(modifiers_str);
     bind.keysym = parseKey(key_str);
     bind.action = action;
+    bind.parsed = parseAction(action);
+    if (bind.parsed.op == Op::Invalid) {
+        std::cerr << "Unknown action: " << action << std::endl;
+    }
+    
+    return bind;
+}
+
+KeybindManager::Action KeybindManager::parseAction(const std::string& action) {
+    Action parsed;
+    std::string_view text = action;
+    
+    // Binds written as `exec: "cmd"` in the config
+    if (text.substr(0, 5) == "exec:") {
+        parsed.argument = trim(text.substr(5), " \t\"");
+        parsed.op = parsed.argument.empty() ? Op::Invalid : Op::Exec;
+        return parsed;
+    }
     
     
-    if (action.find("exec:") == 0) {
-        bind.exec_command = action.substr(5);
-        
-        bind.exec_command.erase(0, bind.exec_command.find_first_not_of(" \t\""));
-        bind.exec_command.erase(bind.exec_command.find_last_not_of(" \t\"") + 1);
+    text = trim(text);
+    size_t space = text.find_first_of(" \t");
+    std::string_view command = text.substr(0, space);
+    std::string_view rest = space == std::string_view::npos ? std::string_view{} : trim(text.substr(space));
+    
+    for (const auto& simple : SIMPLE_ACTIONS) {
+        if (command == simple.name) {
+            parsed.op = simple.op;
+            parsed.direction = simple.direction;
+            return parsed;
+        }
     }
     
+    if (command == "workspace" || command == "movetoworkspace" || command == "movetoworkspacesilent") {
+        std::from_chars(rest.data(), rest.data() + rest.size(), parsed.workspace);
+        parsed.op = command == "workspace" ? Op::Workspace
+                  : command == "movetoworkspace" ? Op::MoveToWorkspace
+                  : Op::MoveToWorkspaceSilent;
+    } else if (command == "layout") {
+        parsed.argument = rest.substr(0, rest.find_first_of(" \t"));
+        parsed.op = Op::Layout;
+    } else if (command == "exec" && !rest.empty()) {
+        parsed.argument = rest;
+        parsed.op = Op::Exec;
+    }
+    return parsed;
+}
+
+void KeybindManager::registerKeybind(const std::string& keybind_string, 
+                                     const std::string& action) {
+    Keybind bind = makeKeybind(keybind_string, action);
     
     
     auto it = std::remove_if(keybinds_.begin(), keybinds_.end(),
@@ -66,40 +170,72 @@ void KeybindManager::registerKeybind(const std::string& keybind_string,
 
 void KeybindManager::registerDefaultKeybind(const std::string& keybind_string, 
                                              const std::string& action) {
+    keybinds_.emplace_back(makeKeybind(keybind_string, action));
+}
+
+KeybindManager::SyncStats KeybindManager::syncKeybinds(
+        const std::vector<std::pair<std::string, std::string>>& binds,
+        Display* display, Window root) {
     
-    std::string modifiers_str;
-    std::string key_str;
+    auto combo = [](const Keybind& bind) {
+        return (static_cast<uint64_t>(bind.modifiers) << 32) | static_cast<uint32_t>(bind.keysym);
+    };
     
-    auto last_comma = keybind_string.rfind(',');
-    if (last_comma != std::string::npos) {
-        modifiers_str = keybind_string.substr(0, last_comma);
-        key_str = keybind_string.substr(last_comma + 1);
-        
-        modifiers_str.erase(0, modifiers_str.find_first_not_of(" \t"));
-        modifiers_str.erase(modifiers_str.find_last_not_of(" \t") + 1);
-        key_str.erase(0, key_str.find_first_not_of(" \t"));
-        key_str.erase(key_str.find_last_not_of(" \t") + 1);
-    } else {
-        key_str = keybind_string;
-        key_str.erase(0, key_str.find_first_not_of(" \t"));
-        key_str.erase(key_str.find_last_not_of(" \t") + 1);
+    std::vector<Keybind> next;
+    next.reserve(binds.size());
+    std::unordered_map<uint64_t, size_t> next_index;
+    for (const auto& [keybind_string, action] : binds) {
+        Keybind bind = makeKeybind(keybind_string, action);
+        auto [it, inserted] = next_index.try_emplace(combo(bind), next.size());
+        if (inserted) {
+            next.emplace_back(std::move(bind));
+        } else {
+            next[it->second] = std::move(bind);
+        }
     }
     
-    Keybind bind;
-    bind.modifiers = parseModifiers(modifiers_str);
-    bind.keysym = parseKey(key_str);
-    bind.action = action;
-    
-    if (action.find("exec:") == 0) {
-        bind.exec_command = action.substr(5);
-        bind.exec_command.erase(0, bind.exec_command.find_first_not_of(" \t\""));
-        bind.exec_command.erase(bind.exec_command.find_last_not_of(" \t\"") + 1);
+    std::unordered_map<uint64_t, const Keybind*> current;
+    current.reserve(keybinds_.size());
+    for (const auto& bind : keybinds_) {
+        current.emplace(combo(bind), &bind);
     }
     
+    SyncStats stats;
+    for (const auto& [key, bind] : current) {
+        if (next_index.count(key)) {
+            continue;
+        }
+        ++stats.removed;
+        KeyCode keycode = bind->keysym == NoSymbol ? 0 : XKeysymToKeycode(display, bind->keysym);
+        if (keycode != 0) {
+            ungrabKeyWithLocks(display, keycode, bind->modifiers, root);
+        }
+    }
     
+    for (const auto& bind : next) {
+        auto it = current.find(combo(bind));
+        if (it != current.end()) {
+            if (it->second->action != bind.action) {
+                ++stats.rebound;
+            }
+            continue;
+        }
+        ++stats.added;
+        KeyCode keycode = bind.keysym == NoSymbol ? 0 : XKeysymToKeycode(display, bind.keysym);
+        if (keycode == 0) {
+            std::cerr << "Warning: No keycode for keysym " << bind.keysym << std::endl;
+            continue;
+        }
+        grabKeyWithLocks(display, keycode, bind.modifiers, root);
+    }
     
-    keybinds_.emplace_back(std::move(bind));
+    keybinds_ = std::move(next);
+    rebuildDispatch(display);
     
+    if (stats.added || stats.removed) {
+        XSync(display, False);
+    }
+    return stats;
 }
 
 unsigned int KeybindManager::parseModifiers(const std::string& modifiers) {
@@ -296,6 +432,8 @@ KeySym KeybindManager::parseKey(const std::string& key) {
 }
 
 void KeybindManager::grabKeys(Display* display, Window root) {
+    // Held keys then repeat as bare presses, which handleKeyPress() merges
+    XkbSetDetectableAutoRepeat(display, True, nullptr);
     
     XUngrabKey(display, AnyKey, AnyModifier, root);
     
@@ -315,215 +453,189 @@ void KeybindManager::grabKeys(Display* display, Window root) {
         grabKeyWithLocks(display, keycode, bind.modifiers, root);
     }
     
+    rebuildDispatch(display);
     XSync(display, False);
 }
 
+void KeybindManager::rebuildDispatch(Display* display) {
+    dispatch_.clear();
+    dispatch_.reserve(keybinds_.size());
+    for (size_t i = 0; i < keybinds_.size(); ++i) {
+        const auto& bind = keybinds_[i];
+        // Presses only ever carry these modifiers once locks are masked off
+        if (bind.keysym == NoSymbol || (bind.modifiers & ~BIND_MODIFIERS)) {
+            continue;
+        }
+        KeyCode keycode = XKeysymToKeycode(display, bind.keysym);
+        if (keycode != 0) {
+            // First bind wins for duplicate combos, like the old linear scan
+            dispatch_.try_emplace(dispatchKey(keycode, bind.modifiers), static_cast<uint32_t>(i));
+        }
+    }
+}
+
 void KeybindManager::grabKeyWithLocks(Display* display, KeyCode keycode, 
                                       unsigned int modifiers, Window root) {
-    
-    unsigned int lock_modifiers[] = {
-        0,
-        Mod2Mask,           
-        LockMask,           
-        Mod2Mask | LockMask 
-    };
-    
-    for (unsigned int lock_mod : lock_modifiers) {
+    for (unsigned int lock_mod : LOCK_MODIFIERS) {
         XGrabKey(display, keycode, modifiers | lock_mod, root, True,
                 GrabModeAsync, GrabModeAsync);
     }
 }
 
+void KeybindManager::ungrabKeyWithLocks(Display* display, KeyCode keycode,
+                                        unsigned int modifiers, Window root) {
+    for (unsigned int lock_mod : LOCK_MODIFIERS) {
+        XUngrabKey(display, keycode, modifiers | lock_mod, root);
+    }
+}
+
 void KeybindManager::handleKeyPress(const XKeyEvent& event, WindowManager* wm) {
-    KeySym keysym = XkbKeycodeToKeysym(event.display, event.keycode, 0, 0);
-    
-    
-    unsigned int modifiers = event.state & (ShiftMask | ControlMask | Mod1Mask | Mod4Mask);
-    
-    for (const auto& bind : keybinds_) {
-        if (bind.keysym == keysym && bind.modifiers == modifiers) {
-            
-            if (!bind.exec_command.empty()) {
-                executeCommand(bind.exec_command);
-            } else {
-                executeAction(bind.action, wm);
-            }
-            return;
-        }
+    auto it = dispatch_.find(dispatchKey(static_cast<KeyCode>(event.keycode), event.state));
+    if (it == dispatch_.end()) {
+        return;
     }
     
+    const Action& action = keybinds_[it->second].parsed;
+    int count = isCoalesced(action.op) ? 1 + takeQueuedRepeats(event) : 1;
+    executeAction(action, wm, count);
 }
 
-void KeybindManager::executeAction(const std::string& action, WindowManager* wm) {
-    
-    
-    std::istringstream iss(action);
-    std::string command;
-    iss >> command;
+void KeybindManager::handleKeyRelease(const XKeyEvent& event) {
+    auto it = dispatch_.find(dispatchKey(static_cast<KeyCode>(event.keycode), event.state));
+    if (it != dispatch_.end() && isCoalesced(keybinds_[it->second].parsed.op)) {
+        takeQueuedRepeats(event);
+    }
+}
+
+int KeybindManager::takeQueuedRepeats(const XKeyEvent& event) {
+    // Auto-repeat with detectable repeat on is a run of presses with no
+    // release between them. Presses for the key are taken from the queue
+    // until a release for it is passed, so a fresh press after letting go
+    // still runs on its own. After a release, only presses stamped no
+    // later than it are taken: those are repeats that lost the race.
+    struct Match {
+        KeyCode keycode;
+        unsigned int modifiers;
+        Time not_after;
+        bool released;
+    } match{static_cast<KeyCode>(event.keycode), event.state & BIND_MODIFIERS,
+            event.type == KeyRelease ? event.time : CurrentTime, false};
+    
+    auto predicate = [](Display*, XEvent* ev, XPointer arg) -> Bool {
+        auto* m = reinterpret_cast<Match*>(arg);
+        if (m->released || (ev->type != KeyPress && ev->type != KeyRelease)
+                || ev->xkey.keycode != m->keycode) {
+            return False;
+        }
+        if (ev->type == KeyRelease) {
+            m->released = true;
+            return False;
+        }
+        return (ev->xkey.state & BIND_MODIFIERS) == m->modifiers
+            && (m->not_after == CurrentTime || ev->xkey.time <= m->not_after);
+    };
     
-    if (command == "killactive") {
-        wm->killActiveWindow();
-        
-    } else if (command == "fullscreen") {
-        wm->toggleFullscreen();
-        
-    } else if (command == "togglefloating") {
-        wm->toggleFloating();
-        
-    } else if (command == "reload") {
-        wm->reloadConfig();
-        
-    } else if (command == "exit") {
-        wm->exit();
-        
-    } else if (command == "workspace") {
-        
-        int ws;
-        iss >> ws;
-        wm->switchWorkspace(ws);
-        
-    } else if (command == "movetoworkspace") {
-        int ws;
-        iss >> ws;
-        wm->moveWindowToWorkspace(ws, true);  
-    
-    } else if (command == "movetoworkspacesilent") {
-        int ws;
-        iss >> ws;
-        wm->moveWindowToWorkspace(ws, false);  
-        
-    } else if (command == "workspacenext") {
-        
-        
-        wm->switchWorkspace(wm->getCurrentWorkspace() + 1);
-        
-    } else if (command == "workspaceprev") {
-        
-        
-        
-        int current = wm->getCurrentWorkspace();
-        if (current >= 0) {
-            wm->switchWorkspace(current);
+    int taken = 0;
+    XEvent repeat;
+    for (;;) {
+        match.released = false;
+        if (!XCheckIfEvent(event.display, &repeat, predicate, reinterpret_cast<XPointer>(&match))) {
+            break;
         }
-        
-    } else if (command == "layout") {
-        
-        std::string layout_type;
-        iss >> layout_type;
-        wm->setLayout(layout_type);
-        
-    } else if (command == "cyclenext") {
-        
-        wm->cycleLayoutNext();
-        
-    } else if (command == "cycleprev") {
-        
-        wm->cycleLayoutPrev();
-        
-    } else if (command == "focusleft") {
-        wm->moveFocus("left");
-        
-    } else if (command == "focusright") {
-        wm->moveFocus("right");
-        
-    } else if (command == "focusup") {
-        wm->moveFocus("up");
-        
-    } else if (command == "focusdown") {
-        wm->moveFocus("down");
-        
-    } else if (command == "swapleft") {
-        wm->swapFocusedWindow("left");
-        
-    } else if (command == "swapright") {
-        wm->swapFocusedWindow("right");
-        
-    } else if (command == "swapup") {
-        wm->swapFocusedWindow("up");
-        
-    } else if (command == "swapdown") {
-        wm->swapFocusedWindow("down");
-        
-    } else if (command == "resizeleft") {
-        wm->resizeFocusedWindow("left");
-        
-    } else if (command == "resizeright") {
-        wm->resizeFocusedWindow("right");
-        
-    } else if (command == "resizeup") {
-        wm->resizeFocusedWindow("up");
-        
-    } else if (command == "resizedown") {
-        wm->resizeFocusedWindow("down");
-        
-    } else if (command == "togglesplit") {
-        wm->toggleSplitDirection();
-        
-    } else if (command == "scratchpad_show") {
-        
-        wm->showScratchpad();
-        
-    } else if (command == "scratchpad_show_next") {
-        
-        wm->showScratchpadNext();
-        
-    } else if (command == "scratchpad_show_prev") {
-        
-        wm->showScratchpadPrevious();
-        
-    } else if (command == "scratchpad_hide") {
-        
-        wm->hideToScratchpad();
-        
-    } else {
-        std::cerr << "Unknown action: " << action << std::endl;
+        ++taken;
     }
+    return taken;
 }
 
-void KeybindManager::executeCommand(const std::string& command) {
-    
-    pid_t pid = fork();
-    
-    if (pid == -1) {
-        std::cerr << "Failed to fork process for command: " << command << std::endl;
-        perror("fork");
-        return;
+bool KeybindManager::executeAction(const std::string& action, WindowManager* wm) {
+    if (!executeAction(parseAction(action), wm)) {
+        std::cerr << "Unknown action: " << action << std::endl;
+        return false;
     }
-    
-    if (pid == 0) {
-        
-        
-        
-        if (setsid() == -1) {
-            perror("setsid");
-            std::exit(1);
-        }
-        
-        
-        for (int fd = 3; fd < 1024; ++fd) {
-            close(fd);
-        }
-        
-        
-        int devnull = open("/dev/null", O_RDWR);
-        if (devnull != -1) {
-            dup2(devnull, STDIN_FILENO);
-            dup2(devnull, STDOUT_FILENO);
-            dup2(devnull, STDERR_FILENO);
-            if (devnull > 2) {
-                close(devnull);
+    return true;
+}
+
+bool KeybindManager::executeAction(const Action& action, WindowManager* wm, int count) {
+    const std::string& direction = DIRECTION_NAMES[static_cast<size_t>(action.direction)];
+    
+    switch (action.op) {
+        case Op::Invalid:
+            return false;
+        case Op::KillActive:
+            wm->killActiveWindow();
+            break;
+        case Op::Fullscreen:
+            wm->toggleFullscreen();
+            break;
+        case Op::ToggleFloating:
+            wm->toggleFloating();
+            break;
+        case Op::Reload:
+            wm->reloadConfig();
+            break;
+        case Op::Exit:
+            wm->exit();
+            break;
+        case Op::Workspace:
+            wm->switchWorkspace(action.workspace);
+            break;
+        case Op::MoveToWorkspace:
+            wm->moveWindowToWorkspace(action.workspace, true);
+            break;
+        case Op::MoveToWorkspaceSilent:
+            wm->moveWindowToWorkspace(action.workspace, false);
+            break;
+        case Op::WorkspaceNext:
+            wm->switchWorkspace(wm->getCurrentWorkspace() + 1);
+            break;
+        case Op::WorkspacePrev: {
+            int current = wm->getCurrentWorkspace();
+            if (current >= 0) {
+                wm->switchWorkspace(current);
             }
+            break;
         }
-        
-        
-        execl("/bin/sh", "sh", "-c", command.c_str(), nullptr);
-        
-        
-        perror("execl");
-        std::exit(1);
+        case Op::Layout:
+            wm->setLayout(action.argument);
+            break;
+        case Op::CycleNext:
+            wm->cycleLayoutNext();
+            break;
+        case Op::CyclePrev:
+            wm->cycleLayoutPrev();
+            break;
+        case Op::Focus:
+            wm->moveFocus(direction);
+            break;
+        case Op::Swap:
+            wm->swapFocusedWindow(direction, count);
+            break;
+        case Op::Resize:
+            wm->resizeFocusedWindow(direction, count);
+            break;
+        case Op::ToggleSplit:
+            wm->toggleSplitDirection();
+            break;
+        case Op::ScratchpadShow:
+            wm->showScratchpad();
+            break;
+        case Op::ScratchpadShowNext:
+            wm->showScratchpadNext();
+            break;
+        case Op::ScratchpadShowPrev:
+            wm->showScratchpadPrevious();
+            break;
+        case Op::ScratchpadHide:
+            wm->hideToScratchpad();
+            break;
+        case Op::Exec:
+            if (wm->execCommand(action.argument) == -1) {
+                std::cerr << "Failed to spawn process for command: " << action.argument
+                          << ": " << std::strerror(errno) << std::endl;
+            }
+            break;
     }
-    
-    
+    return true;
 }
 
 } 
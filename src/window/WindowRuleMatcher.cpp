@@ -0,0 +1,225 @@
+#include "pointblank/window/WindowRuleMatcher.hpp"
+#include <algorithm>
+
+namespace pblank {
+
+namespace {
+
+/** @brief Longest run of the glob without wildcards; every match contains it */
+std::string_view longestLiteral(std::string_view pattern) {
+    std::string_view best;
+    size_t start = 0;
+    while (start <= pattern.size()) {
+        size_t end = pattern.find_first_of("*?", start);
+        if (end == std::string_view::npos) end = pattern.size();
+        if (end - start > best.size()) {
+            best = pattern.substr(start, end - start);
+        }
+        start = end + 1;
+    }
+    return best;
+}
+
+void assign(WindowRuleDecision& into, std::string_view name, const bytecode::Value& value) {
+    using Type = bytecode::Value::Type;
+    if ((name == "floating" || name == "float") && value.type == Type::Boolean) {
+        into.floating = value.b;
+    } else if (name == "workspace" && value.type == Type::Int && value.i > 0) {
+        into.workspace = value.i;
+    } else if (name == "opacity" && value.type == Type::Double) {
+        into.opacity = value.d;
+    } else if (name == "opacity" && value.type == Type::Int) {
+        into.opacity = static_cast<double>(value.i);
+    } else if (name == "border_width" && value.type == Type::Int && value.i >= 0) {
+        into.border_width = value.i;
+    }
+}
+
+void merge(WindowRuleDecision& into, const WindowRuleDecision& from) {
+    if (from.floating) into.floating = from.floating;
+    if (from.workspace) into.workspace = from.workspace;
+    if (from.opacity) into.opacity = from.opacity;
+    if (from.border_width) into.border_width = from.border_width;
+}
+
+}
+
+
+void WindowRuleMatcher::compile(const std::vector<Config::WindowRule>& rules) {
+    outcomes_.clear();
+    required_.clear();
+    by_class_.clear();
+    by_instance_.clear();
+    by_title_.clear();
+    globs_.clear();
+    unanchored_globs_.clear();
+    nodes_.assign(1, Node{});
+    programs_.clear();
+
+    for (const auto& rule : rules) {
+        uint8_t required = 0;
+        uint32_t id = static_cast<uint32_t>(outcomes_.size());
+
+        if (!rule.program.empty()) {
+            programs_.emplace_back(id, rule.program);
+            ++required;
+        }
+        if (!rule.window_class.empty()) {
+            by_class_[rule.window_class].push_back(id);
+            ++required;
+        }
+        if (!rule.instance.empty()) {
+            by_instance_[rule.instance].push_back(id);
+            ++required;
+        }
+        if (!rule.title.empty()) {
+            if (rule.title.find_first_of("*?") == std::string::npos) {
+                by_title_[rule.title].push_back(id);
+            } else {
+                uint32_t glob = static_cast<uint32_t>(globs_.size());
+                globs_.push_back({rule.title, id});
+                std::string_view literal = longestLiteral(rule.title);
+                if (literal.empty()) {
+                    unanchored_globs_.push_back(glob);
+                } else {
+                    addLiteral(literal, glob);
+                }
+            }
+            ++required;
+        }
+
+        outcomes_.push_back({rule.floating, rule.workspace, rule.opacity, rule.border_width});
+        required_.push_back(required);
+    }
+
+    buildFailLinks();
+}
+
+WindowRuleDecision WindowRuleMatcher::match(const bytecode::WindowProperties& window) const {
+    WindowRuleDecision decision;
+    if (outcomes_.empty()) {
+        return decision;
+    }
+
+
+    std::vector<uint32_t> hits;
+    auto lookup = [&hits](const Index& index, std::string_view key) {
+        if (key.empty()) return;
+        auto it = index.find(key);
+        if (it != index.end()) {
+            hits.insert(hits.end(), it->second.begin(), it->second.end());
+        }
+    };
+    lookup(by_class_, window.window_class);
+    lookup(by_instance_, window.instance);
+    lookup(by_title_, window.title);
+    std::string_view title = window.title;
+
+
+    if (!globs_.empty()) {
+        std::vector<bool> checked(globs_.size());
+        auto verify = [&](uint32_t glob) {
+            if (checked[glob]) return;
+            checked[glob] = true;
+            if (bytecode::globMatch(globs_[glob].pattern, title)) {
+                hits.push_back(globs_[glob].rule);
+            }
+        };
+
+        uint32_t state = 0;
+        for (char c : title) {
+            state = step(state, static_cast<unsigned char>(c));
+            for (uint32_t glob : nodes_[state].globs) {
+                verify(glob);
+            }
+        }
+        for (uint32_t glob : unanchored_globs_) {
+            verify(glob);
+        }
+    }
+
+
+    std::vector<std::pair<uint32_t, WindowRuleDecision>> computed;
+    for (const auto& [rule, program] : programs_) {
+        vm_.run(program, window);
+        if (vm_.assignments().empty()) continue;
+
+        WindowRuleDecision& outcome = computed.emplace_back(rule, WindowRuleDecision{}).second;
+        for (const auto& [name, value] : vm_.assignments()) {
+            assign(outcome, name, value);
+        }
+        hits.push_back(rule);
+    }
+
+
+    std::sort(hits.begin(), hits.end());
+    for (size_t i = 0; i < hits.size();) {
+        size_t j = i;
+        while (j < hits.size() && hits[j] == hits[i]) ++j;
+        if (j - i == required_[hits[i]]) {
+            auto it = std::lower_bound(computed.begin(), computed.end(), hits[i],
+                                       [](const auto& entry, uint32_t rule) { return entry.first < rule; });
+            merge(decision, it != computed.end() && it->first == hits[i] ? it->second : outcomes_[hits[i]]);
+        }
+        i = j;
+    }
+    return decision;
+}
+
+
+void WindowRuleMatcher::addLiteral(std::string_view literal, uint32_t glob) {
+    uint32_t state = 0;
+    for (char ch : literal) {
+        auto c = static_cast<unsigned char>(ch);
+        auto& edges = nodes_[state].edges;
+        auto it = std::lower_bound(edges.begin(), edges.end(), c,
+                                   [](const auto& edge, unsigned char key) { return edge.first < key; });
+        if (it != edges.end() && it->first == c) {
+            state = it->second;
+            continue;
+        }
+
+        uint32_t next = static_cast<uint32_t>(nodes_.size());
+        edges.insert(it, {c, next});
+        nodes_.emplace_back();
+        state = next;
+    }
+    nodes_[state].globs.push_back(glob);
+}
+
+void WindowRuleMatcher::buildFailLinks() {
+    std::vector<uint32_t> queue;
+    for (const auto& [c, child] : nodes_[0].edges) {
+        nodes_[child].fail = 0;
+        queue.push_back(child);
+    }
+
+    for (size_t head = 0; head < queue.size(); ++head) {
+        uint32_t node = queue[head];
+        for (const auto& [c, child] : nodes_[node].edges) {
+            uint32_t fail = step(nodes_[node].fail, c);
+            nodes_[child].fail = fail;
+
+            const auto& inherited = nodes_[fail].globs;
+            nodes_[child].globs.insert(nodes_[child].globs.end(), inherited.begin(), inherited.end());
+            queue.push_back(child);
+        }
+    }
+}
+
+uint32_t WindowRuleMatcher::step(uint32_t state, unsigned char c) const {
+    while (true) {
+        const auto& edges = nodes_[state].edges;
+        auto it = std::lower_bound(edges.begin(), edges.end(), c,
+                                   [](const auto& edge, unsigned char key) { return edge.first < key; });
+        if (it != edges.end() && it->first == c) {
+            return it->second;
+        }
+        if (state == 0) {
+            return 0;
+        }
+        state = nodes_[state].fail;
+    }
+}
+
+}